@@ -0,0 +1,159 @@
+#include "cache.h"
+#include <string.h>
+
+static const uint64_t PRIME1 = 11400714785074694791ull;
+static const uint64_t PRIME2 = 14029467366897019727ull;
+static const uint64_t PRIME3 = 1609587929392839161ull;
+static const uint64_t PRIME4 = 9650029242287828579ull;
+static const uint64_t PRIME5 = 2870177450012600261ull;
+
+static inline uint64_t rotl64(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+static inline uint64_t read64(const char* p) { uint64_t v; memcpy(&v, p, sizeof(v)); return v; }
+static inline uint32_t read32(const char* p) { uint32_t v; memcpy(&v, p, sizeof(v)); return v; }
+
+static inline uint64_t hash_round(uint64_t acc, uint64_t input) {
+    acc += input * PRIME2;
+    acc = rotl64(acc, 31);
+    return acc * PRIME1;
+}
+
+static inline uint64_t hash_merge(uint64_t h, uint64_t v) {
+    h ^= hash_round(0, v);
+    return h * PRIME1 + PRIME4;
+}
+
+uint64_t hash_bytes(const char* data, size_t len, uint64_t seed) {
+    const char* p = data;
+    const char* end = data + len;
+    uint64_t h;
+
+    if (len >= 32) {
+        uint64_t v1 = seed + PRIME1 + PRIME2;
+        uint64_t v2 = seed + PRIME2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME1;
+        do {
+            v1 = hash_round(v1, read64(p));
+            v2 = hash_round(v2, read64(p + 8));
+            v3 = hash_round(v3, read64(p + 16));
+            v4 = hash_round(v4, read64(p + 24));
+            p += 32;
+        } while (end - p >= 32);
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = hash_merge(h, v1);
+        h = hash_merge(h, v2);
+        h = hash_merge(h, v3);
+        h = hash_merge(h, v4);
+    }
+    else
+        h = seed + PRIME5;
+
+    h += len;
+    for (; end - p >= 8; p += 8) {
+        h ^= hash_round(0, read64(p));
+        h = rotl64(h, 27) * PRIME1 + PRIME4;
+    }
+    if (end - p >= 4) {
+        h ^= read32(p) * PRIME1;
+        h = rotl64(h, 23) * PRIME2 + PRIME3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= static_cast<unsigned char>(*p) * PRIME5;
+        h = rotl64(h, 11) * PRIME1;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+/*估算一棵树占用的内存, 包括 make_shared 的控制块和容器的额外开销*/
+static size_t tree_bytes(const Value& value) {
+    size_t bytes = sizeof(Value) + 2 * sizeof(void *);
+    switch (value.get_type()) {
+        case STRING_VALUE:
+            bytes += value.get_string().capacity();
+            break;
+        case ARRAY_VALUE:
+            bytes += value.get_array().capacity() * sizeof(Value::ValuePtr);
+            for (auto& e : value.get_array())
+                bytes += tree_bytes(*e);
+            break;
+        case OBJECT_VALUE:
+            bytes += value.get_object().bucket_count() * sizeof(void *);
+            for (auto& m : value.get_object())
+                bytes += sizeof(m) + 2 * sizeof(void *) + m.first.capacity() + tree_bytes(*m.second);
+            break;
+        default:
+            break;
+    }
+    return bytes;
+}
+
+ParseCache::ParseCache(size_t max_entries, size_t max_bytes)
+    : max_entries_(max_entries), max_bytes_(max_bytes) {
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+bool ParseCache::lookup(const char* text, size_t len, uint64_t hash, uint64_t seed, Value::ConstValuePtr& value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(hash);
+    if (it == index_.end() || it->second->seed != seed || it->second->text.size() != len ||
+        memcmp(it->second->text.data(), text, len) != 0) {
+        stats_.misses++;
+        return false;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    value = it->second->value;
+    stats_.hits++;
+    return true;
+}
+
+void ParseCache::insert(const char* text, size_t len, uint64_t hash, uint64_t seed, Value::ConstValuePtr value) {
+    size_t bytes = sizeof(Entry) + len + tree_bytes(*value);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (bytes > max_bytes_ || max_entries_ == 0)
+        return;
+    auto it = index_.find(hash);
+    if (it != index_.end()) {
+        /*同一个哈希只保留最新的一份*/
+        stats_.bytes -= it->second->bytes;
+        stats_.entries--;
+        lru_.erase(it->second);
+        index_.erase(it);
+    }
+    lru_.push_front(Entry{ hash, seed, std::string(text, len), std::move(value), bytes });
+    index_[hash] = lru_.begin();
+    stats_.bytes += bytes;
+    stats_.entries++;
+    evict_locked();
+}
+
+/*从最久未使用的一端淘汰, 直到满足条数和内存上限*/
+void ParseCache::evict_locked() {
+    while (stats_.entries > max_entries_ || stats_.bytes > max_bytes_) {
+        Entry& last = lru_.back();
+        index_.erase(last.hash);
+        stats_.bytes -= last.bytes;
+        stats_.entries--;
+        stats_.evictions++;
+        lru_.pop_back();
+    }
+}
+
+void ParseCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    lru_.clear();
+    index_.clear();
+    stats_.entries = 0;
+    stats_.bytes = 0;
+}
+
+ParseCacheStats ParseCache::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
@@ -0,0 +1,67 @@
+#ifndef __CACHE_H__
+#define __CACHE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "value.h"
+
+#define PARSE_CACHE_MAX_ENTRIES 1024            /*默认最多缓存的文档数*/
+#define PARSE_CACHE_MAX_BYTES   (64 << 20)      /*默认内存上限(输入文本 + 估算的树大小)*/
+
+/**
+ * 64 位非加密哈希(XXH64 算法)
+ * 4 路独立累加, 每轮处理 32 字节, 编译器可以流水/向量化
+*/
+uint64_t hash_bytes(const char* data, size_t len, uint64_t seed = 0);
+
+struct ParseCacheStats {
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+    size_t entries;
+    size_t bytes;
+};
+
+/**
+ * 解析结果缓存, 按输入文本的哈希查找, LRU 淘汰
+ * 只有解析成 DocumentPtr 的 Json::parse 使用缓存: 命中时新文档直接共享缓存里的树, 不复制
+ * 文档只提供 ValueView, 没有调用者能修改缓存的树; 解析成 Value::ValuePtr 的 parse 不查也不写缓存
+ * 可以被多个 Json 和多个线程共用
+*/
+class ParseCache {
+public:
+    explicit ParseCache(size_t max_entries = PARSE_CACHE_MAX_ENTRIES, size_t max_bytes = PARSE_CACHE_MAX_BYTES);
+    ParseCache(const ParseCache&) = delete;
+    ParseCache& operator=(const ParseCache&) = delete;
+
+    /*seed 区分会影响解析结果的选项, 相同文本不同选项视为不同的键*/
+    bool lookup(const char* text, size_t len, uint64_t hash, uint64_t seed, Value::ConstValuePtr& value);
+    void insert(const char* text, size_t len, uint64_t hash, uint64_t seed, Value::ConstValuePtr value);
+    void clear();
+    ParseCacheStats get_stats() const;
+
+private:
+    struct Entry {
+        uint64_t hash;
+        uint64_t seed;
+        std::string text;       /*命中时逐字节确认, 哈希冲突不会返回错误的文档*/
+        Value::ConstValuePtr value;
+        size_t bytes;
+    };
+    typedef std::list<Entry> List;
+
+    void evict_locked();
+
+    mutable std::mutex mutex_;
+    List lru_;                  /*表头是最近使用的*/
+    std::unordered_map<uint64_t, List::iterator> index_;
+    size_t max_entries_;
+    size_t max_bytes_;
+    ParseCacheStats stats_;
+};
+
+#endif // !__CACHE_H__
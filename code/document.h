@@ -0,0 +1,99 @@
+#ifndef __DOCUMENT_H__
+#define __DOCUMENT_H__
+
+#include <atomic>
+#include <memory>
+#include "value.h"
+
+/**
+ * 只读视图
+ * 只提供 const 访问, 子节点也以 ValueView 返回, 拿不到可修改的 Value
+ * 视图不持有节点, 使用期间需要持有所属的 DocumentPtr
+*/
+class ValueView {
+public:
+    ValueView() : v_(nullptr) {}
+    explicit ValueView(const Value* v) : v_(v) {}
+
+    bool valid() const { return v_ != nullptr; }        /*find/at 找不到时返回无效视图*/
+    value_type get_type() const { assert(v_); return v_->get_type(); }
+    bool get_boolean() const { assert(v_); return v_->get_boolean(); }
+    double get_number() const { assert(v_); return v_->get_number(); }
+    const std::string& get_string() const { assert(v_); return v_->get_string(); }
+
+    /*数组或对象的元素个数*/
+    size_t size() const {
+        assert(v_);
+        return v_->get_type() == ARRAY_VALUE ? v_->get_array().size() : v_->get_object().size();
+    }
+    ValueView at(size_t index) const {
+        assert(v_);
+        const std::vector<Value::ValuePtr>& a = v_->get_array();
+        return index < a.size() ? ValueView(a[index].get()) : ValueView();
+    }
+    ValueView find(const std::string& key) const {
+        assert(v_);
+        const std::unordered_map<std::string, Value::ValuePtr>& o = v_->get_object();
+        auto it = o.find(key);
+        return it != o.end() ? ValueView(it->second.get()) : ValueView();
+    }
+    /*按存储顺序遍历对象成员, f(const std::string& key, ValueView value)*/
+    template <typename F>
+    void for_each_member(F f) const {
+        assert(v_);
+        for (auto& m : v_->get_object())
+            f(m.first, ValueView(m.second.get()));
+    }
+
+private:
+    const Value* v_;
+};
+
+/**
+ * 冻结的文档
+ * 构造后整棵树不再修改, 多个线程可以不加锁同时读取:
+ * 只会调用标准容器的 const 成员函数, 标准库保证它们可以并发执行
+ * 构造时接管 root, 调用者不能再通过其它 ValuePtr 修改这棵树
+ * root 也可以是 ParseCache 里的只读树, 文档和缓存共享它, 不用复制
+*/
+class Document {
+public:
+    explicit Document(Value::ConstValuePtr root) : root_(std::move(root)) { assert(root_); }
+    Document(const Document&) = delete;
+    Document& operator=(const Document&) = delete;
+
+    ValueView root() const { return ValueView(root_.get()); }
+
+private:
+    const Value::ConstValuePtr root_;
+};
+
+typedef std::shared_ptr<const Document> DocumentPtr;
+
+inline DocumentPtr freeze(Value::ConstValuePtr root) {
+    return std::make_shared<const Document>(std::move(root));
+}
+
+/**
+ * RCU 风格的当前文档
+ * 读者 load() 得到一个快照, 之后一直读这份快照, 不需要其它同步;
+ * 重新加载时在锁外解析、冻结新文档, 再用 store() 原子替换
+ * 旧文档在最后一个读者放开快照后才释放
+ * load/store 只在复制 shared_ptr 的一瞬间同步, 读者不会等待解析或构造
+*/
+class DocumentSlot {
+public:
+    DocumentSlot() {}
+    explicit DocumentSlot(DocumentPtr doc) : current_(std::move(doc)) {}
+    DocumentSlot(const DocumentSlot&) = delete;
+    DocumentSlot& operator=(const DocumentSlot&) = delete;
+
+    DocumentPtr load() const { return std::atomic_load(&current_); }
+    void store(DocumentPtr doc) { std::atomic_store(&current_, std::move(doc)); }
+    DocumentPtr exchange(DocumentPtr doc) { return std::atomic_exchange(&current_, std::move(doc)); }
+
+private:
+    DocumentPtr current_;
+};
+
+#endif // !__DOCUMENT_H__
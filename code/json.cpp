@@ -1,4 +1,9 @@
 #include "json.h"
+#include "utf8.h"
+#include "cache.h"
+#ifdef JSON_ENABLE_STATS
+#include <chrono>
+#endif
 
 /****************************************************************
  * 解析json字符串对象
@@ -38,9 +43,13 @@ int Json::parse_number() {
         for (p++; is_digit(*p); p++);
     }
 
+    char* end;
     errno = 0;
-    double num = strtod(json_, nullptr);
-    if (errno == ERANGE && (num == HUGE_VAL || num == -HUGE_VAL)) {
+    double num = strtod(json_, &end);
+    /*strtod 会越过语法继续读(如 "01e309"), 这时语法上的数字只能是 0 或 -0*/
+    if (end != p)
+        num = *json_ == '-' ? -0.0 : 0.0;
+    else if (errno == ERANGE && (num == HUGE_VAL || num == -HUGE_VAL)) {
         value_->set_null();
         return PARSE_NUMBER_TOO_BIG;
     }
@@ -52,19 +61,26 @@ int Json::parse_number() {
 int Json::parse_string() {
     int ret;
     std::string str;
-    if ((ret = parse_string_raw(str)) == PARSE_OK)
-        value_->set_string(str.data());
+    if ((ret = parse_string_raw(str)) == PARSE_OK) {
+        value_->set_string(str.data(), str.size());
+        JSON_STATS(stats_.alloc_count++; stats_.alloc_bytes += str.size() + 1);
+    }
     return ret;
 }
 
 int Json::parse_string_raw(std::string& str) {
     json_++;
     unsigned u, u2;
+#ifdef JSON_ENABLE_STATS
+    const char* begin = json_;
+#endif
 
     while(true) {
         char ch = *json_++;
         switch(ch) {
             case '\"':
+                /*转义序列总比解码结果长, 长度不等说明有转义*/
+                JSON_STATS(if (str.size() != static_cast<size_t>(json_ - begin - 1)) stats_.escaped_strings++);
                 return  PARSE_OK;
             
             case '\\':
@@ -101,11 +117,18 @@ int Json::parse_string_raw(std::string& str) {
             case '\0':
                 return PARSE_MISS_QUOTATION_MARK;
             
-            default:
+            default: {
                 if (static_cast<unsigned char>(ch) < 0x20) {
                     return PARSE_INVALID_STRING_CHAR;
                 }
-                str += ch;
+                /*连续的普通字符整段追加*/
+                const char* run = json_ - 1;
+                while (*json_ != '\"' && *json_ != '\\' && static_cast<unsigned char>(*json_) >= 0x20)
+                    json_++;
+                if ((flags_ & PARSE_VALIDATE_UTF8) && !validate_utf8(run, json_ - run))
+                    return PARSE_INVALID_UTF8;
+                str.append(run, json_ - run);
+            }
         }
     }
 }
@@ -160,6 +183,7 @@ int Json::parse_array() {
     Value::ValuePtr tmp = value_;
     while (true) {
         value_ = std::make_shared<Value>();
+        JSON_STATS(stats_.alloc_count++; stats_.alloc_bytes += sizeof(Value));
         if ((ret = parse_value()) != PARSE_OK) break;
         v.push_back(value_);
 
@@ -199,6 +223,7 @@ int Json::parse_object() {
     Value::ValuePtr tmp = value_;
     while (true) {
         value_ = std::make_shared<Value>();
+        JSON_STATS(stats_.alloc_count++; stats_.alloc_bytes += sizeof(Value));
         /*解析key, 先判断在解析*/
         if (*json_ != '"') {
             ret = PARSE_MISS_KEY;
@@ -239,7 +264,31 @@ int Json::parse_object() {
     return ret;
 }
 
+/**
+ * 解析一个值, 并检查嵌套深度(根为第 1 层)
+ * 开启统计时记录最深层数和各类型耗时
+*/
 int Json::parse_value() {
+    int ret;
+#ifdef JSON_ENABLE_STATS
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if (depth_ + 1 > stats_.max_depth)
+        stats_.max_depth = depth_ + 1;
+#endif
+    if (++depth_ > max_depth_)
+        ret = PARSE_DEPTH_EXCEEDED;
+    else
+        ret = dispatch_value();
+    depth_--;
+#ifdef JSON_ENABLE_STATS
+    if (ret == PARSE_OK)
+        stats_.type_ns[value_->get_type()] += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+#endif
+    return ret;
+}
+
+int Json::dispatch_value() {
     const char* p = json_;
 
     switch (*p) {
@@ -269,88 +318,120 @@ int Json::parse_value() {
     }
 }
 
-int Json::parse(const char* json, Value::ValuePtr& value) {
+/**
+ * 把整个输入解析到 value_
+*/
+int Json::parse_root(const char* json, unsigned flags) {
     json_ = json;
+    flags_ = flags;
     value_->set_null();
+    depth_ = 0;
+#ifdef JSON_ENABLE_STATS
+    stats_.reset();
+#endif
 
-    value = value_;
     int ret;
     parse_whitespace();
     if ((ret = parse_value()) == PARSE_OK) {    //解析成功
         parse_whitespace();
         if (*json_ != '\0') { //解析成功但不是末尾
-            value->set_null();
+            value_->set_null();
             return PARSE_ROOT_NOT_SINGULAR;
         }
     }
     return ret; //解析失败或解析到末尾
 }
 
+/**
+ * 开启缓存时先按输入查找, 影响解析结果的选项也作为键的一部分
+ * 命中时 cached 是缓存里的只读树
+*/
+bool Json::lookup_cache(const char* json, unsigned flags, CacheKey& key, Value::ConstValuePtr& cached) {
+    if (!cache_)
+        return false;
+#ifdef JSON_ENABLE_STATS
+    stats_.reset();
+#endif
+    key.len = strlen(json);
+    key.seed = flags ^ (static_cast<uint64_t>(max_depth_) << 32);
+    key.hash = hash_bytes(json, key.len, key.seed);
+    return cache_->lookup(json, key.len, key.hash, key.seed, cached);
+}
 
-/****************************************************************
- * json对象字符串化
- * *************************************************************/
-void Json::stringify_string(Value::ValuePtr& value, std::string& str) {
-    static const char hex_digits[] = "0123456789ABCDEF";
-    str += '"';
-    std::string& s = value->get_string();
-    for (auto c : s) {
-        switch (c) {
-            case '\"': str += "\\\""; break;
-            case '\\': str += "\\"; break;
-            case '\b': str += "\\b"; break;
-            case '\f': str += "\\f"; break;
-            case '\n': str += "\\n"; break;
-            case '\r': str += "\\r"; break;
-            case '\t': str += "\\t"; break;
-            default:
-                if (c < 0x20) {
-                    str += "\\u00";
-                    str += hex_digits[c >> 4];//取高四位值
-                    str += hex_digits[c & 15];//取低四位
-                }
-                else str += c;
-        }
+/**
+ * 解析成可以修改的树, 不经过缓存: 缓存的树只能共享给只读的 Document
+*/
+int Json::parse(const char* json, Value::ValuePtr& value, unsigned flags) {
+    value = value_;
+    return parse_root(json, flags);
+}
+
+/**
+ * 解析并冻结成只读文档, 文档接管这棵树, Json 之后改用新的根节点
+ * 文档本身只读, 命中缓存时直接共享缓存里的树, 未命中时冻结的树也直接放进缓存
+*/
+int Json::parse(const char* json, DocumentPtr& doc, unsigned flags) {
+    CacheKey key;
+    Value::ConstValuePtr cached;
+    if (lookup_cache(json, flags, key, cached)) {
+        doc = freeze(std::move(cached));
+        return PARSE_OK;
     }
-    str += '"';
+
+    int ret;
+    if ((ret = parse_root(json, flags)) == PARSE_OK) {
+        Value::ConstValuePtr root = std::move(value_);
+        value_ = std::make_shared<Value>();
+        if (cache_)
+            cache_->insert(json, key.len, key.hash, key.seed, root);
+        doc = freeze(std::move(root));
+    }
+    return ret;
 }
 
-void Json::stringify_value(Value::ValuePtr& value, std::string& str, size_t level) {
+/****************************************************************
+ * json对象字符串化
+ * *************************************************************/
+void Json::stringify_value(const Value::ValuePtr& value, Writer& writer) {
     switch(value->get_type()) {
-        case NULL_VALUE:    str += "null"; break;
-        case TRUE_VALUE:    str += "true"; break;
-        case FALSE_VALUE:   str += "false"; break;
-        case NUMBER_VALUE:  str += std::to_string(value->get_number()); break;
-        case STRING_VALUE:  stringify_string(value, str); break;
+        case NULL_VALUE:    writer.null(); break;
+        case TRUE_VALUE:    writer.boolean(true); break;
+        case FALSE_VALUE:   writer.boolean(false); break;
+        case NUMBER_VALUE:  writer.number(value->get_number()); break;
+        case STRING_VALUE:  writer.string(value->get_string()); break;
         case ARRAY_VALUE:   { 
-            str += "[ ";
-            auto& array = value->get_array();
-            for (size_t i = 0; i < array.size(); ++i) {
-                if (i) str += ", "; 
-                stringify(array[i], str);
-            }
-            str += " ]";
+            writer.start_array();
+            for (auto& e : value->get_array())
+                stringify_value(e, writer);
+            writer.end_array();
             break;
         }
         case OBJECT_VALUE:    {
-            for (int i = level; i > 0; --i) str += '\t';
-            str += "{ \n";
-            auto& obj = value->get_object();
-            for (auto o = obj.begin(); o != obj.end(); ++o) {
-                if (o != obj.begin()) str += ",\n";
-                for (int i = level; i >= 0; --i) str += '\t';
-                str += ("\"" + o->first + "\" : ");
-                stringify_value(o->second, str, level + 1);
+            writer.start_object();
+            for (auto& m : value->get_object()) {
+                writer.key(m.first);
+                stringify_value(m.second, writer);
             }
-            str += '\n';
-            for (int i = level; i > 0; --i) str += '\t';
-            str += "}";
+            writer.end_object();
             break;
         }
         default: assert(0 && "Invalid type");
     }
 }
 
-inline void Json::stringify(Value::ValuePtr& value, std::string& str) {
-    stringify_value(value, str, 0);
-}
\ No newline at end of file
+/**
+ * 字符串化到任意输出端, 不生成中间字符串
+*/
+void Json::stringify(Value::ValuePtr& value, Sink& sink, const StringifyOptions& options) {
+    Writer writer(sink, options);
+    stringify_value(value, writer);
+    writer.flush();
+}
+
+/**
+ * 以紧凑格式追加到 str
+*/
+void Json::stringify(Value::ValuePtr& value, std::string& str) {
+    StringSink sink(str);
+    stringify(value, sink);
+}
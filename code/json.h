@@ -2,8 +2,12 @@
 #define __JSON_H__
 
 #include "value.h"
+#include "writer.h"
+#include "document.h"
 #include <errno.h>
 #include <math.h>
+#include <stdint.h>
+#include <string.h>
 
 
 /**
@@ -28,16 +32,58 @@ enum {
     PARSE_MISS_KEY,                     /*缺少键*/
     PARSE_MISS_COLON,                   /*缺少冒号*/
     PARSE_MISS_COMMA_OR_CURLY_BRACKET,  /*缺少圆括号*/
+
+    PARSE_DEPTH_EXCEEDED,               /*嵌套层数超过上限*/
+    PARSE_INVALID_UTF8,                 /*字符串不是合法的 UTF-8*/
+};
+
+/**
+ * 解析选项, 可按位组合后传给 parse
+*/
+enum {
+    PARSE_VALIDATE_UTF8 = 1 << 0,       /*校验字符串是否为合法的 UTF-8*/
 };
 
+#define PARSE_MAX_DEPTH 512             /*默认最大嵌套层数*/
+
+/**
+ * 单次解析的统计信息, 只有定义了 JSON_ENABLE_STATS 才会统计
+*/
+struct ParseStats {
+    size_t alloc_count;         /*make_shared 及字符串分配次数*/
+    size_t alloc_bytes;         /*分配的字节数(不含 shared_ptr 控制块)*/
+    size_t max_depth;           /*最深嵌套层数*/
+    size_t escaped_strings;     /*包含转义的字符串个数*/
+    uint64_t type_ns[7];        /*按 value_type 统计的解析耗时(纳秒, 包含子节点)*/
+
+    void reset() { memset(this, 0, sizeof(*this)); }
+};
+
+#ifdef JSON_ENABLE_STATS
+#define JSON_STATS(stmt) do { stmt; } while (0)
+#else
+#define JSON_STATS(stmt) do { } while (0)
+#endif
+
+class ParseCache;
+
 class Json {
 public:
-    Json() : value_(std::make_shared<Value>()) {}
-    int parse(const char* json, Value::ValuePtr& value);
+    Json() : value_(std::make_shared<Value>()), flags_(0), depth_(0), max_depth_(PARSE_MAX_DEPTH), cache_(nullptr) {}
+    int parse(const char* json, Value::ValuePtr& value, unsigned flags = 0);
+    int parse(const char* json, DocumentPtr& doc, unsigned flags = 0);     /*解析并冻结*/
     void stringify(Value::ValuePtr& value, std::string& str);
+    void stringify(Value::ValuePtr& value, Sink& sink, const StringifyOptions& options = StringifyOptions());
+    void set_max_depth(size_t depth) { max_depth_ = depth; }
+    size_t get_max_depth() const { return max_depth_; }
+    void set_cache(ParseCache* cache) { cache_ = cache; }   /*只用于解析成 DocumentPtr, nullptr 关闭缓存, 见 cache.h*/
+#ifdef JSON_ENABLE_STATS
+    const ParseStats& get_stats() const { return stats_; }  /*最近一次 parse 的统计*/
+#endif
 
 private:
     int parse_value();
+    int dispatch_value();
     void parse_whitespace();
     int parse_literial(std::string literal, value_type type);
     int parse_number();
@@ -51,12 +97,27 @@ private:
     bool is_digit(char ch) { return ch >= '0' && ch <= '9'; }
     bool is_digit_1to9(char ch) { return ch >= '1' && ch <= '9'; }
 
-    void stringify_string(Value::ValuePtr& value, std::string& str);
-    void stringify_value(Value::ValuePtr& value, std::string& str, size_t level);
+    void stringify_value(const Value::ValuePtr& value, Writer& writer);
+
+    /*缓存的键: 输入长度、哈希和影响解析结果的选项*/
+    struct CacheKey {
+        size_t len;
+        uint64_t hash;
+        uint64_t seed;
+    };
+    int parse_root(const char* json, unsigned flags);
+    bool lookup_cache(const char* json, unsigned flags, CacheKey& key, Value::ConstValuePtr& cached);
 
 private:
     const char* json_;
     Value::ValuePtr value_;
+    unsigned flags_;        /*本次 parse 的选项*/
+    size_t depth_;          /*当前嵌套层数*/
+    size_t max_depth_;
+    ParseCache* cache_;
+#ifdef JSON_ENABLE_STATS
+    ParseStats stats_;
+#endif
 };
 
 #endif // !__JSON_H__
\ No newline at end of file
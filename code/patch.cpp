@@ -0,0 +1,507 @@
+#include "patch.h"
+#include <algorithm>
+
+typedef Value::ValuePtr ValuePtr;
+typedef std::vector<ValuePtr> Array;
+typedef std::unordered_map<std::string, ValuePtr> Object;
+
+bool equal_value(const ValuePtr& a, const ValuePtr& b) {
+    if (a == b) return true;
+    if (a->get_type() != b->get_type()) return false;
+    switch (a->get_type()) {
+        case NUMBER_VALUE:
+            return a->get_number() == b->get_number();
+        case STRING_VALUE:
+            return a->get_string() == b->get_string();
+        case ARRAY_VALUE: {
+            Array& x = a->get_array();
+            Array& y = b->get_array();
+            if (x.size() != y.size()) return false;
+            for (size_t i = 0; i < x.size(); ++i)
+                if (!equal_value(x[i], y[i])) return false;
+            return true;
+        }
+        case OBJECT_VALUE: {
+            Object& x = a->get_object();
+            Object& y = b->get_object();
+            if (x.size() != y.size()) return false;
+            for (auto& member : x) {
+                auto it = y.find(member.first);
+                if (it == y.end() || !equal_value(member.second, it->second)) return false;
+            }
+            return true;
+        }
+        default:
+            return true;
+    }
+}
+
+ValuePtr clone_value(const Value& value) {
+    ValuePtr copy = std::make_shared<Value>();
+    switch (value.get_type()) {
+        case NUMBER_VALUE:
+            copy->set_number(value.get_number());
+            break;
+        case STRING_VALUE:
+            copy->set_string(value.get_string().data(), value.get_string().size());
+            break;
+        case ARRAY_VALUE: {
+            Array elements;
+            elements.reserve(value.get_array().size());
+            for (auto& e : value.get_array())
+                elements.push_back(clone_value(e));
+            Array empty;
+            copy->set_array(empty);
+            copy->get_array().swap(elements);
+            break;
+        }
+        case OBJECT_VALUE: {
+            Object members;
+            members.reserve(value.get_object().size());
+            for (auto& m : value.get_object())
+                members.emplace(m.first, clone_value(m.second));
+            Object empty;
+            copy->set_object(empty);
+            copy->get_object().swap(members);
+            break;
+        }
+        default:
+            copy->set_type(value.get_type());
+            break;
+    }
+    return copy;
+}
+
+ValuePtr clone_value(const ValuePtr& value) {
+    return clone_value(*value);
+}
+
+/****************************************************************
+ * JSON Pointer (RFC 6901)
+ * *************************************************************/
+
+static int parse_pointer(const std::string& pointer, std::vector<std::string>& tokens) {
+    tokens.clear();
+    if (pointer.empty()) return PATCH_OK;
+    if (pointer[0] != '/') return PATCH_INVALID_POINTER;
+    std::string token;
+    for (size_t i = 1; i <= pointer.size(); ++i) {
+        if (i == pointer.size() || pointer[i] == '/') {
+            tokens.push_back(token);
+            token.clear();
+        }
+        else if (pointer[i] == '~') {
+            if (i + 1 < pointer.size() && pointer[i + 1] == '0') token += '~';
+            else if (i + 1 < pointer.size() && pointer[i + 1] == '1') token += '/';
+            else return PATCH_INVALID_POINTER;
+            i++;
+        }
+        else
+            token += pointer[i];
+    }
+    return PATCH_OK;
+}
+
+/*数组下标: "0" 或不以 0 开头的十进制数*/
+static bool parse_index(const std::string& token, size_t* index) {
+    if (token.empty() || token.size() > 15 || (token.size() > 1 && token[0] == '0'))
+        return false;
+    size_t n = 0;
+    for (char ch : token) {
+        if (ch < '0' || ch > '9') return false;
+        n = n * 10 + (ch - '0');
+    }
+    *index = n;
+    return true;
+}
+
+static void append_token(std::string& path, const std::string& key) {
+    path += '/';
+    for (char ch : key) {
+        if (ch == '~') path += "~0";
+        else if (ch == '/') path += "~1";
+        else path += ch;
+    }
+}
+
+/****************************************************************
+ * 应用补丁
+ * 每次修改都记录一条撤销记录, 失败时倒序撤销
+ * *************************************************************/
+namespace {
+
+class Patcher {
+public:
+    explicit Patcher(ValuePtr& doc) : doc_(doc) {}
+    int apply(const ValuePtr& op);
+    void rollback();
+
+private:
+    int locate(const std::string& path, ValuePtr& parent, std::string& last);
+    int get(const std::string& path, ValuePtr& out);
+    int add(const std::string& path, const ValuePtr& value);
+    int remove(const std::string& path, ValuePtr* removed);
+    int replace(const std::string& path, const ValuePtr& value);
+
+    struct Undo {
+        enum { ROOT, OBJECT_RESTORE, OBJECT_ERASE, ARRAY_INSERT, ARRAY_ERASE, ARRAY_SET } kind;
+        ValuePtr parent;
+        std::string key;
+        size_t index;
+        ValuePtr old;
+    };
+    void record(int kind, const ValuePtr& parent, const std::string& key, size_t index, const ValuePtr& old) {
+        undo_.push_back(Undo{ static_cast<decltype(Undo::kind)>(kind), parent, key, index, old });
+    }
+
+    ValuePtr& doc_;
+    std::vector<Undo> undo_;
+    std::vector<std::string> tokens_;
+};
+
+/*找到 path 的父节点和最后一个引用记号, path 为根时 parent 为空*/
+int Patcher::locate(const std::string& path, ValuePtr& parent, std::string& last) {
+    int ret;
+    if ((ret = parse_pointer(path, tokens_)) != PATCH_OK)
+        return ret;
+    parent.reset();
+    if (tokens_.empty())
+        return PATCH_OK;
+    ValuePtr cur = doc_;
+    for (size_t i = 0; i + 1 < tokens_.size(); ++i) {
+        if (cur->get_type() == OBJECT_VALUE) {
+            auto it = cur->get_object().find(tokens_[i]);
+            if (it == cur->get_object().end()) return PATCH_PATH_NOT_FOUND;
+            cur = it->second;
+        }
+        else if (cur->get_type() == ARRAY_VALUE) {
+            size_t index;
+            if (!parse_index(tokens_[i], &index) || index >= cur->get_array().size())
+                return PATCH_PATH_NOT_FOUND;
+            cur = cur->get_array()[index];
+        }
+        else
+            return PATCH_PATH_NOT_FOUND;
+    }
+    parent = cur;
+    last = tokens_.back();
+    return PATCH_OK;
+}
+
+int Patcher::get(const std::string& path, ValuePtr& out) {
+    ValuePtr parent;
+    std::string last;
+    int ret;
+    if ((ret = locate(path, parent, last)) != PATCH_OK)
+        return ret;
+    if (!parent) {
+        out = doc_;
+        return PATCH_OK;
+    }
+    size_t index;
+    if (parent->get_type() == OBJECT_VALUE) {
+        auto it = parent->get_object().find(last);
+        if (it == parent->get_object().end()) return PATCH_PATH_NOT_FOUND;
+        out = it->second;
+    }
+    else if (parent->get_type() == ARRAY_VALUE && parse_index(last, &index) && index < parent->get_array().size())
+        out = parent->get_array()[index];
+    else
+        return PATCH_PATH_NOT_FOUND;
+    return PATCH_OK;
+}
+
+int Patcher::add(const std::string& path, const ValuePtr& value) {
+    ValuePtr parent;
+    std::string last;
+    int ret;
+    if ((ret = locate(path, parent, last)) != PATCH_OK)
+        return ret;
+    if (!parent) {
+        record(Undo::ROOT, nullptr, std::string(), 0, doc_);
+        doc_ = value;
+        return PATCH_OK;
+    }
+    if (parent->get_type() == OBJECT_VALUE) {
+        Object& members = parent->get_object();
+        auto it = members.find(last);
+        if (it != members.end()) {
+            record(Undo::OBJECT_RESTORE, parent, last, 0, it->second);
+            it->second = value;
+        }
+        else {
+            record(Undo::OBJECT_ERASE, parent, last, 0, nullptr);
+            members.emplace(last, value);
+        }
+        return PATCH_OK;
+    }
+    if (parent->get_type() == ARRAY_VALUE) {
+        Array& elements = parent->get_array();
+        size_t index = elements.size();
+        if (last != "-" && (!parse_index(last, &index) || index > elements.size()))
+            return PATCH_PATH_NOT_FOUND;
+        record(Undo::ARRAY_ERASE, parent, std::string(), index, nullptr);
+        elements.insert(elements.begin() + index, value);
+        return PATCH_OK;
+    }
+    return PATCH_PATH_NOT_FOUND;
+}
+
+int Patcher::remove(const std::string& path, ValuePtr* removed) {
+    ValuePtr parent;
+    std::string last;
+    int ret;
+    if ((ret = locate(path, parent, last)) != PATCH_OK)
+        return ret;
+    if (!parent)
+        return PATCH_INVALID_OPERATION;     /*不能删除根*/
+    size_t index;
+    if (parent->get_type() == OBJECT_VALUE) {
+        Object& members = parent->get_object();
+        auto it = members.find(last);
+        if (it == members.end()) return PATCH_PATH_NOT_FOUND;
+        record(Undo::OBJECT_RESTORE, parent, last, 0, it->second);
+        if (removed) *removed = it->second;
+        members.erase(it);
+        return PATCH_OK;
+    }
+    if (parent->get_type() == ARRAY_VALUE && parse_index(last, &index) && index < parent->get_array().size()) {
+        Array& elements = parent->get_array();
+        record(Undo::ARRAY_INSERT, parent, std::string(), index, elements[index]);
+        if (removed) *removed = elements[index];
+        elements.erase(elements.begin() + index);
+        return PATCH_OK;
+    }
+    return PATCH_PATH_NOT_FOUND;
+}
+
+int Patcher::replace(const std::string& path, const ValuePtr& value) {
+    ValuePtr parent;
+    std::string last;
+    int ret;
+    if ((ret = locate(path, parent, last)) != PATCH_OK)
+        return ret;
+    if (!parent) {
+        record(Undo::ROOT, nullptr, std::string(), 0, doc_);
+        doc_ = value;
+        return PATCH_OK;
+    }
+    size_t index;
+    if (parent->get_type() == OBJECT_VALUE) {
+        auto it = parent->get_object().find(last);
+        if (it == parent->get_object().end()) return PATCH_PATH_NOT_FOUND;
+        record(Undo::OBJECT_RESTORE, parent, last, 0, it->second);
+        it->second = value;
+        return PATCH_OK;
+    }
+    if (parent->get_type() == ARRAY_VALUE && parse_index(last, &index) && index < parent->get_array().size()) {
+        record(Undo::ARRAY_SET, parent, std::string(), index, parent->get_array()[index]);
+        parent->get_array()[index] = value;
+        return PATCH_OK;
+    }
+    return PATCH_PATH_NOT_FOUND;
+}
+
+/*取出操作对象的字符串成员*/
+static bool member_string(Object& op, const char* name, std::string** out) {
+    auto it = op.find(name);
+    if (it == op.end() || it->second->get_type() != STRING_VALUE) return false;
+    *out = &it->second->get_string();
+    return true;
+}
+
+int Patcher::apply(const ValuePtr& operation) {
+    if (operation->get_type() != OBJECT_VALUE)
+        return PATCH_INVALID_OPERATION;
+    Object& op = operation->get_object();
+    std::string* name;
+    std::string* path;
+    std::string* from;
+    if (!member_string(op, "op", &name) || !member_string(op, "path", &path))
+        return PATCH_INVALID_OPERATION;
+
+    if (*name == "move" || *name == "copy") {
+        if (!member_string(op, "from", &from))
+            return PATCH_INVALID_OPERATION;
+        ValuePtr value;
+        int ret;
+        if (*name == "copy") {
+            if ((ret = get(*from, value)) != PATCH_OK) return ret;
+            return add(*path, clone_value(value));
+        }
+        if (*from == *path)
+            return get(*from, value);
+        /*不能移动到自己的子节点下面*/
+        if (path->compare(0, from->size(), *from) == 0 && (*path)[from->size()] == '/')
+            return PATCH_INVALID_OPERATION;
+        if ((ret = remove(*from, &value)) != PATCH_OK) return ret;
+        return add(*path, value);
+    }
+
+    auto it = op.find("value");
+    if (*name == "remove")
+        return remove(*path, nullptr);
+    if (it == op.end())
+        return PATCH_INVALID_OPERATION;
+    if (*name == "add")
+        return add(*path, clone_value(it->second));
+    if (*name == "replace")
+        return replace(*path, clone_value(it->second));
+    if (*name == "test") {
+        ValuePtr value;
+        int ret;
+        if ((ret = get(*path, value)) != PATCH_OK) return ret;
+        return equal_value(value, it->second) ? PATCH_OK : PATCH_TEST_FAILED;
+    }
+    return PATCH_INVALID_OPERATION;
+}
+
+void Patcher::rollback() {
+    for (auto it = undo_.rbegin(); it != undo_.rend(); ++it) {
+        switch (it->kind) {
+            case Undo::ROOT:            doc_ = it->old; break;
+            case Undo::OBJECT_RESTORE:  it->parent->get_object()[it->key] = it->old; break;
+            case Undo::OBJECT_ERASE:    it->parent->get_object().erase(it->key); break;
+            case Undo::ARRAY_INSERT:    it->parent->get_array().insert(it->parent->get_array().begin() + it->index, it->old); break;
+            case Undo::ARRAY_ERASE:     it->parent->get_array().erase(it->parent->get_array().begin() + it->index); break;
+            case Undo::ARRAY_SET:       it->parent->get_array()[it->index] = it->old; break;
+        }
+    }
+    undo_.clear();
+}
+
+}
+
+int apply_patch(ValuePtr& doc, const ValuePtr& patch) {
+    if (patch->get_type() != ARRAY_VALUE)
+        return PATCH_INVALID_OPERATION;
+    Patcher patcher(doc);
+    for (auto& op : patch->get_array()) {
+        int ret;
+        if ((ret = patcher.apply(op)) != PATCH_OK) {
+            patcher.rollback();
+            return ret;
+        }
+    }
+    return PATCH_OK;
+}
+
+/****************************************************************
+ * 生成补丁
+ * *************************************************************/
+
+static ValuePtr make_string(const std::string& s) {
+    ValuePtr v = std::make_shared<Value>();
+    v->set_string(s.data(), s.size());
+    return v;
+}
+
+static void push_op(Array& ops, const char* name, const std::string& path, const ValuePtr& value) {
+    Object members;
+    members.emplace("op", make_string(name));
+    members.emplace("path", make_string(path));
+    if (value)
+        members.emplace("value", clone_value(value));
+    ValuePtr op = std::make_shared<Value>();
+    Object empty;
+    op->set_object(empty);
+    op->get_object().swap(members);
+    ops.push_back(op);
+}
+
+static void diff_rec(const ValuePtr& from, const ValuePtr& to, std::string& path, Array& ops);
+
+static void diff_object(Object& from, Object& to, std::string& path, Array& ops) {
+    /*按键排序, 输出的补丁与 unordered_map 的遍历顺序无关*/
+    std::vector<const std::string*> keys;
+    for (auto& m : from) keys.push_back(&m.first);
+    std::sort(keys.begin(), keys.end(), [](const std::string* a, const std::string* b) { return *a < *b; });
+    size_t len = path.size();
+    for (const std::string* key : keys) {
+        append_token(path, *key);
+        auto it = to.find(*key);
+        if (it == to.end())
+            push_op(ops, "remove", path, nullptr);
+        else
+            diff_rec(from[*key], it->second, path, ops);
+        path.resize(len);
+    }
+
+    keys.clear();
+    for (auto& m : to)
+        if (from.find(m.first) == from.end()) keys.push_back(&m.first);
+    std::sort(keys.begin(), keys.end(), [](const std::string* a, const std::string* b) { return *a < *b; });
+    for (const std::string* key : keys) {
+        append_token(path, *key);
+        push_op(ops, "add", path, to[*key]);
+        path.resize(len);
+    }
+}
+
+static void diff_array(Array& from, Array& to, std::string& path, Array& ops) {
+    size_t n = from.size(), m = to.size();
+    size_t prefix = 0, suffix = 0;
+    while (prefix < n && prefix < m && equal_value(from[prefix], to[prefix]))
+        prefix++;
+    while (suffix < n - prefix && suffix < m - prefix && equal_value(from[n - 1 - suffix], to[m - 1 - suffix]))
+        suffix++;
+    size_t nf = n - prefix - suffix, nt = m - prefix - suffix;
+    size_t common = std::min(nf, nt);
+    size_t len = path.size();
+
+    for (size_t i = 0; i < common; ++i) {
+        path += '/';
+        path += std::to_string(prefix + i);
+        diff_rec(from[prefix + i], to[prefix + i], path, ops);
+        path.resize(len);
+    }
+    /*多出来的元素从后往前删, 前面的下标不受影响*/
+    for (size_t i = nf; i > common; --i) {
+        path += '/';
+        path += std::to_string(prefix + i - 1);
+        push_op(ops, "remove", path, nullptr);
+        path.resize(len);
+    }
+    for (size_t i = common; i < nt; ++i) {
+        path += '/';
+        path += std::to_string(prefix + i);
+        push_op(ops, "add", path, to[prefix + i]);
+        path.resize(len);
+    }
+}
+
+static void diff_rec(const ValuePtr& from, const ValuePtr& to, std::string& path, Array& ops) {
+    if (from == to) return;
+    if (from->get_type() != to->get_type()) {
+        push_op(ops, "replace", path, to);
+        return;
+    }
+    switch (from->get_type()) {
+        case NUMBER_VALUE:
+            if (from->get_number() != to->get_number())
+                push_op(ops, "replace", path, to);
+            break;
+        case STRING_VALUE:
+            if (from->get_string() != to->get_string())
+                push_op(ops, "replace", path, to);
+            break;
+        case ARRAY_VALUE:
+            diff_array(from->get_array(), to->get_array(), path, ops);
+            break;
+        case OBJECT_VALUE:
+            diff_object(from->get_object(), to->get_object(), path, ops);
+            break;
+        default:
+            break;
+    }
+}
+
+void diff_value(const ValuePtr& from, const ValuePtr& to, ValuePtr& patch) {
+    Array ops;
+    std::string path;
+    diff_rec(from, to, path, ops);
+    patch = std::make_shared<Value>();
+    Array empty;
+    patch->set_array(empty);
+    patch->get_array().swap(ops);
+}
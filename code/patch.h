@@ -0,0 +1,35 @@
+#ifndef __PATCH_H__
+#define __PATCH_H__
+
+#include "value.h"
+
+/**
+ * JSON Patch (RFC 6902)
+ * 补丁本身也是一个 Value: 由 {"op", "path", "value"/"from"} 对象组成的数组,
+ * 可以直接用 Json 解析和字符串化
+*/
+enum {
+    PATCH_OK = 0,
+    PATCH_INVALID_OPERATION,    /*补丁格式错误: 不是数组、缺少成员、op 未知、move 到自己的子节点*/
+    PATCH_INVALID_POINTER,      /*path/from 不是合法的 JSON Pointer (RFC 6901)*/
+    PATCH_PATH_NOT_FOUND,       /*路径不存在或数组下标越界*/
+    PATCH_TEST_FAILED,          /*test 操作的值不相等*/
+};
+
+bool equal_value(const Value::ValuePtr& a, const Value::ValuePtr& b);
+Value::ValuePtr clone_value(const Value& value);
+Value::ValuePtr clone_value(const Value::ValuePtr& value);
+
+/**
+ * 生成把 from 变成 to 的补丁, 写入 patch(数组)
+ * 对象按键递归比较; 数组先去掉相同的前缀和后缀, 中间部分逐个比较后再增删多出来的元素
+*/
+void diff_value(const Value::ValuePtr& from, const Value::ValuePtr& to, Value::ValuePtr& patch);
+
+/**
+ * 在 doc 上原地应用补丁, 只修改涉及的路径
+ * 任何一个操作失败时撤销已经做过的修改, doc 保持原样
+*/
+int apply_patch(Value::ValuePtr& doc, const Value::ValuePtr& patch);
+
+#endif // !__PATCH_H__
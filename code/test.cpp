@@ -1,6 +1,9 @@
 #include "value.h"
 #include "json.h"
+#include "patch.h"
+#include "cache.h"
 #include <iostream>
+#include <thread>
 
 static int main_ret = 0;
 static int test_count = 0;
@@ -101,7 +104,7 @@ static void test_parse_number() {
         Json json; \
         EXPECT_EQ(PARSE_OK, json.parse(jso, value)); \
         EXPECT_EQ(STRING_VALUE, value->get_type()); \
-        EXPECT_EQ(expect, value->get_string()); \
+        EXPECT_EQ(std::string(expect, sizeof(expect) - 1), value->get_string()); \
     } while (0)
 
 static void test_parse_string() {
@@ -202,6 +205,72 @@ static void test_parse_object() {
     }
 }
 
+static void test_parse_depth() {
+    Json json;
+    Value::ValuePtr value;
+    json.set_max_depth(3);
+    EXPECT_EQ(PARSE_OK, json.parse("[[1]]", value));
+    EXPECT_EQ(PARSE_DEPTH_EXCEEDED, json.parse("[[[1]]]", value));
+    EXPECT_EQ(NULL_VALUE, value->get_type());
+    EXPECT_EQ(PARSE_DEPTH_EXCEEDED, json.parse("{\"a\":{\"b\":[1]}}", value));
+
+    std::string deep = std::string(100000, '[') + std::string(100000, ']');
+    json.set_max_depth(PARSE_MAX_DEPTH);
+    EXPECT_EQ(PARSE_DEPTH_EXCEEDED, json.parse(deep.c_str(), value));
+}
+
+#ifdef JSON_ENABLE_STATS
+static void test_parse_stats() {
+    Json json;
+    Value::ValuePtr value;
+    EXPECT_EQ(PARSE_OK, json.parse("[ \"a\\nb\", \"c\", [ [ 1 ] ], { \"k\" : 2 } ]", value));
+    const ParseStats& stats = json.get_stats();
+    EXPECT_EQ(4, stats.max_depth);
+    EXPECT_EQ(1, stats.escaped_strings);
+    /*7 个子节点(顶层 4 个, 两个内层数组和对象各 1 个), 2 个字符串 "a\nb" 和 "c"; 对象的键不计*/
+    EXPECT_EQ(9, stats.alloc_count);
+    EXPECT_EQ(7 * sizeof(Value) + 4 + 2, stats.alloc_bytes);
+    EXPECT_EQ_TRUE(stats.type_ns[ARRAY_VALUE] > 0);
+    EXPECT_EQ_TRUE(stats.type_ns[OBJECT_VALUE] > 0);
+
+    /*每次 parse 重新统计*/
+    EXPECT_EQ(PARSE_OK, json.parse("1", value));
+    EXPECT_EQ(1, json.get_stats().max_depth);
+    EXPECT_EQ(0, json.get_stats().alloc_count);
+    EXPECT_EQ(0, json.get_stats().alloc_bytes);
+    EXPECT_EQ(0, json.get_stats().escaped_strings);
+    EXPECT_EQ(0, json.get_stats().type_ns[ARRAY_VALUE]);
+
+    EXPECT_EQ(PARSE_OK, json.parse("[\"x\\ty\"]", value));
+    EXPECT_EQ(2, json.get_stats().max_depth);
+    EXPECT_EQ(1, json.get_stats().escaped_strings);
+    EXPECT_EQ(2, json.get_stats().alloc_count);
+    EXPECT_EQ(sizeof(Value) + 4, json.get_stats().alloc_bytes);
+    EXPECT_EQ(0, json.get_stats().type_ns[OBJECT_VALUE]);
+}
+#endif
+
+#define TEST_UTF8(expect, jso) \
+    do { \
+        Json json; \
+        Value::ValuePtr value; \
+        EXPECT_EQ(PARSE_OK, json.parse(jso, value)); \
+        EXPECT_EQ(expect, json.parse(jso, value, PARSE_VALIDATE_UTF8)); \
+    } while (0)
+
+static void test_parse_utf8() {
+    TEST_UTF8(PARSE_OK, "\"\xC2\xA2\xE2\x82\xAC\xF0\x9D\x84\x9E\xED\x9F\xBF\xF4\x8F\xBF\xBF\"");
+    TEST_UTF8(PARSE_OK, "{\"\xE4\xBD\xA0\xE5\xA5\xBD\":[\"\\n\xC3\xA9\"]}");
+    TEST_UTF8(PARSE_INVALID_UTF8, "\"\x80\"");                  /*单独的后续字节*/
+    TEST_UTF8(PARSE_INVALID_UTF8, "\"\xC0\xAF\"");              /*过长编码*/
+    TEST_UTF8(PARSE_INVALID_UTF8, "\"\xE0\x80\xAF\"");
+    TEST_UTF8(PARSE_INVALID_UTF8, "\"\xED\xA0\x80\"");          /*代理码*/
+    TEST_UTF8(PARSE_INVALID_UTF8, "\"\xF4\x90\x80\x80\"");      /*超过 U+10FFFF*/
+    TEST_UTF8(PARSE_INVALID_UTF8, "\"\xE2\x82\"");              /*不完整*/
+    TEST_UTF8(PARSE_INVALID_UTF8, "{\"\xFF\":1}");
+    TEST_UTF8(PARSE_INVALID_UTF8, "[\"0123456789012345678901234567890123456789\xFE\"]");
+}
+
 /*******************************
  * 测试错误数据
  * *****************************/
@@ -245,6 +314,8 @@ static void test_parse_root_not_singular() {
     TEST_ERROR(PARSE_ROOT_NOT_SINGULAR, "0123");
     TEST_ERROR(PARSE_ROOT_NOT_SINGULAR, "0x0");
     TEST_ERROR(PARSE_ROOT_NOT_SINGULAR, "0x123");
+    TEST_ERROR(PARSE_ROOT_NOT_SINGULAR, "01e309");
+    TEST_ERROR(PARSE_ROOT_NOT_SINGULAR, "-0x1p9999");
 }
 
 static void test_parse_number_too_big() {
@@ -346,13 +417,498 @@ static void test_parse() {
     test_parse_miss_key();
     test_parse_miss_colon();
     test_parse_miss_comma_or_curly_bracket();
+    test_parse_depth();
+    test_parse_utf8();
+#ifdef JSON_ENABLE_STATS
+    test_parse_stats();
+#endif
 }
 
 
+/**************************************
+ * 字符串化测试
+ **************************************/
+
+#define TEST_ROUNDTRIP(jso) \
+    do { \
+        Json json; \
+        Value::ValuePtr value; \
+        EXPECT_EQ(PARSE_OK, json.parse(jso, value)); \
+        std::string str; \
+        json.stringify(value, str); \
+        EXPECT_EQ(std::string(jso), str); \
+    } while (0)
+
+static void test_stringify_number() {
+    TEST_ROUNDTRIP("0");
+    TEST_ROUNDTRIP("-0");
+    TEST_ROUNDTRIP("1");
+    TEST_ROUNDTRIP("-1");
+    TEST_ROUNDTRIP("1.5");
+    TEST_ROUNDTRIP("-1.5");
+    TEST_ROUNDTRIP("3.25");
+    TEST_ROUNDTRIP("1e+20");
+    TEST_ROUNDTRIP("1.234e+20");
+    TEST_ROUNDTRIP("1.234e-20");
+
+    TEST_ROUNDTRIP("1.0000000000000002"); /* the smallest number > 1 */
+    TEST_ROUNDTRIP("2.2250738585072009e-308");  /* Max subnormal double */
+    TEST_ROUNDTRIP("2.2250738585072014e-308");  /* Min normal positive double */
+    TEST_ROUNDTRIP("1.7976931348623157e+308");  /* Max double */
+}
+
+static void test_stringify_string() {
+    TEST_ROUNDTRIP("\"\"");
+    TEST_ROUNDTRIP("\"Hello\"");
+    TEST_ROUNDTRIP("\"Hello\\nWorld\"");
+    TEST_ROUNDTRIP("\"\\\" \\\\ / \\b \\f \\n \\r \\t\"");
+    TEST_ROUNDTRIP("\"Hello\\u0000World\"");
+    TEST_ROUNDTRIP("\"\\u0001\\u001F\"");
+    TEST_ROUNDTRIP("\"\xE2\x82\xAC\"");
+}
+
+static void test_stringify() {
+    TEST_ROUNDTRIP("null");
+    TEST_ROUNDTRIP("false");
+    TEST_ROUNDTRIP("true");
+    test_stringify_number();
+    test_stringify_string();
+    TEST_ROUNDTRIP("[]");
+    TEST_ROUNDTRIP("[null,false,true,123,\"abc\",[1,2,3]]");
+    TEST_ROUNDTRIP("{}");
+    TEST_ROUNDTRIP("{\"a\":[1,{\"b\":null}]}");
+}
+
+static void test_stringify_pretty() {
+    Json json;
+    Value::ValuePtr value;
+    EXPECT_EQ(PARSE_OK, json.parse("[1,[2,{}],{\"a\":[]}]", value));
+    std::string str;
+    StringSink sink(str);
+    json.stringify(value, sink, StringifyOptions(2));
+    EXPECT_EQ(std::string(
+        "[\n"
+        "  1,\n"
+        "  [\n"
+        "    2,\n"
+        "    {}\n"
+        "  ],\n"
+        "  {\n"
+        "    \"a\": []\n"
+        "  }\n"
+        "]"), str);
+
+    str.clear();
+    EXPECT_EQ(PARSE_OK, json.parse("{\"k\":[true]}", value));
+    json.stringify(value, sink, StringifyOptions(1, '\t'));
+    EXPECT_EQ(std::string("{\n\t\"k\": [\n\t\ttrue\n\t]\n}"), str);
+}
+
+#define TEST_ESCAPE(expect, str, flags) \
+    do { \
+        std::string out; \
+        { \
+            StringSink sink(out); \
+            write_string(sink, str, sizeof(str) - 1, flags); \
+        } \
+        EXPECT_EQ(std::string(expect), out); \
+    } while (0)
+
+static void test_stringify_escape() {
+    TEST_ESCAPE("\"\xC2\xA2\xE2\x80\xA8\"", "\xC2\xA2\xE2\x80\xA8", 0);
+    TEST_ESCAPE("\"\xC2\xA2\\u2028\\u2029\xE2\x82\xAC\"", "\xC2\xA2\xE2\x80\xA8\xE2\x80\xA9\xE2\x82\xAC", STRINGIFY_ESCAPE_JS);
+    TEST_ESCAPE("\"a\\u00A2\\u20AC\\uD834\\uDD1Eb\"", "a\xC2\xA2\xE2\x82\xAC\xF0\x9D\x84\x9E" "b", STRINGIFY_ESCAPE_UNICODE);
+    TEST_ESCAPE("\"\xFF\x80\"", "\xFF\x80", STRINGIFY_ESCAPE_UNICODE);    /*不合法的字节原样输出*/
+
+    /*转义字符出现在 16 字节块内外的各个位置*/
+    for (size_t len = 1; len < 70; ++len) {
+        for (size_t pos = 0; pos < len; ++pos) {
+            std::string in(len, 'x');
+            in[pos] = pos % 3 == 0 ? '"' : (pos % 3 == 1 ? '\\' : '\x01');
+            std::string expect = "\"" + in.substr(0, pos);
+            expect += pos % 3 == 0 ? "\\\"" : (pos % 3 == 1 ? "\\\\" : "\\u0001");
+            expect += in.substr(pos + 1) + "\"";
+            std::string out;
+            {
+                StringSink sink(out);
+                write_string(sink, in.data(), in.size());
+            }
+            EXPECT_EQ(expect, out);
+        }
+    }
+}
+
+static void test_writer() {
+    std::string str;
+    {
+        StringSink sink(str);
+        Writer w(sink);
+        w.start_object();
+        w.key("id"); w.number(1);
+        w.key("name"); w.string("a\"b\n");
+        w.key("tags");
+        w.start_array();
+        w.string("x"); w.boolean(true); w.boolean(false); w.null();
+        w.start_object(); w.end_object();
+        w.start_array(); w.end_array();
+        w.end_array();
+        w.key(std::string("pi")); w.number(3.25);
+        w.end_object();
+        EXPECT_EQ(0u, w.get_level());
+    }
+    EXPECT_EQ(std::string("{\"id\":1,\"name\":\"a\\\"b\\n\",\"tags\":[\"x\",true,false,null,{},[]],\"pi\":3.25}"), str);
+
+    /*缩进格式与 stringify 一致*/
+    const char* json = "[1,{\"k\":[true,[],{}]},\"s\",[[null]]]";
+    Json parser;
+    Value::ValuePtr value = std::make_shared<Value>();
+    EXPECT_EQ(PARSE_OK, parser.parse(json, value));
+    std::string expect, actual;
+    {
+        StringSink sink(expect);
+        parser.stringify(value, sink, StringifyOptions(2));
+    }
+    {
+        StringSink sink(actual);
+        Writer w(sink, StringifyOptions(2));
+        w.start_array();
+        w.number(1);
+        w.start_object(); w.key("k"); w.start_array(); w.boolean(true); w.start_array(); w.end_array(); w.start_object(); w.end_object(); w.end_array(); w.end_object();
+        w.string("s");
+        w.start_array(); w.start_array(); w.null(); w.end_array(); w.end_array();
+        w.end_array();
+    }
+    EXPECT_EQ(expect, actual);
+    EXPECT_EQ(std::string("[\n  1,\n  {\n    \"k\": [\n      true,\n      [],\n      {}\n    ]\n  },\n  \"s\",\n  [\n    [\n      null\n    ]\n  ]\n]"), actual);
+
+    /*转义选项同样生效*/
+    str.clear();
+    {
+        StringSink sink(str);
+        Writer w(sink, StringifyOptions(0, ' ', STRINGIFY_ESCAPE_UNICODE));
+        w.string("\xC3\xA9");
+    }
+    EXPECT_EQ(std::string("\"\\u00E9\""), str);
+}
+
+static void test_stringify_sink() {
+    /*超过缓冲区大小的输出*/
+    Json json;
+    Value::ValuePtr value = std::make_shared<Value>();
+    std::vector<Value::ValuePtr> array;
+    for (int i = 0; i < 3000; ++i) {
+        array.push_back(std::make_shared<Value>());
+        array.back()->set_string("0123456789");
+    }
+    value->set_array(array);
+    std::string expect = "[";
+    for (int i = 0; i < 3000; ++i) expect += i ? ",\"0123456789\"" : "\"0123456789\"";
+    expect += "]";
+
+    std::string str;
+    json.stringify(value, str);
+    EXPECT_EQ(expect, str);
+
+    FILE* fp = tmpfile();
+    {
+        FileSink sink(fp);
+        json.stringify(value, sink);
+        EXPECT_EQ_TRUE(sink.good());
+    }
+    EXPECT_EQ(static_cast<long>(expect.size()), ftell(fp));
+    fflush(fp);
+    {
+        FdSink sink(fileno(fp));
+        json.stringify(value, sink);
+        EXPECT_EQ_TRUE(sink.good());
+    }
+    rewind(fp);
+    std::string read(expect.size() * 2, '\0');
+    EXPECT_EQ(read.size(), fread(&read[0], 1, read.size(), fp));
+    EXPECT_EQ(expect + expect, read);
+    fclose(fp);
+}
+
+static void test_stringify_non_finite() {
+    Json json;
+    for (double num : { static_cast<double>(NAN), HUGE_VAL, -HUGE_VAL }) {
+        Value::ValuePtr value = std::make_shared<Value>();
+        value->set_number(num);
+        std::string str;
+        StringSink sink(str);
+        json.stringify(value, sink);
+        EXPECT_EQ_FALSE(sink.good());
+    }
+}
+
 /**************************************
  * value存取测试
  **************************************/
 
+/**************************************
+ * diff 与 JSON Patch 测试
+ **************************************/
+
+static Value::ValuePtr parse_text(const char* text) {
+    Json json;
+    Value::ValuePtr value = std::make_shared<Value>();
+    EXPECT_EQ(PARSE_OK, json.parse(text, value));
+    return value;
+}
+
+#define TEST_PATCH(doc, patch, expect) \
+    do { \
+        Value::ValuePtr d = parse_text(doc); \
+        EXPECT_EQ(PATCH_OK, apply_patch(d, parse_text(patch))); \
+        EXPECT_EQ_TRUE(equal_value(parse_text(expect), d)); \
+    } while (0)
+
+#define TEST_PATCH_ERROR(error, doc, patch) \
+    do { \
+        Value::ValuePtr d = parse_text(doc); \
+        EXPECT_EQ(error, apply_patch(d, parse_text(patch))); \
+        EXPECT_EQ_TRUE(equal_value(parse_text(doc), d)); \
+    } while (0)
+
+static void test_patch() {
+    /*RFC 6902 附录 A 中的例子*/
+    TEST_PATCH("{\"foo\":\"bar\"}", "[{\"op\":\"add\",\"path\":\"/baz\",\"value\":\"qux\"}]",
+               "{\"baz\":\"qux\",\"foo\":\"bar\"}");
+    TEST_PATCH("{\"foo\":[\"bar\",\"baz\"]}", "[{\"op\":\"add\",\"path\":\"/foo/1\",\"value\":\"qux\"}]",
+               "{\"foo\":[\"bar\",\"qux\",\"baz\"]}");
+    TEST_PATCH("{\"baz\":\"qux\",\"foo\":\"bar\"}", "[{\"op\":\"remove\",\"path\":\"/baz\"}]", "{\"foo\":\"bar\"}");
+    TEST_PATCH("{\"foo\":[\"bar\",\"qux\",\"baz\"]}", "[{\"op\":\"remove\",\"path\":\"/foo/1\"}]",
+               "{\"foo\":[\"bar\",\"baz\"]}");
+    TEST_PATCH("{\"baz\":\"qux\",\"foo\":\"bar\"}", "[{\"op\":\"replace\",\"path\":\"/baz\",\"value\":\"boo\"}]",
+               "{\"baz\":\"boo\",\"foo\":\"bar\"}");
+    TEST_PATCH("{\"foo\":{\"bar\":\"baz\",\"waldo\":\"fred\"},\"qux\":{\"corge\":\"grault\"}}",
+               "[{\"op\":\"move\",\"from\":\"/foo/waldo\",\"path\":\"/qux/thud\"}]",
+               "{\"foo\":{\"bar\":\"baz\"},\"qux\":{\"corge\":\"grault\",\"thud\":\"fred\"}}");
+    TEST_PATCH("{\"foo\":[\"all\",\"grass\",\"cows\",\"eat\"]}", "[{\"op\":\"move\",\"from\":\"/foo/1\",\"path\":\"/foo/3\"}]",
+               "{\"foo\":[\"all\",\"cows\",\"eat\",\"grass\"]}");
+    TEST_PATCH("{\"foo\":[\"bar\"]}", "[{\"op\":\"add\",\"path\":\"/foo/-\",\"value\":[\"abc\",\"def\"]}]",
+               "{\"foo\":[\"bar\",[\"abc\",\"def\"]]}");
+    TEST_PATCH("{\"/\":0,\"~\":1}", "[{\"op\":\"test\",\"path\":\"/~1\",\"value\":0},{\"op\":\"copy\",\"from\":\"/~0\",\"path\":\"/a\"}]",
+               "{\"/\":0,\"~\":1,\"a\":1}");
+    TEST_PATCH("{\"a\":1}", "[{\"op\":\"replace\",\"path\":\"\",\"value\":[1]},{\"op\":\"add\",\"path\":\"/0\",\"value\":0}]", "[0,1]");
+
+    /*失败时整份补丁都不生效*/
+    TEST_PATCH_ERROR(PATCH_TEST_FAILED, "{\"a\":[1,2],\"b\":{}}",
+                     "[{\"op\":\"remove\",\"path\":\"/a/0\"},{\"op\":\"add\",\"path\":\"/b/c\",\"value\":1},"
+                     "{\"op\":\"replace\",\"path\":\"\",\"value\":null},{\"op\":\"test\",\"path\":\"\",\"value\":false}]");
+    TEST_PATCH_ERROR(PATCH_PATH_NOT_FOUND, "{\"a\":[1,2]}",
+                     "[{\"op\":\"move\",\"from\":\"/a/1\",\"path\":\"/a/0\"},{\"op\":\"remove\",\"path\":\"/a/2\"}]");
+    TEST_PATCH_ERROR(PATCH_PATH_NOT_FOUND, "{\"a\":[1,2]}", "[{\"op\":\"add\",\"path\":\"/a/01\",\"value\":0}]");
+    TEST_PATCH_ERROR(PATCH_PATH_NOT_FOUND, "{\"a\":[1,2]}", "[{\"op\":\"add\",\"path\":\"/b/c\",\"value\":0}]");
+    TEST_PATCH_ERROR(PATCH_INVALID_POINTER, "{\"a\":1}", "[{\"op\":\"remove\",\"path\":\"a\"}]");
+    TEST_PATCH_ERROR(PATCH_INVALID_POINTER, "{\"a\":1}", "[{\"op\":\"remove\",\"path\":\"/~2\"}]");
+    TEST_PATCH_ERROR(PATCH_INVALID_OPERATION, "{\"a\":1}", "[{\"op\":\"add\",\"path\":\"/b\"}]");
+    TEST_PATCH_ERROR(PATCH_INVALID_OPERATION, "{\"a\":1}", "[{\"op\":\"frob\",\"path\":\"/a\",\"value\":1}]");
+    TEST_PATCH_ERROR(PATCH_INVALID_OPERATION, "{\"a\":{}}", "[{\"op\":\"move\",\"from\":\"/a\",\"path\":\"/a/b\"}]");
+    TEST_PATCH_ERROR(PATCH_INVALID_OPERATION, "{\"a\":1}", "{}");
+
+    /*应用补丁是原地修改, 没有涉及的节点不会被复制*/
+    Value::ValuePtr doc = parse_text("{\"big\":[1,2,3],\"small\":{\"x\":1}}");
+    Value::ValuePtr big = doc->get_object()["big"];
+    EXPECT_EQ(PATCH_OK, apply_patch(doc, parse_text("[{\"op\":\"replace\",\"path\":\"/small/x\",\"value\":2}]")));
+    EXPECT_EQ_TRUE(big == doc->get_object()["big"]);
+    EXPECT_EQ(2.0, doc->get_object()["small"]->get_object()["x"]->get_number());
+}
+
+#define TEST_DIFF(from, to, ops) \
+    do { \
+        Value::ValuePtr f = parse_text(from), t = parse_text(to), patch; \
+        diff_value(f, t, patch); \
+        EXPECT_EQ(static_cast<size_t>(ops), patch->get_array().size()); \
+        EXPECT_EQ(PATCH_OK, apply_patch(f, patch)); \
+        EXPECT_EQ_TRUE(equal_value(t, f)); \
+    } while (0)
+
+static void test_diff() {
+    TEST_DIFF("1", "1", 0);
+    TEST_DIFF("1", "2", 1);
+    TEST_DIFF("true", "false", 1);
+    TEST_DIFF("{\"a\":1}", "[1]", 1);
+    TEST_DIFF("{\"a\":1,\"b\":{\"c\":[1,2]}}", "{\"a\":1,\"b\":{\"c\":[1,2]}}", 0);
+    TEST_DIFF("{\"a\":1,\"b\":2,\"c/~\":3}", "{\"b\":3,\"c/~\":3,\"d\":4}", 3);
+    TEST_DIFF("[1,2,3,4,5]", "[1,2,9,3,4,5]", 1);
+    TEST_DIFF("[1,2,3,4,5]", "[1,5]", 3);
+    TEST_DIFF("[1,2,3]", "[4,5,6,7,8]", 5);
+    TEST_DIFF("[{\"id\":1,\"v\":\"a\"},{\"id\":2,\"v\":\"b\"}]", "[{\"id\":1,\"v\":\"a\"},{\"id\":2,\"v\":\"c\"}]", 1);
+    TEST_DIFF("{\"a\":[[1,{\"b\":null}]],\"x\":\"s\"}", "{\"a\":[[1,{\"b\":true,\"c\":[]}]]}", 3);
+
+    Value::ValuePtr f = parse_text("{\"a\":[1,2,3]}"), t = parse_text("{\"a\":[1,3]}"), patch;
+    diff_value(f, t, patch);
+    std::string str;
+    Json json;
+    json.stringify(patch->get_array()[0]->get_object()["path"], str);
+    EXPECT_EQ(std::string("\"/a/1\""), str);
+}
+
+static void test_parse_cache() {
+    /*XXH64 的标准测试向量*/
+    EXPECT_EQ(0xEF46DB3751D8E999ull, hash_bytes("", 0));
+    EXPECT_EQ(0xD24EC4F1A98C6E5Bull, hash_bytes("a", 1));
+    std::string text(100, 'x');
+    EXPECT_EQ_TRUE(hash_bytes(text.data(), 100) != hash_bytes(text.data(), 99));
+
+    ParseCache cache(2);
+    Json json;
+    json.set_cache(&cache);
+    const char* doc_text = "{\"k\":[1,2,3],\"s\":\"str\"}";
+    DocumentPtr a, b, c;
+    EXPECT_EQ(PARSE_OK, json.parse(doc_text, a));
+    EXPECT_EQ(PARSE_OK, json.parse(doc_text, b));
+    /*命中时是新的文档, 但共享缓存里同一棵树*/
+    EXPECT_EQ_TRUE(a != b);
+    EXPECT_EQ_TRUE(&a->root().find("s").get_string() == &b->root().find("s").get_string());
+    /*解析成可修改的树不经过缓存*/
+    Value::ValuePtr v;
+    EXPECT_EQ(PARSE_OK, json.parse(doc_text, v));
+    v->get_object()["k"]->get_array()[0]->set_number(9);
+    EXPECT_EQ(1u, cache.get_stats().hits);
+    EXPECT_EQ(1u, cache.get_stats().misses);
+    EXPECT_EQ(PARSE_OK, json.parse(doc_text, c));
+    EXPECT_EQ(1.0, c->root().find("k").at(0).get_number());
+    EXPECT_EQ(PARSE_OK, json.parse("[true]", c));
+
+    /*其它 Json 共用同一个缓存*/
+    Json other;
+    other.set_cache(&cache);
+    EXPECT_EQ(PARSE_OK, other.parse(doc_text, b));
+    EXPECT_EQ_TRUE(&a->root().find("s").get_string() == &b->root().find("s").get_string());
+    /*选项不同不命中*/
+    EXPECT_EQ(PARSE_OK, other.parse(doc_text, b, PARSE_VALIDATE_UTF8));
+    EXPECT_EQ_TRUE(&a->root().find("s").get_string() != &b->root().find("s").get_string());
+    /*失败的解析不缓存, 也不改动 c*/
+    EXPECT_EQ(PARSE_INVALID_VALUE, json.parse("[tru]", c));
+    EXPECT_EQ(PARSE_INVALID_VALUE, json.parse("[tru]", c));
+    EXPECT_EQ_TRUE(c->root().at(0).get_boolean());
+
+    ParseCacheStats stats = cache.get_stats();
+    EXPECT_EQ(3u, stats.hits);
+    EXPECT_EQ(5u, stats.misses);
+    EXPECT_EQ(2u, stats.entries);
+    EXPECT_EQ(1u, stats.evictions);
+    EXPECT_EQ_TRUE(stats.bytes > 0);
+
+    /*最近使用的保留, 最久未用的被淘汰*/
+    EXPECT_EQ(PARSE_OK, json.parse("[true]", c));
+    EXPECT_EQ(PARSE_OK, json.parse("1", c));
+    EXPECT_EQ(PARSE_OK, json.parse("[true]", c));
+    EXPECT_EQ(4u, cache.get_stats().hits);
+    EXPECT_EQ(PARSE_OK, json.parse(doc_text, c, PARSE_VALIDATE_UTF8));
+    EXPECT_EQ(4u, cache.get_stats().hits);
+
+    /*超过内存上限的文档不缓存*/
+    ParseCache small(16, 256);
+    json.set_cache(&small);
+    std::string big = "[\"" + std::string(1000, 'y') + "\"]";
+    EXPECT_EQ(PARSE_OK, json.parse(big.c_str(), a));
+    EXPECT_EQ(0u, small.get_stats().entries);
+    EXPECT_EQ(PARSE_OK, json.parse("0", a));
+    EXPECT_EQ(1u, small.get_stats().entries);
+    EXPECT_EQ_TRUE(small.get_stats().bytes <= 256);
+    small.clear();
+    EXPECT_EQ(0u, small.get_stats().entries);
+    EXPECT_EQ(0u, small.get_stats().bytes);
+}
+
+static void test_document() {
+    Json json;
+    DocumentPtr doc;
+    EXPECT_EQ(PARSE_OK, json.parse("{\"name\":\"cfg\",\"list\":[1,true,null],\"sub\":{\"x\":2}}", doc));
+    /*同一个 Json 继续解析不会影响已经冻结的文档*/
+    Value::ValuePtr other;
+    EXPECT_EQ(PARSE_OK, json.parse("[]", other));
+    DocumentPtr doc2;
+    EXPECT_EQ(PARSE_INVALID_VALUE, json.parse("[x]", doc2));
+    EXPECT_EQ_TRUE(!doc2);
+
+    ValueView root = doc->root();
+    EXPECT_EQ(OBJECT_VALUE, root.get_type());
+    EXPECT_EQ(3u, root.size());
+    EXPECT_EQ(std::string("cfg"), root.find("name").get_string());
+    EXPECT_EQ(3u, root.find("list").size());
+    EXPECT_EQ_TRUE(root.find("list").at(1).get_boolean());
+    EXPECT_EQ(NULL_VALUE, root.find("list").at(2).get_type());
+    EXPECT_EQ_FALSE(root.find("list").at(3).valid());
+    EXPECT_EQ_FALSE(root.find("none").valid());
+    EXPECT_EQ(2.0, root.find("sub").find("x").get_number());
+    size_t members = 0;
+    root.for_each_member([&](const std::string& key, ValueView v) { members += key.size() + v.valid(); });
+    EXPECT_EQ(4u + 4u + 3u + 3u, members);
+
+    /*读者不加锁读取快照, 写者整体替换文档*/
+    DocumentSlot slot(doc);
+    std::atomic<bool> stop(false);
+    std::atomic<int> errors(0);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&] {
+            while (!stop.load()) {
+                DocumentPtr snapshot = slot.load();
+                ValueView list = snapshot->root().find("list");
+                ValueView version = snapshot->root().find("version");
+                if (!version.valid()) continue;
+                for (size_t i = 0; i < list.size(); ++i)
+                    if (list.at(i).get_number() != version.get_number()) errors++;
+            }
+        });
+    }
+    Json writer;
+    for (int i = 0; i < 200; ++i) {
+        std::string text = "{\"version\":" + std::to_string(i) + ",\"list\":[";
+        for (int j = 0; j < 20; ++j) text += (j ? "," : "") + std::to_string(i);
+        text += "]}";
+        DocumentPtr next;
+        EXPECT_EQ(PARSE_OK, writer.parse(text.c_str(), next));
+        slot.store(next);
+    }
+    stop = true;
+    for (auto& t : readers) t.join();
+    EXPECT_EQ(0, errors.load());
+    EXPECT_EQ(199.0, slot.load()->root().find("version").get_number());
+    DocumentPtr old = slot.exchange(doc);
+    EXPECT_EQ(199.0, old->root().find("version").get_number());
+    EXPECT_EQ_TRUE(slot.load() == doc);
+}
+
+static void test_document_cache() {
+    ParseCache cache(4);
+    Json json;
+    json.set_cache(&cache);
+    const char* text = "{\"list\":[1,2],\"name\":\"cfg\"}";
+
+    /*先冻结文档, 再解析出可修改的树并修改它*/
+    DocumentPtr doc, doc2;
+    Value::ValuePtr value;
+    EXPECT_EQ(PARSE_OK, json.parse(text, doc));
+    EXPECT_EQ(PARSE_OK, json.parse(text, value));
+    value->get_object()["list"]->get_array()[0]->set_number(9);
+    value->get_object()["name"]->set_string("x", 1);
+    EXPECT_EQ(1.0, doc->root().find("list").at(0).get_number());
+    EXPECT_EQ(std::string("cfg"), doc->root().find("name").get_string());
+    /*命中缓存的文档共享同一棵只读的树*/
+    EXPECT_EQ(PARSE_OK, json.parse(text, doc2));
+    EXPECT_EQ_TRUE(doc != doc2);
+    EXPECT_EQ_TRUE(&doc->root().find("name").get_string() == &doc2->root().find("name").get_string());
+    EXPECT_EQ(1.0, doc2->root().find("list").at(0).get_number());
+
+    /*先解析出可修改的树并修改它, 再解析成文档*/
+    const char* text2 = "[1,[2]]";
+    EXPECT_EQ(PARSE_OK, json.parse(text2, value));
+    value->get_array()[1]->get_array()[0]->set_number(9);
+    EXPECT_EQ(PARSE_OK, json.parse(text2, doc));
+    EXPECT_EQ(2.0, doc->root().at(1).at(0).get_number());
+    EXPECT_EQ(PARSE_OK, json.parse(text2, value));
+    EXPECT_EQ(2.0, value->get_array()[1]->get_array()[0]->get_number());
+
+    ParseCacheStats stats = cache.get_stats();
+    EXPECT_EQ(1u, stats.hits);
+    EXPECT_EQ(2u, stats.misses);
+}
+
 static void test_access_null() {
     Value::ValuePtr value = std::make_shared<Value>();
     value->set_string("a");
@@ -394,6 +950,17 @@ static void test_access() {
 int main() { 
     //std::cout << sizeof(Value::ValuePtr) << std::endl;
     test_parse();
+    test_stringify();
+    test_stringify_pretty();
+    test_stringify_escape();
+    test_stringify_sink();
+    test_stringify_non_finite();
+    test_writer();
+    test_patch();
+    test_diff();
+    test_parse_cache();
+    test_document();
+    test_document_cache();
     test_access();
     std::cout << test_pass << "/" << test_count << " "
               << "(" << test_pass * 100.0 / test_count << "%) passed" 
@@ -0,0 +1,57 @@
+#include "utf8.h"
+#include <stdint.h>
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * 从 p 开始跳过连续的 ASCII 字节, 每次检查 32 字节
+*/
+static const unsigned char* skip_ascii(const unsigned char* p, const unsigned char* end) {
+#if defined(__SSE2__)
+    for (; end - p >= 32; p += 32) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16));
+        if (_mm_movemask_epi8(_mm_or_si128(a, b)))
+            break;
+    }
+#else
+    for (; end - p >= 32; p += 32) {
+        uint64_t w[4];
+        memcpy(w, p, sizeof(w));
+        if ((w[0] | w[1] | w[2] | w[3]) & 0x8080808080808080ULL)
+            break;
+    }
+#endif
+    while (p < end && *p < 0x80)
+        p++;
+    return p;
+}
+
+bool validate_utf8(const char* s, size_t len) {
+    const unsigned char* p = reinterpret_cast<const unsigned char *>(s);
+    const unsigned char* end = p + len;
+
+    while ((p = skip_ascii(p, end)) < end) {
+        unsigned char c = *p;
+        unsigned char lo = 0x80, hi = 0xBF;     /*第二个字节的范围*/
+        size_t n;
+        if      (c >= 0xC2 && c <= 0xDF) n = 2;
+        else if (c == 0xE0)              { n = 3; lo = 0xA0; }  /*过长编码*/
+        else if (c == 0xED)              { n = 3; hi = 0x9F; }  /*代理码*/
+        else if (c >= 0xE1 && c <= 0xEF) n = 3;
+        else if (c == 0xF0)              { n = 4; lo = 0x90; }  /*过长编码*/
+        else if (c == 0xF4)              { n = 4; hi = 0x8F; }  /*超过 U+10FFFF*/
+        else if (c >= 0xF1 && c <= 0xF3) n = 4;
+        else return false;
+
+        if (static_cast<size_t>(end - p) < n || p[1] < lo || p[1] > hi)
+            return false;
+        for (size_t i = 2; i < n; ++i)
+            if ((p[i] & 0xC0) != 0x80)
+                return false;
+        p += n;
+    }
+    return true;
+}
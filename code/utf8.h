@@ -0,0 +1,12 @@
+#ifndef __UTF8_H__
+#define __UTF8_H__
+
+#include <stddef.h>
+
+/**
+ * 检查 [s, s+len) 是否为合法的 UTF-8 (RFC 3629)
+ * 拒绝过长编码、代理码以及超过 U+10FFFF 的码点
+*/
+bool validate_utf8(const char* s, size_t len);
+
+#endif // !__UTF8_H__
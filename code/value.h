@@ -22,6 +22,7 @@ typedef enum {
 class Value {
 public:
     typedef std::shared_ptr<Value> ValuePtr;
+    typedef std::shared_ptr<const Value> ConstValuePtr;     /*只读的树, 见 ParseCache 和 Document*/
     Value() : type_(NULL_VALUE) {}
     ~Value() { clear(); }
 
@@ -36,13 +37,17 @@ public:
     double get_number() const { assert(type_ == NUMBER_VALUE); return num_; }
 
     void set_string(const char *value) { clear(); new(&str_) std::string(); str_ = value; type_ = STRING_VALUE; }
+    void set_string(const char *value, size_t len) { clear(); new(&str_) std::string(value, len); type_ = STRING_VALUE; }
     std::string& get_string() { assert(type_ == STRING_VALUE); return str_; }
+    const std::string& get_string() const { assert(type_ == STRING_VALUE); return str_; }
 
     void set_array(std::vector<ValuePtr>& values) { clear(); new(&array_) std::vector<ValuePtr>(values); array_ = values; type_ = ARRAY_VALUE; }
     std::vector<ValuePtr>& get_array() { assert(type_ == ARRAY_VALUE); return array_; }
+    const std::vector<ValuePtr>& get_array() const { assert(type_ == ARRAY_VALUE); return array_; }
 
     void set_object(std::unordered_map<std::string, ValuePtr>& values) { clear(); new(&obj_) std::unordered_map<std::string, ValuePtr>(values); obj_ = values; type_ = OBJECT_VALUE; }
     std::unordered_map<std::string, ValuePtr>& get_object() { assert(type_ == OBJECT_VALUE); return obj_; }
+    const std::unordered_map<std::string, ValuePtr>& get_object() const { assert(type_ == OBJECT_VALUE); return obj_; }
 
 private:    
     //void clear(){ str_.clear(); array_.clear(); obj_.clear(); type_ = NULL_VALUE; }
@@ -0,0 +1,224 @@
+#include "writer.h"
+#include <assert.h>
+#include <math.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+void FileSink::drain(const char* data, size_t len) {
+    if (fwrite(data, 1, len, fp_) != len)
+        error_ = true;
+}
+
+void FdSink::drain(const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = ::write(fd_, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            error_ = true;
+            return;
+        }
+        data += n;
+        len -= n;
+    }
+}
+
+static const char hex_digits[] = "0123456789ABCDEF";
+
+static void write_u16(Sink& sink, unsigned u) {
+    char buf[6] = { '\\', 'u', hex_digits[(u >> 12) & 15], hex_digits[(u >> 8) & 15],
+                    hex_digits[(u >> 4) & 15], hex_digits[u & 15] };
+    sink.write(buf, 6);
+}
+
+/**
+ * 判断单个字节是否需要进入转义处理
+*/
+static inline bool need_escape(unsigned char c, unsigned flags) {
+    if (c < 0x20 || c == '\"' || c == '\\') return true;
+    if (c >= 0x80 && (flags & STRINGIFY_ESCAPE_UNICODE)) return true;
+    return c == 0xE2 && (flags & STRINGIFY_ESCAPE_JS);    /*U+2028/U+2029 的首字节*/
+}
+
+/**
+ * 找到第一个需要转义的字节, 没有则返回 end
+ * 支持 SSE2 时每次检查 16 字节
+*/
+static const char* find_escape(const char* p, const char* end, unsigned flags) {
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i ctrl = _mm_set1_epi8(0x1F);
+    const __m128i lead = _mm_set1_epi8(static_cast<char>(0xE2));
+    for (; end - p >= 16; p += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash));
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(_mm_min_epu8(v, ctrl), v));     /*无符号 v <= 0x1F*/
+        if (flags & STRINGIFY_ESCAPE_UNICODE)
+            m = _mm_or_si128(m, v);     /*最高位为 1 的字节*/
+        else if (flags & STRINGIFY_ESCAPE_JS)
+            m = _mm_or_si128(m, _mm_cmpeq_epi8(v, lead));
+        int mask = _mm_movemask_epi8(m);
+        if (mask)
+            return p + __builtin_ctz(mask);
+    }
+#endif
+    for (; p < end; ++p)
+        if (need_escape(static_cast<unsigned char>(*p), flags))
+            return p;
+    return end;
+}
+
+/**
+ * 解码一个 UTF-8 字符, 返回其字节数, 不合法时返回 0
+*/
+static size_t decode_utf8(const unsigned char* p, const unsigned char* end, unsigned* u) {
+    size_t n;
+    if      (*p >= 0xF5) return 0;
+    else if (*p >= 0xF0) { n = 4; *u = *p & 0x07; }
+    else if (*p >= 0xE0) { n = 3; *u = *p & 0x0F; }
+    else if (*p >= 0xC2) { n = 2; *u = *p & 0x1F; }
+    else return 0;
+    if (static_cast<size_t>(end - p) < n) return 0;
+    for (size_t i = 1; i < n; ++i) {
+        if ((p[i] & 0xC0) != 0x80) return 0;
+        *u = (*u << 6) | (p[i] & 0x3F);
+    }
+    return n;
+}
+
+/**
+ * 输出带引号的字符串, 按 json 规则转义
+ * 不需要转义的连续字节整段写入
+*/
+void write_string(Sink& sink, const char* s, size_t len, unsigned flags) {
+    const char* p = s;
+    const char* end = s + len;
+    sink.put('"');
+    while (p < end) {
+        const char* q = find_escape(p, end, flags);
+        sink.write(p, q - p);
+        if (q == end) break;
+        p = q;
+
+        unsigned char c = static_cast<unsigned char>(*p);
+        switch (c) {
+            case '\"': sink.write("\\\"", 2); break;
+            case '\\': sink.write("\\\\", 2); break;
+            case '\b': sink.write("\\b", 2); break;
+            case '\f': sink.write("\\f", 2); break;
+            case '\n': sink.write("\\n", 2); break;
+            case '\r': sink.write("\\r", 2); break;
+            case '\t': sink.write("\\t", 2); break;
+            default:
+                if (c < 0x20) {
+                    write_u16(sink, c);
+                    break;
+                }
+                unsigned u;
+                size_t n = decode_utf8(reinterpret_cast<const unsigned char *>(p),
+                                       reinterpret_cast<const unsigned char *>(end), &u);
+                if (n == 0) {
+                    sink.put(*p);       /*不合法的 UTF-8 原样输出*/
+                    break;
+                }
+                if ((flags & STRINGIFY_ESCAPE_UNICODE) || u == 0x2028 || u == 0x2029) {
+                    if (u >= 0x10000) {
+                        u -= 0x10000;
+                        write_u16(sink, 0xD800 | (u >> 10));
+                        write_u16(sink, 0xDC00 | (u & 0x3FF));
+                    }
+                    else write_u16(sink, u);
+                }
+                else sink.write(p, n);
+                p += n;
+                continue;
+        }
+        p++;
+    }
+    sink.put('"');
+}
+
+/**
+ * 输出数字, 优先使用能还原出同一个 double 的最短精度
+*/
+void write_number(Sink& sink, double num) {
+    if (!isfinite(num)) {
+        sink.set_error();
+        return;
+    }
+    char buf[32];
+    int len = snprintf(buf, sizeof(buf), "%.15g", num);
+    if (strtod(buf, nullptr) != num)
+        len = snprintf(buf, sizeof(buf), "%.17g", num);
+    sink.write(buf, len);
+}
+
+/****************************************************************
+ * 流式输出
+ * *************************************************************/
+
+/*换行并缩进到第 level 层, 紧凑格式下什么也不输出*/
+void Writer::indent(size_t level) {
+    if (!options_.indent) return;
+    sink_.put('\n');
+    for (size_t i = level * options_.indent; i > 0; --i) sink_.put(options_.indent_char);
+}
+
+/*输出值之前的分隔符和缩进*/
+void Writer::before_value() {
+#ifndef NDEBUG
+    assert(!done_ && "root value already written");
+    assert((stack_.empty() || stack_.back() == '[' || after_key_) && "object member needs a key first");
+    if (stack_.empty()) done_ = true;
+#endif
+    if (after_key_) {
+        after_key_ = false;
+        return;
+    }
+    if (level_) {
+        if (!first_) sink_.put(',');
+        indent(level_);
+    }
+    first_ = false;
+}
+
+void Writer::key(const char* s, size_t len) {
+#ifndef NDEBUG
+    assert(!stack_.empty() && stack_.back() == '{' && !after_key_ && "key outside object or key after key");
+#endif
+    if (!first_) sink_.put(',');
+    indent(level_);
+    first_ = false;
+    write_string(sink_, s, len, options_.flags);
+    sink_.put(':');
+    if (options_.indent) sink_.put(' ');
+    after_key_ = true;
+}
+
+void Writer::open(char ch) {
+    before_value();
+#ifndef NDEBUG
+    done_ = false;
+    stack_.push_back(ch);
+#endif
+    sink_.put(ch);
+    level_++;
+    first_ = true;
+}
+
+void Writer::close(char ch) {
+#ifndef NDEBUG
+    assert(!stack_.empty() && stack_.back() == (ch == '}' ? '{' : '[') && "mismatched end");
+    assert(!after_key_ && "key without value");
+    stack_.pop_back();
+    if (stack_.empty()) done_ = true;
+#endif
+    level_--;
+    if (!first_) indent(level_);
+    sink_.put(ch);
+    first_ = false;
+}
@@ -0,0 +1,181 @@
+#ifndef __WRITER_H__
+#define __WRITER_H__
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define SINK_BUFFER_SIZE 4096   /*输出缓冲区大小, 写满后交给具体的 Sink 输出*/
+
+/**
+ * 字符串化的输出端
+ * 先写入固定大小的缓冲区, 满了再调用 drain 输出, 内存占用与文档大小无关
+ * 派生类析构时需要调用 flush
+*/
+class Sink {
+public:
+    Sink() : error_(false), pos_(0) {}
+    virtual ~Sink() {}
+
+    void put(char ch) {
+        if (pos_ == SINK_BUFFER_SIZE) flush();
+        buf_[pos_++] = ch;
+    }
+    void write(const char* data, size_t len) {
+        if (len > SINK_BUFFER_SIZE - pos_) {
+            flush();
+            if (len >= SINK_BUFFER_SIZE) {  /*大块数据直接输出*/
+                drain(data, len);
+                return;
+            }
+        }
+        memcpy(buf_ + pos_, data, len);
+        pos_ += len;
+    }
+    void write(const char* str) { write(str, strlen(str)); }
+    void flush() {
+        if (pos_) {
+            drain(buf_, pos_);
+            pos_ = 0;
+        }
+    }
+    bool good() const { return !error_; }    /*输出失败或者写了 NaN/Inf 时为 false*/
+    void set_error() { error_ = true; }
+
+protected:
+    virtual void drain(const char* data, size_t len) = 0;
+    bool error_;
+
+private:
+    Sink(const Sink&);
+    Sink& operator=(const Sink&);
+
+    char buf_[SINK_BUFFER_SIZE];
+    size_t pos_;
+};
+
+/*输出到可增长的 std::string*/
+class StringSink : public Sink {
+public:
+    explicit StringSink(std::string& str) : str_(str) {}
+    ~StringSink() { flush(); }
+
+protected:
+    void drain(const char* data, size_t len) { str_.append(data, len); }
+
+private:
+    std::string& str_;
+};
+
+/*输出到 FILE*, 不负责关闭*/
+class FileSink : public Sink {
+public:
+    explicit FileSink(FILE* fp) : fp_(fp) {}
+    ~FileSink() { flush(); }
+
+protected:
+    void drain(const char* data, size_t len);
+
+private:
+    FILE* fp_;
+};
+
+/*输出到文件描述符, 不负责关闭*/
+class FdSink : public Sink {
+public:
+    explicit FdSink(int fd) : fd_(fd) {}
+    ~FdSink() { flush(); }
+
+protected:
+    void drain(const char* data, size_t len);
+
+private:
+    int fd_;
+};
+
+/**
+ * 字符串转义选项, 可按位组合
+*/
+enum {
+    STRINGIFY_ESCAPE_UNICODE = 1 << 0,  /*非 ASCII 字符输出为 \uXXXX*/
+    STRINGIFY_ESCAPE_JS      = 1 << 1,  /*转义 U+2028/U+2029, 可直接嵌入 JavaScript*/
+};
+
+/**
+ * 字符串化选项
+ * indent 为 0 时输出紧凑格式, 否则每层缩进 indent 个 indent_char
+*/
+struct StringifyOptions {
+    StringifyOptions() : indent(0), indent_char(' '), flags(0) {}
+    StringifyOptions(unsigned n, char ch = ' ', unsigned f = 0) : indent(n), indent_char(ch), flags(f) {}
+
+    unsigned indent;
+    char indent_char;
+    unsigned flags;     /*STRINGIFY_ESCAPE_xxx*/
+};
+
+/*字符串化和流式输出共用的格式化函数*/
+void write_string(Sink& sink, const char* s, size_t len, unsigned flags = 0);
+void write_number(Sink& sink, double num);     /*NaN/Inf 不是合法的 JSON, 不输出并置 sink 的错误*/
+
+/**
+ * 流式输出, 不生成 Value 树
+ *
+ *   StringSink sink(str);
+ *   Writer w(sink);
+ *   w.start_object();
+ *   w.key("id"); w.number(1);
+ *   w.key("tags"); w.start_array(); w.string("a"); w.end_array();
+ *   w.end_object();
+ *   w.flush();
+ *
+ * 格式(缩进、转义选项)与 Json::stringify 相同, stringify 本身也是用它实现的
+ * 调试模式下用一个显式的栈检查调用顺序: 键只能出现在对象里并且后面必须跟一个值,
+ * start/end 必须配对, 根只能有一个值
+ * 检查用的成员总是存在, 只有检查本身受 NDEBUG 控制, 类的布局与编译选项无关
+*/
+class Writer {
+public:
+    explicit Writer(Sink& sink, const StringifyOptions& options = StringifyOptions())
+        : sink_(sink), options_(options), level_(0), first_(true), after_key_(false), done_(false) {}
+
+    void start_object() { open('{'); }
+    void end_object() { close('}'); }
+    void start_array() { open('['); }
+    void end_array() { close(']'); }
+
+    void key(const char* s, size_t len);
+    void key(const char* s) { key(s, strlen(s)); }
+    void key(const std::string& s) { key(s.data(), s.size()); }
+
+    void null() { before_value(); sink_.write("null", 4); }
+    void boolean(bool b) { before_value(); if (b) sink_.write("true", 4); else sink_.write("false", 5); }
+    void number(double num) { before_value(); write_number(sink_, num); }
+    void string(const char* s, size_t len) { before_value(); write_string(sink_, s, len, options_.flags); }
+    void string(const char* s) { string(s, strlen(s)); }
+    void string(const std::string& s) { string(s.data(), s.size()); }
+
+    void flush() { sink_.flush(); }
+    size_t get_level() const { return level_; }
+
+private:
+    Writer(const Writer&);
+    Writer& operator=(const Writer&);
+
+    void before_value();
+    void open(char ch);
+    void close(char ch);
+    void indent(size_t level);
+
+    Sink& sink_;
+    StringifyOptions options_;
+    size_t level_;          /*当前嵌套层数*/
+    bool first_;            /*当前层还没有输出元素*/
+    bool after_key_;        /*刚输出了键, 下一个值紧跟冒号*/
+    std::vector<char> stack_;   /*每层的 '[' 或 '{', 只在调试模式下维护*/
+    bool done_;                 /*根的值已经完整输出, 只在调试模式下维护*/
+};
+
+#endif // !__WRITER_H__
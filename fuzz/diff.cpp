@@ -0,0 +1,221 @@
+#include "diff.h"
+#include <string.h>
+#include "../src/ydsjson.h"
+#include "../src/ydsasync.h"
+#include "../code/json.h"
+
+/*src/ 需要互相比较的解析模式, 第一个作为基准*/
+static const struct {
+    const char* name;
+    unsigned flags;
+} modes[] = {
+    { "recursive", 0 },
+    { "iterative", YDS_PARSE_ITERATIVE },
+    { "in_place", YDS_PARSE_IN_PLACE },
+    { "packed", YDS_PARSE_IN_PLACE | YDS_PARSE_PACK_NUMBERS },
+    { "intern_keys", YDS_PARSE_INTERN_KEYS },
+    { "iterative_intern_keys", YDS_PARSE_ITERATIVE | YDS_PARSE_INTERN_KEYS },
+};
+
+/*code/ 的错误码与 src/ 的前 YDS_PARSE_INVALID_UTF8 + 1 个一一对应*/
+static_assert(static_cast<int>(PARSE_INVALID_UTF8) == static_cast<int>(YDS_PARSE_INVALID_UTF8), "error codes of the two parsers should line up");
+
+static std::string escape(const std::string& s) {
+    static const char hex_digits[] = "0123456789ABCDEF";
+    std::string out;
+    for (unsigned char c : s) {
+        if (c >= 0x20 && c < 0x7f && c != '\\')
+            out += static_cast<char>(c);
+        else {
+            out += "\\x";
+            out += hex_digits[c >> 4];
+            out += hex_digits[c & 15];
+        }
+    }
+    return out;
+}
+
+static bool fail(std::string* report, const std::string& text, const std::string& what) {
+    if (report)
+        *report = what + " (input: \"" + escape(text) + "\")";
+    return false;
+}
+
+/*把 text 每 chunk 字节喂一次给 YdsAsyncParser, 每次调用只允许处理 1 字节*/
+static int parse_async(YdsValue* value, const std::string& text, size_t chunk, YdsErrorInfo* error) {
+    YdsAsyncParser parser(value, 0, 1);
+    yds_async_status st = YDS_ASYNC_WANT_READ;
+    for (size_t i = 0; i < text.size() && st == YDS_ASYNC_WANT_READ; i += chunk) {
+        st = parser.feed(text.data() + i, text.size() - i < chunk ? text.size() - i : chunk);
+        while (st == YDS_ASYNC_YIELD)
+            st = parser.resume();
+    }
+    if (st == YDS_ASYNC_WANT_READ)
+        st = parser.finish();
+    while (st == YDS_ASYNC_YIELD)
+        st = parser.resume();
+    *error = parser.get_error();
+    return st == YDS_ASYNC_DONE ? YDS_PARSE_OK : error->code;
+}
+
+/*两个 double 相同, NaN 不会出现在解析结果里*/
+static bool same_number(double a, double b) {
+    return a == b && signbit(a) == signbit(b);
+}
+
+/**
+ * 比较两个实现的树
+ * 对象比较不重复的键的集合, 重复的键取 src/ 中最后一次出现的值
+*/
+static bool same_tree(const YdsValue& a, const Value& b, std::string* where) {
+    if (static_cast<int>(a.get_type()) != static_cast<int>(b.get_type())) {
+        *where += " type";
+        return false;
+    }
+    switch (a.get_type()) {
+        case YDS_NUMBER:
+            return same_number(a.get_number(), b.get_number());
+        case YDS_STRING:
+            return a.get_string_len() == b.get_string().size() &&
+                   memcmp(a.get_string(), b.get_string().data(), a.get_string_len()) == 0;
+        case YDS_ARRAY: {
+            const std::vector<Value::ValuePtr>& e = b.get_array();
+            if (a.get_array_size() != e.size())
+                return false;
+            for (size_t i = 0; i < e.size(); ++i) {
+                bool same = a.is_packed()
+                    ? e[i]->get_type() == NUMBER_VALUE && same_number(a.get_array_number(i), e[i]->get_number())
+                    : same_tree(*a.get_array_element(i), *e[i], where);
+                if (!same) {
+                    where->insert(0, "/" + std::to_string(i));
+                    return false;
+                }
+            }
+            return true;
+        }
+        case YDS_OBJECT: {
+            const std::unordered_map<std::string, Value::ValuePtr>& m = b.get_object();
+            size_t distinct = 0;
+            for (size_t i = 0; i < a.get_object_size(); ++i) {
+                std::string key(a.get_object_key(i), a.get_object_key_len(i));
+                bool last = true;
+                for (size_t j = i + 1; j < a.get_object_size() && last; ++j)
+                    last = a.get_object_key_len(j) != key.size() || memcmp(a.get_object_key(j), key.data(), key.size()) != 0;
+                if (!last)
+                    continue;
+                distinct++;
+                auto it = m.find(key);
+                if (it == m.end() || !same_tree(*a.get_object_value(i), *it->second, where)) {
+                    where->insert(0, "/" + key);
+                    return false;
+                }
+            }
+            return distinct == m.size();
+        }
+        default:
+            return true;
+    }
+}
+
+static std::string write_yds(const YdsValue& v) {
+    YdsAsyncWriter writer(&v);
+    std::string out;
+    const char* data;
+    size_t len;
+    while (writer.next_chunk(&data, &len))
+        out.append(data, len);
+    return out;
+}
+
+bool diff_parse(const char* data, size_t len, std::string* report) {
+    std::string text(data, strnlen(data, len));
+    YdsJson yds;
+    YdsValue base;
+    int code = yds.parse(&base, text.c_str(), modes[0].flags);
+    YdsErrorInfo error = yds.get_error();
+
+    /*src/ 的各个模式之间: 错误码、偏移、路径和结果都要相同*/
+    for (size_t m = 1; m < sizeof(modes) / sizeof(modes[0]); ++m) {
+        YdsJson other;
+        YdsValue v;
+        int ret = other.parse(&v, text.c_str(), modes[m].flags);
+        if (ret != code || other.get_error().offset != error.offset || other.get_error().path != error.path)
+            return fail(report, text, std::string(modes[m].name) + ": error " + std::to_string(ret) + " at " +
+                        std::to_string(other.get_error().offset) + " '" + other.get_error().path + "', " + modes[0].name +
+                        ": error " + std::to_string(code) + " at " + std::to_string(error.offset) + " '" + error.path + "'");
+        if (ret == YDS_PARSE_OK && !v.equals(base))
+            return fail(report, text, std::string(modes[m].name) + ": tree differs from " + modes[0].name);
+    }
+
+    for (size_t chunk : { static_cast<size_t>(1), text.size() + 1 }) {
+        YdsValue v;
+        YdsErrorInfo async_error;
+        int ret = parse_async(&v, text, chunk, &async_error);
+        if (ret != code || async_error.offset != error.offset || async_error.path != error.path)
+            return fail(report, text, "async(" + std::to_string(chunk) + "): error " + std::to_string(ret) + " at " +
+                        std::to_string(async_error.offset) + " '" + async_error.path + "', recursive: error " +
+                        std::to_string(code) + " at " + std::to_string(error.offset) + " '" + error.path + "'");
+        if (ret == YDS_PARSE_OK && !v.equals(base))
+            return fail(report, text, "async: tree differs from recursive");
+    }
+
+    /*带长度的接口不会停在 '\0': 前缀是完整的值时, '\0' 及之后的字节是多余的*/
+    if (text.size() < len && code == YDS_PARSE_OK) {
+        YdsValue v;
+        YdsErrorInfo async_error;
+        std::string full(data, len);
+        int ret = parse_async(&v, full, 1, &async_error);
+        if (ret != YDS_PARSE_ROOT_NOT_SINGULAR || async_error.offset != text.size())
+            return fail(report, full, "async: error " + std::to_string(ret) + " at " + std::to_string(async_error.offset) +
+                        " after an embedded NUL at " + std::to_string(text.size()));
+        YdsValidateInfo full_info;
+        ret = yds.validate(full.data(), full.size(), &full_info);
+        if (ret != YDS_PARSE_ROOT_NOT_SINGULAR || full_info.offset != text.size())
+            return fail(report, full, "validate: error " + std::to_string(ret) + " at " + std::to_string(full_info.offset) +
+                        " after an embedded NUL at " + std::to_string(text.size()));
+    }
+
+    YdsValidateInfo info;
+    int ret = yds.validate(text.data(), text.size(), &info);
+    if (ret != code || (ret != YDS_PARSE_OK && info.offset != error.offset))
+        return fail(report, text, "validate: error " + std::to_string(ret) + " at " + std::to_string(info.offset) +
+                    ", parse: error " + std::to_string(code) + " at " + std::to_string(error.offset));
+
+    /*两个实现之间: 错误码和结果*/
+    Json json;
+    Value::ValuePtr value;
+    ret = json.parse(text.c_str(), value);
+    if (ret != code)
+        return fail(report, text, "code/: error " + std::to_string(ret) + ", src/: error " + std::to_string(code));
+    YdsJson yds_utf8;
+    YdsValue ignored;
+    int strict = yds_utf8.parse(&ignored, text.c_str(), YDS_PARSE_VALIDATE_UTF8);
+    Json json_utf8;
+    Value::ValuePtr ignored_value;
+    if ((ret = json_utf8.parse(text.c_str(), ignored_value, PARSE_VALIDATE_UTF8)) != strict)
+        return fail(report, text, "validate utf8: code/: error " + std::to_string(ret) + ", src/: error " + std::to_string(strict));
+    if (code != YDS_PARSE_OK)
+        return true;
+    std::string where;
+    if (!same_tree(base, *value, &where))
+        return fail(report, text, "trees differ at '" + where + "'");
+
+    /*各自生成的文本, 用对方重新解析后仍然相同*/
+    std::string out = write_yds(base);
+    Value::ValuePtr again;
+    if ((ret = json.parse(out.c_str(), again)) != PARSE_OK)
+        return fail(report, text, "code/ cannot parse src/ output \"" + escape(out) + "\": error " + std::to_string(ret));
+    where.clear();
+    if (!same_tree(base, *again, &where))
+        return fail(report, text, "src/ output \"" + escape(out) + "\" reparsed by code/ differs at '" + where + "'");
+
+    out.clear();
+    json.stringify(value, out);
+    YdsValue back;
+    if ((ret = yds.parse(&back, out.c_str())) != YDS_PARSE_OK)
+        return fail(report, text, "src/ cannot parse code/ output \"" + escape(out) + "\": error " + std::to_string(ret));
+    where.clear();
+    if (!same_tree(back, *value, &where))
+        return fail(report, text, "code/ output \"" + escape(out) + "\" reparsed by src/ differs at '" + where + "'");
+    return true;
+}
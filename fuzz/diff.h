@@ -0,0 +1,18 @@
+#ifndef __DIFF_H__
+#define __DIFF_H__
+
+#include <stddef.h>
+#include <string>
+
+/**
+ * 差分测试: 用 src/ 的 YdsJson(各种解析模式、异步解析、validate)和 code/ 的 Json 解析同一份输入
+ * 比较错误码、错误位置和解析结果, 成功时再比较两边各自生成的文本重新解析的结果
+ * 全部一致返回 true; 否则返回 false, 并把第一处不一致写到 report
+ *
+ * 两个实现都以 '\0' 结尾读取输入, 比较只用 data 中第一个 '\0' 之前的内容;
+ * 带长度的异步解析和 validate 另外检查: 前缀是完整的值时, 整个 data 报告 YDS_PARSE_ROOT_NOT_SINGULAR
+ * code/ 的对象用 unordered_map 保存, 重复的键保留最后一个; 比较时 src/ 的对象也按最后一个计算
+*/
+bool diff_parse(const char* data, size_t len, std::string* report);
+
+#endif // !__DIFF_H__
@@ -0,0 +1,124 @@
+/**
+ * 差分测试的独立入口, 不需要 libFuzzer
+ *
+ *   yds_diff [-n 次数] [-s 种子] [文件或目录 ...]
+ *
+ * 先检查给出的文件(目录下的每个文件, 例如 libFuzzer 的语料库), 再对内置的种子做 -n 次随机变异
+ * 发现不一致时打印出来, 进程返回 1
+*/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "diff.h"
+
+#define DIFF_ITERATIONS     20000   /*默认的变异次数*/
+#define DIFF_MAX_REPORTS    10      /*最多打印的不一致个数*/
+
+static const std::string seeds[] = {
+    "null", "true", "false", "0", "-0", "1.5e3", "-1E-2", "123456789012345678901234567890",
+    "1e309", "-1e309", "1e-400", "\"\"", "\"abc\"", "\"\\\"\\\\\\/\\b\\f\\n\\r\\t\"",
+    "\"\\u0000\\u00e9\\u20AC\\uD834\\uDD1E\"", "\"\\uD800\"", "\"\\uDC00\"", "\"\xe4\xbd\xa0\xe5\xa5\xbd\"", "\"\xff\"",
+    "[]", "{}", "[1, 2, 3]", "[1, \"a\", null, [true], {\"k\": false}]", "[[[[[]]]]]",
+    "{\"a\": 1, \"b\": [1, 2, {\"c\": \"d\"}], \"e\": {\"f\": null}}", "{\"a\": 1, \"a\": 2}",
+    "{\"\": 0, \"a~b/c\": [0.5, -0.25]}", " \t\r\n[ 1 , 2 ] \n",
+    "[1", "[1,", "[1 2]", "[1}", "{\"a\"", "{\"a\" 1}", "{\"a\":1", "{\"a\":1]", "{1:2}", "{\"a\":1,}",
+    "[1,]", "tru", "nul", "01", "1.", ".5", "-", "+1", "1e", "\"abc", "\"\\x\"", "\"\\u12\"", "\"\x01\"",
+    "[] x", "1 2", "\"a\" \"b\"", std::string("[1]\0garbage", 11), std::string("0 \0", 3),
+};
+
+/*变异时插入的记号*/
+static const char* tokens[] = {
+    "{", "}", "[", "]", ",", ":", "\"", "\\", "\\u", "\\uD800", "\\uDC00", "0", "-", ".", "e", "1e309",
+    "true", "false", "null", " ", "\n", "\"k\":", "[[[[", "]]]]", "\x80", "\xc3\xa9",
+};
+
+struct Rng {
+    uint64_t s;
+    uint64_t next() {
+        s ^= s << 13;
+        s ^= s >> 7;
+        s ^= s << 17;
+        return s;
+    }
+    size_t below(size_t n) { return n ? next() % n : 0; }
+};
+
+static std::string mutate(Rng& rng, std::string s) {
+    size_t count = 1 + rng.below(4);
+    for (size_t i = 0; i < count; ++i) {
+        size_t at = rng.below(s.size() + 1);
+        switch (rng.below(5)) {
+            case 0:     /*改一个字节*/
+                if (!s.empty())
+                    s[rng.below(s.size())] = static_cast<char>(1 + rng.below(255));
+                break;
+            case 1:     /*删除一段*/
+                if (at < s.size())
+                    s.erase(at, 1 + rng.below(4));
+                break;
+            case 2:     /*插入记号*/
+                s.insert(at, tokens[rng.below(sizeof(tokens) / sizeof(tokens[0]))]);
+                break;
+            case 3:     /*拼接另一个种子*/
+                s.insert(at, seeds[rng.below(sizeof(seeds) / sizeof(seeds[0]))]);
+                break;
+            default:    /*重复一段*/
+                if (!s.empty()) {
+                    size_t from = rng.below(s.size());
+                    s.insert(at, s.substr(from, 1 + rng.below(8)));
+                }
+                break;
+        }
+    }
+    return s;
+}
+
+static size_t failures = 0;
+
+static void check(const std::string& input, const std::string& name) {
+    std::string report;
+    if (diff_parse(input.data(), input.size(), &report))
+        return;
+    if (++failures <= DIFF_MAX_REPORTS)
+        printf("%s: %s\n", name.c_str(), report.c_str());
+}
+
+static void check_file(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    check(ss.str(), path.string());
+}
+
+int main(int argc, char* argv[]) {
+    size_t iterations = DIFF_ITERATIONS;
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            iterations = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            seed = strtoull(argv[++i], nullptr, 10) | 1;
+        else if (std::filesystem::is_directory(argv[i])) {
+            for (auto& entry : std::filesystem::directory_iterator(argv[i]))
+                if (entry.is_regular_file()) check_file(entry.path());
+        }
+        else
+            check_file(argv[i]);
+    }
+
+    const size_t nseeds = sizeof(seeds) / sizeof(seeds[0]);
+    for (size_t i = 0; i < nseeds; ++i)
+        check(seeds[i], "seed " + std::to_string(i));
+    Rng rng = { seed };
+    for (size_t i = 0; i < iterations; ++i)
+        check(mutate(rng, seeds[rng.below(nseeds)]), "mutation " + std::to_string(i));
+
+    printf("%zu inputs, %zu differences\n", nseeds + iterations, failures);
+    return failures ? 1 : 0;
+}
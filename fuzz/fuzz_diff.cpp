@@ -0,0 +1,17 @@
+/**
+ * 差分测试的 libFuzzer 目标, 发现不一致时打印并终止
+ * 得到的语料库可以交给 yds_diff 回放
+*/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "diff.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    std::string report;
+    if (!diff_parse(reinterpret_cast<const char*>(data), size, &report)) {
+        fprintf(stderr, "%s\n", report.c_str());
+        abort();
+    }
+    return 0;
+}
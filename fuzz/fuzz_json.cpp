@@ -0,0 +1,28 @@
+/**
+ * code/ 的 libFuzzer 目标: 解析、生成, 生成的文本必须能重新解析并再次生成相同的文本
+*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+#include "../code/json.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    std::string text(reinterpret_cast<const char*>(data), size);
+    for (unsigned flags : { 0u, static_cast<unsigned>(PARSE_VALIDATE_UTF8) }) {
+        Json json;
+        Value::ValuePtr value;
+        if (json.parse(text.c_str(), value, flags) != PARSE_OK)
+            continue;
+        std::string out;
+        json.stringify(value, out);
+        Value::ValuePtr again;
+        if (json.parse(out.c_str(), again) != PARSE_OK)
+            abort();
+        std::string out2;
+        json.stringify(again, out2);
+        /*对象的成员顺序取决于 unordered_map, 只在没有对象时比较文本*/
+        if (out.find('{') == std::string::npos && out2 != out)
+            abort();
+    }
+    return 0;
+}
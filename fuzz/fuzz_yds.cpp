@@ -0,0 +1,50 @@
+/**
+ * src/ 的 libFuzzer 目标: 各种解析模式、按长度的 validate、多根值遍历和 UTF-8 校验
+ * 成功解析的值写出后必须能重新解析成相同的值
+*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+#include "../src/ydsjson.h"
+#include "../src/ydsasync.h"
+
+static const unsigned flags[] = {
+    0,
+    YDS_PARSE_ITERATIVE,
+    YDS_PARSE_IN_PLACE | YDS_PARSE_PACK_NUMBERS,
+    YDS_PARSE_INTERN_KEYS | YDS_PARSE_VALIDATE_UTF8,
+};
+
+static std::string write_yds(const YdsValue& v) {
+    YdsAsyncWriter writer(&v);
+    std::string out;
+    const char* data;
+    size_t len;
+    while (writer.next_chunk(&data, &len))
+        out.append(data, len);
+    return out;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    std::string text(reinterpret_cast<const char*>(data), size);
+    YdsJson yds;
+    /*validate 按长度读取, 不依赖 '\0'*/
+    yds.validate(text.data(), text.size());
+    yds.validate(text.data(), text.size(), nullptr, YDS_PARSE_VALIDATE_UTF8);
+
+    for (unsigned f : flags) {
+        YdsValue v;
+        if (yds.parse(&v, text.c_str(), f) != YDS_PARSE_OK)
+            continue;
+        std::string out = write_yds(v);
+        YdsValue again;
+        if (yds.parse(&again, out.c_str()) != YDS_PARSE_OK || !again.equals(v))
+            abort();
+    }
+
+    YdsValue doc;
+    yds.begin_many(text.c_str());
+    while (yds.next_document(&doc))
+        ;
+    return 0;
+}
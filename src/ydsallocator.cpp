@@ -0,0 +1,247 @@
+#include "ydsallocator.h"
+#include <stdio.h>
+#include <string.h>
+#include <mutex>
+
+static void* default_malloc(void*, size_t size) { return malloc(size); }
+static void* default_realloc(void*, void* ptr, size_t, size_t new_size) { return realloc(ptr, new_size); }
+static void default_free(void*, void* ptr, size_t) { free(ptr); }
+
+const YdsAllocator yds_default_allocator = { default_malloc, default_realloc, default_free, nullptr };
+thread_local const YdsAllocator* yds_current_allocator = &yds_default_allocator;
+thread_local uint8_t yds_current_allocator_id = 0;
+
+/****************************************************************
+ * 分配器登记表
+ * *************************************************************/
+std::atomic<const YdsAllocator*> yds_allocator_table[YDS_MAX_ALLOCATORS];
+static std::mutex registry_mutex;
+
+/**
+ * 查找或登记分配器, 返回编号
+ * 已登记的分配器不加锁就能找到, 只有新登记时才加锁
+*/
+uint8_t yds_register_allocator(const YdsAllocator* alloc) {
+    if (alloc == &yds_default_allocator)
+        return 0;
+    for (int i = 1; i < YDS_MAX_ALLOCATORS; ++i)
+        if (yds_allocator_table[i].load(std::memory_order_acquire) == alloc)
+            return static_cast<uint8_t>(i);
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    int slot = 0;
+    for (int i = 1; i < YDS_MAX_ALLOCATORS; ++i) {
+        const YdsAllocator* p = yds_allocator_table[i].load(std::memory_order_relaxed);
+        if (p == alloc)
+            return static_cast<uint8_t>(i);
+        if (!p && !slot)
+            slot = i;
+    }
+    if (!slot) {
+        fprintf(stderr, "ydsjson: more than %d allocators registered\n", YDS_MAX_ALLOCATORS - 1);
+        abort();
+    }
+    yds_allocator_table[slot].store(alloc, std::memory_order_release);
+    return static_cast<uint8_t>(slot);
+}
+
+void yds_unregister_allocator(const YdsAllocator* alloc) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (int i = 1; i < YDS_MAX_ALLOCATORS; ++i)
+        if (yds_allocator_table[i].load(std::memory_order_relaxed) == alloc)
+            yds_allocator_table[i].store(nullptr, std::memory_order_release);
+}
+
+/****************************************************************
+ * 内存池
+ * *************************************************************/
+static void* pool_malloc(void* ctx, size_t size) {
+    return static_cast<YdsPoolAllocator *>(ctx)->allocate(size);
+}
+static void* pool_realloc(void* ctx, void* ptr, size_t old_size, size_t new_size) {
+    return static_cast<YdsPoolAllocator *>(ctx)->reallocate(ptr, old_size, new_size);
+}
+static void pool_free(void* ctx, void* ptr, size_t size) {
+    static_cast<YdsPoolAllocator *>(ctx)->deallocate(ptr, size);
+}
+
+YdsPoolAllocator::YdsPoolAllocator() : chunks_(nullptr) {
+    alloc_.malloc_fn = pool_malloc;
+    alloc_.realloc_fn = pool_realloc;
+    alloc_.free_fn = pool_free;
+    alloc_.ctx = this;
+    memset(free_, 0, sizeof(free_));
+}
+
+YdsPoolAllocator::~YdsPoolAllocator() {
+    yds_unregister_allocator(&alloc_);
+    while (chunks_) {
+        Chunk* next = chunks_->next;
+        free(chunks_);
+        chunks_ = next;
+    }
+}
+
+/**
+ * 计算尺寸级别, 超出内存池范围返回 -1
+*/
+int YdsPoolAllocator::size_class(size_t size) {
+    if (size > YDS_POOL_MAX_SIZE) return -1;
+    int cls = 0;
+    for (size_t n = 16; n < size; n <<= 1) cls++;
+    return cls;
+}
+
+/**
+ * 申请一个新块并切分成对应级别的空闲节点
+*/
+void* YdsPoolAllocator::refill(int cls) {
+    size_t n = static_cast<size_t>(16) << cls;
+    Chunk* chunk = static_cast<Chunk *>(malloc(YDS_POOL_CHUNK_SIZE));
+    if (!chunk) return nullptr;
+    chunk->next = chunks_;
+    chunks_ = chunk;
+
+    /*块头之后按 16 字节对齐*/
+    char* p = reinterpret_cast<char *>(chunk) + 16;
+    char* end = reinterpret_cast<char *>(chunk) + YDS_POOL_CHUNK_SIZE;
+    for (; p + n <= end; p += n) {
+        FreeNode* node = reinterpret_cast<FreeNode *>(p);
+        node->next = free_[cls];
+        free_[cls] = node;
+    }
+    return free_[cls];
+}
+
+void* YdsPoolAllocator::allocate(size_t size) {
+    int cls = size_class(size);
+    if (cls < 0) return malloc(size);
+    if (!free_[cls] && !refill(cls)) return nullptr;
+    FreeNode* node = free_[cls];
+    free_[cls] = node->next;
+    return node;
+}
+
+void* YdsPoolAllocator::reallocate(void* ptr, size_t old_size, size_t new_size) {
+    if (!ptr) return allocate(new_size);
+    int old_cls = size_class(old_size), new_cls = size_class(new_size);
+    if (old_cls < 0 && new_cls < 0) return realloc(ptr, new_size);
+    if (old_cls >= 0 && old_cls == new_cls) return ptr;
+
+    void* ret = allocate(new_size);
+    if (!ret) return nullptr;
+    memcpy(ret, ptr, old_size < new_size ? old_size : new_size);
+    deallocate(ptr, old_size);
+    return ret;
+}
+
+void YdsPoolAllocator::deallocate(void* ptr, size_t size) {
+    if (!ptr) return;
+    int cls = size_class(size);
+    if (cls < 0) {
+        free(ptr);
+        return;
+    }
+    FreeNode* node = static_cast<FreeNode *>(ptr);
+    node->next = free_[cls];
+    free_[cls] = node;
+}
+
+/****************************************************************
+ * 区域分配器
+ * *************************************************************/
+static void* arena_malloc(void* ctx, size_t size) {
+    return static_cast<YdsArenaAllocator *>(ctx)->allocate(size);
+}
+static void* arena_realloc(void* ctx, void* ptr, size_t old_size, size_t new_size) {
+    return static_cast<YdsArenaAllocator *>(ctx)->reallocate(ptr, old_size, new_size);
+}
+static void arena_free(void* ctx, void* ptr, size_t size) {
+    static_cast<YdsArenaAllocator *>(ctx)->deallocate(ptr, size);
+}
+
+#define YDS_ARENA_ALIGN(n)  (((n) + 15) & ~static_cast<size_t>(15))
+
+YdsArenaAllocator::YdsArenaAllocator(size_t block_size)
+    : block_size_(block_size), head_(nullptr), current_(nullptr),
+      ptr_(nullptr), end_(nullptr), last_(nullptr), used_(0) {
+    alloc_.malloc_fn = arena_malloc;
+    alloc_.realloc_fn = arena_realloc;
+    alloc_.free_fn = arena_free;
+    alloc_.ctx = this;
+}
+
+YdsArenaAllocator::~YdsArenaAllocator() {
+    yds_unregister_allocator(&alloc_);
+    while (head_) {
+        Block* next = head_->next;
+        free(head_);
+        head_ = next;
+    }
+}
+
+/**
+ * 切换到下一个能放下 size 字节的块
+ * 先复用 reset 之前留下的块, 都放不下时再向系统申请, 超大的请求单独占一块
+*/
+bool YdsArenaAllocator::next_block(size_t size) {
+    const size_t header = YDS_ARENA_ALIGN(sizeof(Block));
+    Block* b = current_ ? current_->next : head_;
+    Block* prev = current_;
+    for (; b; prev = b, b = b->next) {
+        if (b->size - header >= size) break;
+    }
+    if (!b) {
+        size_t bytes = header + size > block_size_ ? header + size : block_size_;
+        b = static_cast<Block *>(malloc(bytes));
+        if (!b) return false;
+        b->size = bytes;
+        b->next = nullptr;
+        if (prev) prev->next = b;
+        else head_ = b;
+    }
+    current_ = b;
+    ptr_ = reinterpret_cast<char *>(b) + header;
+    end_ = reinterpret_cast<char *>(b) + b->size;
+    return true;
+}
+
+void* YdsArenaAllocator::allocate(size_t size) {
+    size = YDS_ARENA_ALIGN(size ? size : 1);
+    if (static_cast<size_t>(end_ - ptr_) < size && !next_block(size))
+        return nullptr;
+    last_ = ptr_;
+    ptr_ += size;
+    used_ += size;
+    return last_;
+}
+
+void* YdsArenaAllocator::reallocate(void* ptr, size_t old_size, size_t new_size) {
+    if (!ptr) return allocate(new_size);
+    /*最近一次的分配在块尾, 空间够就原地扩缩*/
+    if (ptr == last_ && static_cast<size_t>(end_ - last_) >= YDS_ARENA_ALIGN(new_size ? new_size : 1)) {
+        size_t old_aligned = ptr_ - last_;
+        ptr_ = last_ + YDS_ARENA_ALIGN(new_size ? new_size : 1);
+        used_ = used_ - old_aligned + (ptr_ - last_);
+        return ptr;
+    }
+    void* ret = allocate(new_size);
+    if (!ret) return nullptr;
+    memcpy(ret, ptr, old_size < new_size ? old_size : new_size);
+    return ret;
+}
+
+void YdsArenaAllocator::deallocate(void* ptr, size_t) {
+    /*释放最近一次的分配可以直接退回, 其它的等 reset*/
+    if (ptr && ptr == last_) {
+        used_ -= ptr_ - last_;
+        ptr_ = last_;
+        last_ = nullptr;
+    }
+}
+
+void YdsArenaAllocator::reset() {
+    current_ = nullptr;
+    ptr_ = end_ = last_ = nullptr;
+    used_ = 0;
+}
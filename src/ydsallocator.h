@@ -0,0 +1,174 @@
+#ifndef __YDSALLOCATOR_H__
+#define __YDSALLOCATOR_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <atomic>
+
+/**
+ * 内存分配器接口
+ * 回调都带有分配大小, 方便按尺寸分级的内存池实现
+ * 解析栈、字符串、数组和对象成员都通过当前线程的分配器申请
+ * 释放时走申请这块内存的分配器, 与释放时的当前分配器无关, 见 yds_allocator_id
+*/
+struct YdsAllocator {
+    void* (*malloc_fn)(void* ctx, size_t size);
+    void* (*realloc_fn)(void* ctx, void* ptr, size_t old_size, size_t new_size);
+    void  (*free_fn)(void* ctx, void* ptr, size_t size);
+    void* ctx;
+};
+
+/*默认分配器, 直接使用 malloc/realloc/free*/
+extern const YdsAllocator yds_default_allocator;
+
+#define YDS_MAX_ALLOCATORS      256     /*同时登记的分配器个数上限, 编号 0 是默认分配器*/
+
+/**
+ * 分配器登记表
+ * 节点和键只有 1 字节的空位, 放不下指针, 因此记下分配器在登记表中的编号,
+ * 释放时按编号找回申请它的分配器: 在作用域外、在其它线程销毁文档都走原来的分配器
+ * 分配器第一次成为当前分配器时登记, 同一个分配器总是得到同一个编号;
+ * 内存池和区域分配器析构时注销, 自定义的分配器在失效前调用 yds_unregister_allocator
+ * 分配器必须比它申请的节点和键活得久
+*/
+extern std::atomic<const YdsAllocator*> yds_allocator_table[YDS_MAX_ALLOCATORS];
+uint8_t yds_register_allocator(const YdsAllocator* alloc);     /*已登记时返回原编号; 登记表满时中止程序*/
+void yds_unregister_allocator(const YdsAllocator* alloc);
+
+inline const YdsAllocator* yds_allocator_from_id(uint8_t id) {
+    if (id == 0) return &yds_default_allocator;
+    const YdsAllocator* alloc = yds_allocator_table[id].load(std::memory_order_acquire);
+    assert(alloc && "memory freed after its allocator was unregistered");
+    return alloc;
+}
+
+/*当前线程使用的分配器和它的编号*/
+extern thread_local const YdsAllocator* yds_current_allocator;
+extern thread_local uint8_t yds_current_allocator_id;
+
+inline const YdsAllocator* yds_get_allocator() { return yds_current_allocator; }
+inline uint8_t yds_allocator_id() { return yds_current_allocator_id; }
+/*设置当前线程的分配器, 传 nullptr 恢复默认分配器*/
+inline void yds_set_allocator(const YdsAllocator* alloc) {
+    yds_current_allocator = alloc ? alloc : &yds_default_allocator;
+    yds_current_allocator_id = yds_register_allocator(yds_current_allocator);
+}
+
+inline void* yds_malloc(size_t size) {
+    return yds_current_allocator->malloc_fn(yds_current_allocator->ctx, size);
+}
+inline void* yds_realloc(void* ptr, size_t old_size, size_t new_size) {
+    return yds_current_allocator->realloc_fn(yds_current_allocator->ctx, ptr, old_size, new_size);
+}
+inline void yds_free(void* ptr, size_t size) {
+    if (ptr) yds_current_allocator->free_fn(yds_current_allocator->ctx, ptr, size);
+}
+/*用编号为 id 的分配器释放, 节点和键的内存走这里*/
+inline void yds_free(uint8_t id, void* ptr, size_t size) {
+    if (!ptr) return;
+    const YdsAllocator* alloc = yds_allocator_from_id(id);
+    alloc->free_fn(alloc->ctx, ptr, size);
+}
+
+/**
+ * 在作用域内切换当前线程的分配器
+ * 只影响作用域内的申请; 作用域内创建的 YdsValue 可以带出作用域, 也可以在其它线程销毁
+ * (分配器本身不是线程安全的, 就不能和正在使用它的线程同时销毁)
+*/
+class YdsAllocatorScope {
+public:
+    explicit YdsAllocatorScope(const YdsAllocator* alloc)
+        : prev_(yds_current_allocator), prev_id_(yds_current_allocator_id) {
+        yds_set_allocator(alloc);
+    }
+    ~YdsAllocatorScope() {
+        yds_current_allocator = prev_;
+        yds_current_allocator_id = prev_id_;
+    }
+
+private:
+    YdsAllocatorScope(const YdsAllocatorScope&);
+    YdsAllocatorScope& operator=(const YdsAllocatorScope&);
+
+    const YdsAllocator* prev_;
+    uint8_t prev_id_;
+};
+
+#define YDS_POOL_CLASS_COUNT    6       /*16, 32, 64, 128, 256, 512 字节*/
+#define YDS_POOL_MAX_SIZE       512     /*超过此大小直接走 malloc*/
+#define YDS_POOL_CHUNK_SIZE     65536   /*每次向系统申请的块大小*/
+
+/**
+ * 按尺寸分级的内存池
+ * 小块从对应级别的空闲链表分配, 释放后放回链表, 析构时统一归还
+ * 非线程安全, 适合每个线程/每个核心各用一个
+*/
+class YdsPoolAllocator {
+public:
+    YdsPoolAllocator();
+    ~YdsPoolAllocator();
+
+    const YdsAllocator* allocator() const { return &alloc_; }
+
+    void* allocate(size_t size);
+    void* reallocate(void* ptr, size_t old_size, size_t new_size);
+    void deallocate(void* ptr, size_t size);
+
+private:
+    YdsPoolAllocator(const YdsPoolAllocator&);
+    YdsPoolAllocator& operator=(const YdsPoolAllocator&);
+
+    static int size_class(size_t size);
+    void* refill(int cls);
+
+    struct FreeNode { FreeNode* next; };
+    struct Chunk { Chunk* next; };
+
+    YdsAllocator alloc_;
+    FreeNode* free_[YDS_POOL_CLASS_COUNT];
+    Chunk* chunks_;
+};
+
+#define YDS_ARENA_BLOCK_SIZE    65536   /*区域分配器每块的默认大小*/
+
+/**
+ * 区域分配器
+ * 顺序切分大块内存, 单独释放是空操作, reset() 一次性回收全部, 块留着下次使用
+ * 适合一批生命周期相同的文档; 非线程安全
+*/
+class YdsArenaAllocator {
+public:
+    explicit YdsArenaAllocator(size_t block_size = YDS_ARENA_BLOCK_SIZE);
+    ~YdsArenaAllocator();
+
+    const YdsAllocator* allocator() const { return &alloc_; }
+
+    void* allocate(size_t size);
+    void* reallocate(void* ptr, size_t old_size, size_t new_size);
+    void deallocate(void* ptr, size_t size);
+    void reset();
+    size_t get_used() const { return used_; }   /*reset 之后分配出去的字节数*/
+
+private:
+    YdsArenaAllocator(const YdsArenaAllocator&);
+    YdsArenaAllocator& operator=(const YdsArenaAllocator&);
+
+    struct Block {
+        Block* next;
+        size_t size;        /*包括块头*/
+    };
+    bool next_block(size_t size);
+
+    YdsAllocator alloc_;
+    size_t block_size_;
+    Block* head_;           /*所有块, 按申请顺序*/
+    Block* current_;
+    char* ptr_;             /*当前块中下一次分配的位置*/
+    char* end_;
+    char* last_;            /*最近一次分配的位置, 只有它可以原地扩缩*/
+    size_t used_;
+};
+
+#endif // !__YDSALLOCATOR_H__
@@ -0,0 +1,443 @@
+#include "ydsasync.h"
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include "ydsbind.h"
+
+static const size_t YDS_NO_FRAME = static_cast<size_t>(-1);
+
+static inline bool is_number_char(char ch) {
+    return (ch >= '0' && ch <= '9') || ch == '-' || ch == '+' || ch == '.' || ch == 'e' || ch == 'E';
+}
+
+/****************************************************************
+ * 可恢复的解析
+ * 与 parse_iterative 的结构相同, 状态(当前帧、待交付的值、下一步期望的记号)保存在成员里
+ * 每一步之前先确认下一个记号已经完整到达, 之后就可以直接使用同步解析的各个函数
+ * *************************************************************/
+YdsAsyncParser::YdsAsyncParser(YdsValue* value, unsigned flags, size_t budget)
+    : value_(value), pos_(0), base_(0), scan_(0), frame_(YDS_NO_FRAME), budget_(budget ? budget : 1),
+      spent_(0), state_(YDS_ASYNC_VALUE), eof_(false), errno_(0) {
+    assert(value);
+    value_->set_type(YDS_NULL);
+    json_.flags_ = (flags | YDS_PARSE_ITERATIVE) & ~(YDS_PARSE_IN_PLACE | YDS_PARSE_PACK_NUMBERS);
+    json_.depth_ = 0;
+    json_.error_.code = YDS_PARSE_OK;
+    json_.error_.offset = 0;
+    json_.error_.json = nullptr;
+    json_.error_.path.clear();
+}
+
+/*中途放弃时释放已经解析的部分*/
+YdsAsyncParser::~YdsAsyncParser() {
+    if (frame_ != YDS_NO_FRAME)
+        json_.unwind_frames(frame_, true);
+    json_.keys_.clear();
+}
+
+yds_async_status YdsAsyncParser::feed(const char* data, size_t len) {
+    assert(!eof_ && (data || len == 0));
+    compact();
+    in_.append(data, len);
+    spent_ = 0;
+    return run();
+}
+
+yds_async_status YdsAsyncParser::finish() {
+    eof_ = true;
+    spent_ = 0;
+    return run();
+}
+
+yds_async_status YdsAsyncParser::resume() {
+    spent_ = 0;
+    return run();
+}
+
+/**
+ * 先处理已经缓冲的输入, 需要更多输入时从 fd 读取, 直到 fd 暂时没有数据、用完工作量或者结束
+ * 读到文件结尾视为输入结束
+*/
+yds_async_status YdsAsyncParser::read_fd(int fd) {
+    spent_ = 0;
+    yds_async_status st = run();
+    while (st == YDS_ASYNC_WANT_READ) {
+        compact();
+        size_t old = in_.size();
+        in_.resize(old + YDS_ASYNC_READ_SIZE);
+        ssize_t n = ::read(fd, &in_[old], YDS_ASYNC_READ_SIZE);
+        in_.resize(old + (n > 0 ? n : 0));
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return YDS_ASYNC_WANT_READ;
+            errno_ = errno;
+            return YDS_ASYNC_IO_ERROR;
+        }
+        if (n == 0)
+            eof_ = true;
+        st = run();
+    }
+    return st;
+}
+
+/**
+ * 与 read_fd 相同, 只是 src 总会阻塞到有数据或者结束
+ * 缓冲区里只保留还没解析完的部分, 峰值内存约为 window 加上最长的一个记号
+*/
+yds_async_status YdsAsyncParser::read_source(YdsSource* src, size_t window) {
+    assert(src && window > 0);
+    spent_ = 0;
+    yds_async_status st = run();
+    while (st == YDS_ASYNC_WANT_READ) {
+        compact();
+        size_t old = in_.size();
+        in_.resize(old + window);
+        size_t n = src->read(&in_[old], window);
+        in_.resize(old + n);
+        if (n == 0) {
+            if (src->get_error() != YDS_SOURCE_OK)
+                return YDS_ASYNC_IO_ERROR;
+            eof_ = true;
+        }
+        st = run();
+    }
+    return st;
+}
+
+/**
+ * 从 p 处的 '"' 开始找到字符串的结束引号, 还没到达时返回 nullptr
+ * 引号前面有奇数个 '\\' 时是转义的引号
+*/
+const char* YdsAsyncParser::string_end(const char* p) {
+    const char* end = in_.c_str() + in_.size();
+    const char* q = in_.c_str() + scan_ > p + 1 ? in_.c_str() + scan_ : p + 1;
+    while ((q = static_cast<const char *>(memchr(q, '"', end - q))) != nullptr) {
+        const char* b = q;
+        while (b > p + 1 && b[-1] == '\\') b--;
+        if (((q - b) & 1) == 0)
+            return q;
+        q++;
+    }
+    scan_ = in_.size();
+    return nullptr;
+}
+
+/**
+ * p 处的标量是否已经完整到达
+ * 数字要看到后面不属于数字的字符才算结束; 输入结束后总是返回 true, 由解析函数报告错误
+*/
+bool YdsAsyncParser::token_ready(const char* p) {
+    if (eof_)
+        return true;
+    const char* end = in_.c_str() + in_.size();
+    switch (*p) {
+        case '"':
+            return string_end(p) != nullptr;
+        case 't':
+        case 'n':
+            return end - p >= 4;
+        case 'f':
+            return end - p >= 5;
+        default:
+            if (!is_number_char(*p))
+                return true;
+            for (const char* q = p + 1; q < end; ++q)
+                if (!is_number_char(*q)) return true;
+            return false;
+    }
+}
+
+/*键、后面的空白和冒号都到达后才解析, 与 push_member 的步骤一致*/
+bool YdsAsyncParser::key_ready(const char* p) {
+    if (eof_ || *p != '"')
+        return true;
+    const char* q = string_end(p);
+    if (!q)
+        return false;
+    const char* end = in_.c_str() + in_.size();
+    for (++q; q < end; ++q)
+        if (*q != ' ' && *q != '\t' && *q != '\n' && *q != '\r') return true;
+    return false;
+}
+
+/*已经解析的前缀超过一半时丢弃, 解析栈上没有指向输入的指针*/
+void YdsAsyncParser::compact() {
+    if (pos_ < YDS_ASYNC_READ_SIZE || pos_ < in_.size() / 2)
+        return;
+    in_.erase(0, pos_);
+    base_ += pos_;
+    scan_ = scan_ > pos_ ? scan_ - pos_ : 0;
+    pos_ = 0;
+}
+
+/*把 v_ 交给当前层, 没有上一层时就是根值*/
+void YdsAsyncParser::deliver() {
+    YdsContext& c = json_.context_;
+    if (frame_ == YDS_NO_FRAME) {
+        memcpy(static_cast<void *>(value_), &v_, sizeof(YdsValue));
+        v_.init();
+        state_ = YDS_ASYNC_END;
+        return;
+    }
+    YdsJson::YdsFrame* f = static_cast<YdsJson::YdsFrame *>(c.get_stack(frame_));
+    if (f->type == YDS_ARRAY)
+        memcpy(c.buff_push(sizeof(YdsValue)), &v_, sizeof(YdsValue));
+    else
+        memcpy(static_cast<void *>(&static_cast<YdsMember *>(c.get_stack(c.get_top() - sizeof(YdsMember)))->v),
+               &v_, sizeof(YdsValue));
+    v_.init();
+    static_cast<YdsJson::YdsFrame *>(c.get_stack(frame_))->size++;
+    state_ = YDS_ASYNC_NEXT;
+}
+
+yds_async_status YdsAsyncParser::fail(int ret, bool in_child) {
+    v_.destroy();
+    json_.unwind_frames(frame_, in_child);
+    frame_ = YDS_NO_FRAME;
+    json_.keys_.clear();
+    json_.error_.code = ret;
+    json_.error_.offset = base_ + (json_.context_.get_context() - in_.c_str());
+    value_->set_type(YDS_NULL);
+    state_ = YDS_ASYNC_FAILED;
+    return YDS_ASYNC_ERROR;
+}
+
+yds_async_status YdsAsyncParser::run() {
+    YdsJson& j = json_;
+    YdsContext& c = j.context_;
+    int ret = YDS_PARSE_OK;
+
+    while (true) {
+        if (state_ == YDS_ASYNC_FINISHED)
+            return YDS_ASYNC_DONE;
+        if (state_ == YDS_ASYNC_FAILED)
+            return YDS_ASYNC_ERROR;
+        if (spent_ >= budget_)
+            return YDS_ASYNC_YIELD;
+
+        /*跳过空白; 输入还没结束时缓冲区的结尾不能当成 '\0'*/
+        const char* start = in_.c_str() + pos_;
+        const char* p = start;
+        while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') p++;
+        pos_ = p - in_.c_str();
+        spent_ += p - start;
+        if (pos_ == in_.size() && !eof_)
+            return YDS_ASYNC_WANT_READ;
+        c.set_context(p);
+        char ch = *p;
+
+        switch (state_) {
+            case YDS_ASYNC_FIRST_ELEMENT:
+            case YDS_ASYNC_FIRST_MEMBER:
+                if (ch == (state_ == YDS_ASYNC_FIRST_ELEMENT ? ']' : '}')) {
+                    /*空数组/对象*/
+                    c.read_byte();
+                    frame_ = static_cast<YdsJson::YdsFrame *>(c.get_stack(frame_))->prev;
+                    c.buff_pop(sizeof(YdsJson::YdsFrame));
+                    j.depth_--;
+                    if (state_ == YDS_ASYNC_FIRST_ELEMENT)
+                        v_.set_array(nullptr, 0);
+                    else
+                        v_.set_object(nullptr, 0, 0);
+                    deliver();
+                    break;
+                }
+                state_ = state_ == YDS_ASYNC_FIRST_ELEMENT ? YDS_ASYNC_VALUE : YDS_ASYNC_KEY;
+                continue;
+
+            case YDS_ASYNC_VALUE:
+                if (ch == '[' || ch == '{') {
+                    if (j.depth_ + 1 > j.max_depth_)
+                        return fail(YDS_PARSE_DEPTH_EXCEEDED, true);
+                    c.read_byte();
+                    YdsJson::YdsFrame* f = static_cast<YdsJson::YdsFrame *>(c.buff_push(sizeof(YdsJson::YdsFrame)));
+                    f->prev = frame_;
+                    f->size = 0;
+                    f->type = ch == '[' ? YDS_ARRAY : YDS_OBJECT;
+                    frame_ = c.get_top() - sizeof(YdsJson::YdsFrame);
+                    j.depth_++;
+                    state_ = ch == '[' ? YDS_ASYNC_FIRST_ELEMENT : YDS_ASYNC_FIRST_MEMBER;
+                    break;
+                }
+                if (!token_ready(p))
+                    return YDS_ASYNC_WANT_READ;
+                j.value_ = &v_;
+                ret = j.parse_value();
+                j.value_ = nullptr;
+                if (ret != YDS_PARSE_OK)
+                    return fail(ret, true);
+                deliver();
+                break;
+
+            case YDS_ASYNC_KEY:
+                if (!key_ready(p))
+                    return YDS_ASYNC_WANT_READ;
+                if ((ret = j.push_member()) != YDS_PARSE_OK)
+                    return fail(ret, false);
+                state_ = YDS_ASYNC_VALUE;
+                break;
+
+            case YDS_ASYNC_NEXT: {
+                YdsJson::YdsFrame* f = static_cast<YdsJson::YdsFrame *>(c.get_stack(frame_));
+                if (ch == ',') {
+                    c.read_byte();
+                    state_ = f->type == YDS_ARRAY ? YDS_ASYNC_VALUE : YDS_ASYNC_KEY;
+                    break;
+                }
+                if (f->type == YDS_ARRAY && ch != ']')
+                    return fail(YDS_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, false);
+                if (f->type == YDS_OBJECT && ch != '}')
+                    return fail(YDS_PARSE_MISS_COMMA_OR_CURLY_BRACKET, false);
+                c.read_byte();
+
+                /*本层结束, 子元素出栈合成数组/对象, 再交给上一层*/
+                size_t size = f->size;
+                size_t prev = f->prev;
+                if (f->type == YDS_ARRAY)
+                    v_.set_array(static_cast<char *>(c.buff_pop(size*sizeof(YdsValue))), size);
+                else
+                    v_.set_object(static_cast<char *>(c.buff_pop(size*sizeof(YdsMember))), size*sizeof(YdsMember), size);
+                c.buff_pop(sizeof(YdsJson::YdsFrame));
+                frame_ = prev;
+                j.depth_--;
+                deliver();
+                break;
+            }
+
+            case YDS_ASYNC_END:
+                /*输入带长度, 按位置判断结尾: 根值之后的 '\0' 也是多余的字节*/
+                if (pos_ < in_.size())
+                    return fail(YDS_PARSE_ROOT_NOT_SINGULAR, false);
+                j.keys_.clear();
+                state_ = YDS_ASYNC_FINISHED;
+                continue;
+        }
+
+        const char* now = c.get_context();
+        spent_ += now - p;
+        pos_ = now - in_.c_str();
+        scan_ = 0;
+    }
+}
+
+/****************************************************************
+ * 可恢复的生成
+ * *************************************************************/
+YdsAsyncWriter::YdsAsyncWriter(const YdsValue* value, size_t budget)
+    : root_(value), out_pos_(0), written_(0), budget_(budget ? budget : 1), started_(false), failed_(false), errno_(0) {
+    assert(value);
+}
+
+/*NaN/Inf 写不成 json: 停止生成, 之后的调用都报告错误*/
+void YdsAsyncWriter::write_number(double num) {
+    if (!yds_write_number(out_, num)) {
+        failed_ = true;
+        stack_.clear();
+    }
+}
+
+void YdsAsyncWriter::write_value(const YdsValue* v) {
+    switch (v->get_type()) {
+        case YDS_NULL:   out_ += "null"; break;
+        case YDS_TRUE:   out_ += "true"; break;
+        case YDS_FALSE:  out_ += "false"; break;
+        case YDS_NUMBER: write_number(v->get_number()); break;
+        case YDS_STRING: yds_write_string(out_, v->get_string(), v->get_string_len()); break;
+        case YDS_ARRAY:
+            out_ += '[';
+            stack_.push_back(Frame{ v, 0 });
+            break;
+        case YDS_OBJECT:
+            out_ += '{';
+            stack_.push_back(Frame{ v, 0 });
+            break;
+    }
+}
+
+/*每次写出一个子元素, 直到 out_ 中有 limit 字节或者写完*/
+void YdsAsyncWriter::generate(size_t limit) {
+    while (out_.size() < limit) {
+        if (stack_.empty()) {
+            if (started_)
+                break;
+            started_ = true;
+            write_value(root_);
+            continue;
+        }
+        Frame& f = stack_.back();
+        const YdsValue* v = f.v;
+        size_t i = f.index++;
+        if (v->get_type() == YDS_ARRAY) {
+            if (i == v->get_array_size()) {
+                out_ += ']';
+                stack_.pop_back();
+                continue;
+            }
+            if (i) out_ += ',';
+            if (v->is_packed())
+                write_number(v->get_array_number(i));
+            else
+                write_value(v->get_array_element(i));
+        }
+        else {
+            if (i == v->get_object_size()) {
+                out_ += '}';
+                stack_.pop_back();
+                continue;
+            }
+            if (i) out_ += ',';
+            yds_write_string(out_, v->get_object_key(i), v->get_object_key_len(i));
+            out_ += ':';
+            write_value(v->get_object_value(i));
+        }
+    }
+}
+
+bool YdsAsyncWriter::next_chunk(const char** data, size_t* len) {
+    assert(data && len);
+    out_.clear();
+    if (failed_)
+        return false;
+    generate(budget_);
+    if (failed_)
+        return false;
+    *data = out_.data();
+    *len = out_.size();
+    written_ += out_.size();
+    return !out_.empty();
+}
+
+/**
+ * 先写完上次剩下的输出, 再继续生成, 直到 fd 写不进去、用完工作量或者写完
+*/
+yds_async_status YdsAsyncWriter::write_fd(int fd) {
+    size_t spent = 0;
+    while (true) {
+        if (out_pos_ == out_.size()) {
+            out_.clear();
+            out_pos_ = 0;
+            if (done())
+                return YDS_ASYNC_DONE;
+            if (spent >= budget_)
+                return YDS_ASYNC_YIELD;
+            generate(budget_ - spent);
+            if (failed_)
+                return YDS_ASYNC_ERROR;
+            spent += out_.size();
+            continue;
+        }
+        ssize_t n = ::write(fd, out_.data() + out_pos_, out_.size() - out_pos_);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return YDS_ASYNC_WANT_WRITE;
+            errno_ = errno;
+            return YDS_ASYNC_IO_ERROR;
+        }
+        out_pos_ += n;
+        written_ += n;
+    }
+}
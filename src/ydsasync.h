@@ -0,0 +1,150 @@
+#ifndef __YDSASYNC_H__
+#define __YDSASYNC_H__
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include "ydsjson.h"
+#include "ydssource.h"
+
+#define YDS_ASYNC_BUDGET        (64 << 10)  /*每次调用默认最多处理的字节数*/
+#define YDS_ASYNC_READ_SIZE     (64 << 10)  /*read_fd 每次 read 的字节数*/
+
+/**
+ * 异步解析/生成每次调用的结果
+*/
+typedef enum {
+    YDS_ASYNC_DONE,         /*已经完成*/
+    YDS_ASYNC_WANT_READ,    /*需要更多输入: fd 可读后再调用 read_fd, 或者调用 feed/finish*/
+    YDS_ASYNC_WANT_WRITE,   /*fd 暂时写不进去, 可写后再调用 write_fd*/
+    YDS_ASYNC_YIELD,        /*用完了本次的工作量, 让出事件循环, 稍后再调用同一个函数继续*/
+    YDS_ASYNC_ERROR,        /*解析错误, 见 get_error(); 生成时表示遇到了 NaN/Inf*/
+    YDS_ASYNC_IO_ERROR,     /*read/write 失败, 见 get_errno()*/
+} yds_async_status;
+
+/**
+ * 可恢复的解析器: 输入分段到达, 每段到达后只做有限的工作就返回, 不阻塞事件循环
+ *
+ *   YdsValue v;
+ *   YdsAsyncParser parser(&v);
+ *   // fd 可读时(fd 为非阻塞):
+ *   switch (parser.read_fd(fd)) {
+ *       case YDS_ASYNC_WANT_READ: 等待下一次可读; break;
+ *       case YDS_ASYNC_YIELD:     把 read_fd 重新排进事件循环; break;
+ *       case YDS_ASYNC_DONE:      使用 v; break;
+ *       default:                  parser.get_error() / get_errno();
+ *   }
+ *
+ * 输入来自其它地方时用 feed 追加数据、finish 表示结束, 返回值的含义相同, YIELD 之后调用 resume
+ * 阻塞的输入(文件、解压流)用 read_source, 见 ydssource.h
+ * 按非递归方式解析(YDS_PARSE_ITERATIVE), 支持 YDS_PARSE_VALIDATE_UTF8 和 YDS_PARSE_INTERN_KEYS
+ * 只在记号之间暂停, 单个字符串/数字总是一次解析完; 结果和错误码、错误路径与 parse 相同,
+ * 错误偏移从整个输入的开头算起, get_error() 的 line()/column() 不可用
+*/
+class YdsAsyncParser {
+public:
+    explicit YdsAsyncParser(YdsValue* value, unsigned flags = 0, size_t budget = YDS_ASYNC_BUDGET);
+    ~YdsAsyncParser();
+    YdsAsyncParser(const YdsAsyncParser&) = delete;
+    YdsAsyncParser& operator=(const YdsAsyncParser&) = delete;
+
+    yds_async_status feed(const char* data, size_t len);
+    yds_async_status finish();
+    yds_async_status resume();
+    yds_async_status read_fd(int fd);
+    /*每次从 src 读取 window 字节, 直到完成、出错或者用完工作量; src 出错时返回 YDS_ASYNC_IO_ERROR, 原因见 src 的 get_error()*/
+    yds_async_status read_source(YdsSource* src, size_t window = YDS_SOURCE_WINDOW);
+
+    void set_max_depth(size_t depth) { json_.set_max_depth(depth); }
+    const YdsErrorInfo& get_error() const { return json_.get_error(); }
+    int get_errno() const { return errno_; }
+    size_t get_offset() const { return base_ + pos_; }     /*已经解析的字节数*/
+
+private:
+    enum {
+        YDS_ASYNC_VALUE,            /*下一个记号是值*/
+        YDS_ASYNC_FIRST_ELEMENT,    /*刚读过 '['*/
+        YDS_ASYNC_FIRST_MEMBER,     /*刚读过 '{'*/
+        YDS_ASYNC_KEY,              /*下一个记号是键*/
+        YDS_ASYNC_NEXT,             /*子元素之后, 期望 ',' 或结束符*/
+        YDS_ASYNC_END,              /*根值之后只能有空白*/
+        YDS_ASYNC_FINISHED,
+        YDS_ASYNC_FAILED,
+    };
+
+    yds_async_status run();
+    void deliver();
+    yds_async_status fail(int ret, bool in_child);
+    const char* string_end(const char* p);
+    bool token_ready(const char* p);
+    bool key_ready(const char* p);
+    void compact();
+
+    YdsJson json_;          /*提供解析栈和各个记号的解析*/
+    YdsValue* value_;
+    YdsValue v_;            /*刚完成、还没有交给上一层的值*/
+    std::string in_;        /*缓冲的输入, 前 pos_ 字节已经解析*/
+    size_t pos_;
+    size_t base_;           /*in_ 之前已经丢弃的字节数*/
+    size_t scan_;           /*未完成的记号已经检查到的位置, 新数据到达后从这里继续*/
+    size_t frame_;          /*当前层的帧在解析栈上的偏移*/
+    size_t budget_;
+    size_t spent_;          /*本次调用已经处理的字节数*/
+    int state_;
+    bool eof_;
+    int errno_;
+};
+
+/**
+ * 可恢复的生成器: 把 YdsValue 以紧凑格式分段写出, 每次调用最多生成 budget 字节
+ *
+ *   YdsAsyncWriter writer(&v);
+ *   // fd 可写时(fd 为非阻塞):
+ *   switch (writer.write_fd(fd)) {
+ *       case YDS_ASYNC_WANT_WRITE: 等待下一次可写; break;
+ *       case YDS_ASYNC_YIELD:      把 write_fd 重新排进事件循环; break;
+ *       case YDS_ASYNC_DONE:       写完了; break;
+ *       default:                   writer.get_errno();
+ *   }
+ *
+ * 不写 fd 时用 next_chunk 逐段取出输出
+ * 遇到 NaN/Inf 时停止生成: write_fd 返回 YDS_ASYNC_ERROR, next_chunk 返回 false 并且 failed() 为 true
+ * 写出期间 value 不能被修改或释放; 单个字符串总是完整生成
+*/
+class YdsAsyncWriter {
+public:
+    explicit YdsAsyncWriter(const YdsValue* value, size_t budget = YDS_ASYNC_BUDGET);
+    YdsAsyncWriter(const YdsAsyncWriter&) = delete;
+    YdsAsyncWriter& operator=(const YdsAsyncWriter&) = delete;
+
+    yds_async_status write_fd(int fd);
+    /*生成下一段输出, data 在下一次调用前有效; 没有更多输出时返回 false*/
+    bool next_chunk(const char** data, size_t* len);
+
+    int get_errno() const { return errno_; }
+    size_t get_bytes_written() const { return written_; }
+    bool failed() const { return failed_; }
+
+private:
+    struct Frame {
+        const YdsValue* v;
+        size_t index;       /*下一个要写的子元素*/
+    };
+
+    bool done() const { return started_ && stack_.empty(); }
+    void generate(size_t limit);
+    void write_value(const YdsValue* v);
+    void write_number(double num);
+
+    const YdsValue* root_;
+    std::vector<Frame> stack_;
+    std::string out_;
+    size_t out_pos_;        /*out_ 中已经写出的字节*/
+    size_t written_;
+    size_t budget_;
+    bool started_;
+    bool failed_;
+    int errno_;
+};
+
+#endif // !__YDSASYNC_H__
@@ -0,0 +1,34 @@
+#include "ydsbatch.h"
+
+/**
+ * 在 batch 的区域分配器里解析最多 max_docs 个根值
+ * 解析栈和驻留表的槽位不能放进区域分配器(reset 后还要继续使用), 固定用调用时线程的分配器
+ * 驻留的键属于文档, 在本批结束前释放表中的引用
+*/
+size_t YdsJson::next_batch(YdsBatch* batch, size_t max_docs) {
+    assert(batch && max_docs > 0 && iter_.many);
+    batch->clear();
+    if (!iter_.active)
+        return 0;
+
+    const YdsAllocator* outer = yds_get_allocator();
+    context_.pin_allocator(outer);
+    keys_.pin_allocator(outer);
+    {
+        YdsAllocatorScope scope(batch->arena_.allocator());
+        batch->docs_ = static_cast<YdsValue *>(yds_malloc(max_docs * sizeof(YdsValue)));
+        batch->offsets_.resize(max_docs);
+        size_t n = 0;
+        for (; n < max_docs; ++n) {
+            batch->docs_[n].init();
+            if (!next_document(&batch->docs_[n], &batch->offsets_[n]))
+                break;
+        }
+        batch->size_ = n;
+        batch->offsets_.resize(n);
+        keys_.clear();
+    }
+    context_.pin_allocator(nullptr);
+    keys_.pin_allocator(nullptr);
+    return batch->size_;
+}
@@ -0,0 +1,51 @@
+#ifndef __YDSBATCH_H__
+#define __YDSBATCH_H__
+
+#include <stddef.h>
+#include <vector>
+#include "ydsjson.h"
+
+/**
+ * 一批文档, 所有节点、字符串和键都从同一个区域分配器申请
+ * 每批只有一次 reset, 不逐个释放节点
+ *
+ *   YdsJson json;
+ *   YdsBatch batch;
+ *   json.begin_many(text);
+ *   while (size_t n = json.next_batch(&batch, 256)) {
+ *       for (size_t i = 0; i < n; ++i) use(batch[i], batch.get_offset(i));
+ *   }
+ *   if (json.get_error().code != YDS_PARSE_OK) ...
+ *
+ * 批内的文档只读: 修改会用线程当前的分配器申请/释放, 与区域分配器混用
+ * 需要保留或修改的文档用 clone 拷贝出来(副本的节点和键都用线程当前的分配器申请, 与批无关);
+ * 下一次 next_batch 或 clear 后批内文档全部失效
+*/
+class YdsBatch {
+public:
+    explicit YdsBatch(size_t block_size = YDS_ARENA_BLOCK_SIZE) : arena_(block_size), docs_(nullptr), size_(0) {}
+    YdsBatch(const YdsBatch&) = delete;
+    YdsBatch& operator=(const YdsBatch&) = delete;
+
+    size_t size() const { return size_; }
+    const YdsValue& operator[](size_t index) const { assert(index < size_); return docs_[index]; }
+    size_t get_offset(size_t index) const { assert(index < size_); return offsets_[index]; }    /*在输入中的字节偏移*/
+    size_t get_bytes_used() const { return arena_.get_used(); }
+    /*回收整批文档的内存, 区域分配器的块留给下一批*/
+    void clear() {
+        arena_.reset();
+        docs_ = nullptr;
+        size_ = 0;
+        offsets_.clear();
+    }
+
+private:
+    friend class YdsJson;
+
+    YdsArenaAllocator arena_;
+    YdsValue* docs_;            /*在区域分配器中, 不调用析构函数*/
+    size_t size_;
+    std::vector<size_t> offsets_;
+};
+
+#endif // !__YDSBATCH_H__
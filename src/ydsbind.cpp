@@ -0,0 +1,61 @@
+#include "ydsbind.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * 追加带引号的字符串, 按 json 规则转义
+*/
+void yds_write_string(std::string& out, const char* s, size_t len) {
+    static const char hex_digits[] = "0123456789ABCDEF";
+    out += '"';
+    const char* run = s;
+    const char* end = s + len;
+    for (const char* p = s; p < end; ++p) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+        out.append(run, p - run);
+        run = p + 1;
+        switch (c) {
+            case '\"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                out += "\\u00";
+                out += hex_digits[c >> 4];
+                out += hex_digits[c & 15];
+        }
+    }
+    out.append(run, end - run);
+    out += '"';
+}
+
+/**
+ * 追加数字, 优先使用能还原出同一个 double 的最短精度
+ * NaN/Inf 不是合法的 json, 不追加并返回 false
+*/
+bool yds_write_number(std::string& out, double num) {
+    if (!isfinite(num))
+        return false;
+    char buf[32];
+    int len = snprintf(buf, sizeof(buf), "%.15g", num);
+    if (strtod(buf, nullptr) != num)
+        len = snprintf(buf, sizeof(buf), "%.17g", num);
+    out.append(buf, len);
+    return true;
+}
+
+void yds_write_integer(std::string& out, long long num) {
+    char buf[24];
+    out.append(buf, snprintf(buf, sizeof(buf), "%lld", num));
+}
+
+void yds_write_unsigned(std::string& out, unsigned long long num) {
+    char buf[24];
+    out.append(buf, snprintf(buf, sizeof(buf), "%llu", num));
+}
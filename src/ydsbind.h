@@ -0,0 +1,430 @@
+#ifndef __YDSBIND_H__
+#define __YDSBIND_H__
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <array>
+#include <limits>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "ydsjson.h"
+
+/**
+ * 结构体绑定: 直接在 json 文本和 C++ 结构体之间转换, 不生成 YdsValue 树
+ *
+ *   struct Point { double x, y; std::string tag; std::vector<int> ids; };
+ *   YDS_BIND(Point, YDS_FIELD(Point, x), YDS_FIELD(Point, y), YDS_FIELD(Point, tag), YDS_FIELD(Point, ids));
+ *
+ *   Point p;
+ *   YdsJson json;
+ *   json.parse_into(&p, "{\"x\":1,\"y\":2,\"tag\":\"a\",\"ids\":[1,2]}");
+ *   std::string str;
+ *   yds_stringify(p, str);
+ *
+ * 支持的字段类型: 数字、bool、std::string、std::vector、已绑定的结构体
+ * 未声明的键会被跳过, 值为 null 的字段保持原值
+*/
+
+template <typename T, typename M>
+struct YdsField {
+    const char* name;
+    size_t len;
+    M T::* member;
+};
+
+template <typename T, typename M, size_t N>
+constexpr YdsField<T, M> yds_field(const char (&name)[N], M T::* member) {
+    return YdsField<T, M>{ name, N - 1, member };
+}
+
+/*为结构体声明字段列表, 必须在全局命名空间中使用*/
+template <typename T> struct YdsFields;
+
+#define YDS_FIELD(T, name)  yds_field(#name, &T::name)
+#define YDS_BIND(T, ...) \
+    template <> struct YdsFields<T> { \
+        static constexpr auto fields = std::make_tuple(__VA_ARGS__); \
+    }
+
+template <typename T, typename = void>
+struct YdsIsBound : std::false_type {};
+template <typename T>
+struct YdsIsBound<T, decltype(static_cast<void>(YdsFields<T>::fields))> : std::true_type {};
+
+/****************************************************************
+ * 编译期完美哈希: 为字段名找一个种子, 使所有字段落在不同的槽里
+ * *************************************************************/
+struct YdsName {
+    const char* s;
+    size_t len;
+};
+
+/*槽数取不小于 8 倍字段数的 2 的幂, 保证很快能找到种子*/
+constexpr size_t yds_table_size(size_t n) {
+    size_t size = 1;
+    while (size < n * 8) size <<= 1;
+    return size;
+}
+
+#define YDS_BIND_NO_SEED    0xFFFFFFFFu
+
+template <size_t N, size_t M>
+constexpr uint32_t yds_find_seed(const std::array<YdsName, N>& names) {
+    for (uint32_t seed = 0; seed < 65536; ++seed) {
+        bool used[M] = {};
+        bool ok = true;
+        for (size_t i = 0; i < N && ok; ++i) {
+            size_t slot = yds_key_hash(names[i].s, names[i].len, seed) & (M - 1);
+            if (used[slot]) ok = false;
+            used[slot] = true;
+        }
+        if (ok) return seed;
+    }
+    return YDS_BIND_NO_SEED;
+}
+
+template <size_t N, size_t M>
+constexpr std::array<short, M> yds_build_table(const std::array<YdsName, N>& names, uint32_t seed) {
+    std::array<short, M> table = {};
+    for (size_t i = 0; i < M; ++i) table[i] = -1;
+    for (size_t i = 0; i < N; ++i)
+        table[yds_key_hash(names[i].s, names[i].len, seed) & (M - 1)] = static_cast<short>(i);
+    return table;
+}
+
+template <typename Tuple, size_t... I>
+constexpr std::array<YdsName, sizeof...(I)> yds_field_names(const Tuple& fields, std::index_sequence<I...>) {
+    return {{ YdsName{ std::get<I>(fields).name, std::get<I>(fields).len }... }};
+}
+
+template <typename T>
+struct YdsKeyIndex {
+    typedef typename std::decay<decltype(YdsFields<T>::fields)>::type Tuple;
+    static constexpr size_t count = std::tuple_size<Tuple>::value;
+    static constexpr size_t size = yds_table_size(count);
+    static constexpr std::array<YdsName, count> names =
+        yds_field_names(YdsFields<T>::fields, std::make_index_sequence<count>());
+    static constexpr uint32_t seed = yds_find_seed<count, size>(names);
+    static_assert(seed != YDS_BIND_NO_SEED, "duplicate field names in YDS_BIND");
+    static constexpr std::array<short, size> table = yds_build_table<count, size>(names, seed);
+
+    /*返回字段下标, 不是已声明的字段返回 -1*/
+    static int find(const char* key, size_t len) {
+        int i = table[yds_key_hash(key, len, seed) & (size - 1)];
+        if (i < 0 || names[i].len != len || memcmp(names[i].s, key, len) != 0)
+            return -1;
+        return i;
+    }
+};
+
+/****************************************************************
+ * 解析: 每种字段类型对应一个 YdsReader
+ * *************************************************************/
+
+/*null 保持字段原值, 否则按类型读取*/
+template <typename T>
+int yds_read_value(YdsJson& json, T* out) {
+    if (*json.context_.get_context() == 'n')
+        return json.skip_literal("null");
+    return YdsReader<T>::read(json, out);
+}
+
+template <typename T>
+struct YdsReader<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+    static int read(YdsJson& json, T* out) {
+        char ch = *json.context_.get_context();
+        if (ch != '-' && (ch < '0' || ch > '9'))
+            return YDS_PARSE_TYPE_MISMATCH;
+        double num;
+        int ret;
+        if ((ret = json.parse_number_raw(&num)) == YDS_PARSE_OK)
+            *out = static_cast<T>(num);
+        return ret;
+    }
+};
+
+/**
+ * 整数字段只接受不带小数和指数部分的数字, 与 YDS_COLUMN_INT64 相同
+ * 不经过 double, 64 位整数不丢精度; 超出 T 的范围返回 YDS_PARSE_NUMBER_TOO_BIG
+*/
+template <typename T>
+struct YdsReader<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type> {
+    static int read(YdsJson& json, T* out) {
+        const char* start = json.context_.get_context();
+        if (*start != '-' && (*start < '0' || *start > '9'))
+            return YDS_PARSE_TYPE_MISMATCH;
+        const char* end = json.scan_number(start);
+        if (!end)
+            return YDS_PARSE_INVALID_VALUE;
+        if (memchr(start, '.', end - start) || memchr(start, 'e', end - start) || memchr(start, 'E', end - start))
+            return YDS_PARSE_TYPE_MISMATCH;
+        errno = 0;
+        if constexpr (std::is_signed<T>::value) {
+            long long n = strtoll(start, NULL, 10);
+            if (errno == ERANGE || n < std::numeric_limits<T>::min() || n > std::numeric_limits<T>::max())
+                return YDS_PARSE_NUMBER_TOO_BIG;
+            *out = static_cast<T>(n);
+        }
+        else {
+            /*strtoull 会把负数取反, 负数只允许 -0*/
+            if (*start == '-' && (end - start != 2 || start[1] != '0'))
+                return YDS_PARSE_NUMBER_TOO_BIG;
+            unsigned long long n = strtoull(start, NULL, 10);
+            if (errno == ERANGE || n > std::numeric_limits<T>::max())
+                return YDS_PARSE_NUMBER_TOO_BIG;
+            *out = static_cast<T>(n);
+        }
+        json.context_.set_context(end);
+        return YDS_PARSE_OK;
+    }
+};
+
+template <>
+struct YdsReader<bool> {
+    static int read(YdsJson& json, bool* out) {
+        switch (*json.context_.get_context()) {
+            case 't': *out = true;  return json.skip_literal("true");
+            case 'f': *out = false; return json.skip_literal("false");
+            default:  return YDS_PARSE_TYPE_MISMATCH;
+        }
+    }
+};
+
+template <>
+struct YdsReader<std::string> {
+    static int read(YdsJson& json, std::string* out) {
+        if (*json.context_.get_context() != '"')
+            return YDS_PARSE_TYPE_MISMATCH;
+        char* s;
+        size_t len;
+        int ret;
+        if ((ret = json.parse_string_raw(&s, &len)) == YDS_PARSE_OK)
+            out->assign(s, len);
+        return ret;
+    }
+};
+
+template <typename E>
+struct YdsReader<std::vector<E> > {
+    static int read(YdsJson& json, std::vector<E>* out) {
+        if (*json.context_.get_context() != '[')
+            return YDS_PARSE_TYPE_MISMATCH;
+        if (++json.depth_ > json.max_depth_) {
+            json.depth_--;
+            return YDS_PARSE_DEPTH_EXCEEDED;
+        }
+        int ret = read_elements(json, out);
+        json.depth_--;
+        return ret;
+    }
+
+    static int read_elements(YdsJson& json, std::vector<E>* out) {
+        int ret;
+        out->clear();
+        json.context_.read_byte();
+        json.parse_whitespace();
+        if (*json.context_.get_context() == ']') {
+            json.context_.read_byte();
+            return YDS_PARSE_OK;
+        }
+        while (true) {
+            out->emplace_back();
+            if ((ret = yds_read_value(json, &out->back())) != YDS_PARSE_OK)
+                return ret;
+            json.parse_whitespace();
+            if (*json.context_.get_context() == ',') {
+                json.context_.read_byte();
+                json.parse_whitespace();
+            }
+            else if (*json.context_.get_context() == ']') {
+                json.context_.read_byte();
+                return YDS_PARSE_OK;
+            }
+            else
+                return YDS_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+        }
+    }
+};
+
+template <typename T>
+struct YdsReader<T, typename std::enable_if<YdsIsBound<T>::value>::type> {
+    typedef YdsKeyIndex<T> Index;
+
+    static int read(YdsJson& json, T* out) {
+        if (*json.context_.get_context() != '{')
+            return YDS_PARSE_TYPE_MISMATCH;
+        if (++json.depth_ > json.max_depth_) {
+            json.depth_--;
+            return YDS_PARSE_DEPTH_EXCEEDED;
+        }
+        int ret = read_members(json, out);
+        json.depth_--;
+        return ret;
+    }
+
+    static int read_members(YdsJson& json, T* out) {
+        int ret;
+        json.context_.read_byte();
+        json.parse_whitespace();
+        if (*json.context_.get_context() == '}') {
+            json.context_.read_byte();
+            return YDS_PARSE_OK;
+        }
+        while (true) {
+            char* key;
+            size_t len;
+            if (*json.context_.get_context() != '"')
+                return YDS_PARSE_MISS_KEY;
+            if ((ret = json.parse_string_raw(&key, &len)) != YDS_PARSE_OK)
+                return ret;
+            /*键在解析栈上, 下一次入栈之前一直有效*/
+            int index = Index::find(key, len);
+            json.parse_whitespace();
+            if (*json.context_.get_context() != ':')
+                return YDS_PARSE_MISS_COLON;
+            json.context_.read_byte();
+            json.parse_whitespace();
+
+            if (index < 0)
+                ret = json.skip_value();
+            else
+                ret = read_field(json, out, index, std::make_index_sequence<Index::count>());
+            if (ret != YDS_PARSE_OK)
+                return ret;
+
+            json.parse_whitespace();
+            if (*json.context_.get_context() == ',') {
+                json.context_.read_byte();
+                json.parse_whitespace();
+            }
+            else if (*json.context_.get_context() == '}') {
+                json.context_.read_byte();
+                return YDS_PARSE_OK;
+            }
+            else
+                return YDS_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+        }
+    }
+
+    /*把运行时的字段下标展开成对应成员的读取*/
+    template <size_t... I>
+    static int read_field(YdsJson& json, T* out, int index, std::index_sequence<I...>) {
+        int ret = YDS_PARSE_OK;
+        static_cast<void>((... || (static_cast<int>(I) == index &&
+            (ret = yds_read_value(json, &(out->*(std::get<I>(YdsFields<T>::fields).member))), true))));
+        return ret;
+    }
+};
+
+/**
+ * 直接把 json 解析到结构体
+*/
+template <typename T>
+int YdsJson::parse_into(T* out, const char* json, unsigned flags) {
+    assert(json && out);
+    context_.set_context(json);
+    flags_ = flags;
+    depth_ = 0;
+
+    int ret;
+    parse_whitespace();
+    if ((ret = yds_read_value(*this, out)) == YDS_PARSE_OK) {
+        parse_whitespace();
+        if (*context_.get_context() != '\0')
+            ret = YDS_PARSE_ROOT_NOT_SINGULAR;
+    }
+    assert(context_.get_top() == 0);
+    return ret;
+}
+
+/****************************************************************
+ * 生成: 与解析使用同一份字段声明
+ * *************************************************************/
+void yds_write_string(std::string& out, const char* s, size_t len);
+bool yds_write_number(std::string& out, double num);
+void yds_write_integer(std::string& out, long long num);
+void yds_write_unsigned(std::string& out, unsigned long long num);
+
+/*write 返回 false 表示遇到了不能表示为 json 的值(NaN/Inf)*/
+template <typename T, typename Enable = void> struct YdsWriter;
+
+template <typename T>
+struct YdsWriter<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+    static bool write(const T& v, std::string& out) { return yds_write_number(out, static_cast<double>(v)); }
+};
+
+/*整数按原值写出, 不经过 double, 超过 2^53 也不丢精度*/
+template <typename T>
+struct YdsWriter<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type> {
+    static bool write(const T& v, std::string& out) {
+        if (std::is_signed<T>::value)
+            yds_write_integer(out, static_cast<long long>(v));
+        else
+            yds_write_unsigned(out, static_cast<unsigned long long>(v));
+        return true;
+    }
+};
+
+template <>
+struct YdsWriter<bool> {
+    static bool write(bool v, std::string& out) { out += v ? "true" : "false"; return true; }
+};
+
+template <>
+struct YdsWriter<std::string> {
+    static bool write(const std::string& v, std::string& out) { yds_write_string(out, v.data(), v.size()); return true; }
+};
+
+template <typename E>
+struct YdsWriter<std::vector<E> > {
+    static bool write(const std::vector<E>& v, std::string& out) {
+        out += '[';
+        for (size_t i = 0; i < v.size(); ++i) {
+            if (i) out += ',';
+            if (!YdsWriter<E>::write(v[i], out))
+                return false;
+        }
+        out += ']';
+        return true;
+    }
+};
+
+template <typename T>
+struct YdsWriter<T, typename std::enable_if<YdsIsBound<T>::value>::type> {
+    static bool write(const T& v, std::string& out) {
+        out += '{';
+        if (!write_fields(v, out, std::make_index_sequence<YdsKeyIndex<T>::count>()))
+            return false;
+        out += '}';
+        return true;
+    }
+
+    template <size_t... I>
+    static bool write_fields(const T& v, std::string& out, std::index_sequence<I...>) {
+        return (... && write_field(v, out, std::get<I>(YdsFields<T>::fields), I));
+    }
+
+    template <typename M>
+    static bool write_field(const T& v, std::string& out, const YdsField<T, M>& field, size_t index) {
+        if (index) out += ',';
+        yds_write_string(out, field.name, field.len);
+        out += ':';
+        return YdsWriter<M>::write(v.*(field.member), out);
+    }
+};
+
+/**
+ * 把结构体以紧凑格式追加到 out
+ * 字段中有 NaN/Inf 时返回 false, 此时 out 中的内容不完整
+*/
+template <typename T>
+bool yds_stringify(const T& v, std::string& out) {
+    return YdsWriter<T>::write(v, out);
+}
+
+#endif // !__YDSBIND_H__
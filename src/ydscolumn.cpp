@@ -0,0 +1,289 @@
+#include "ydscolumn.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+/*键名转成 JSON Pointer, 已经是 pointer 的保持不变*/
+static std::string column_pointer(const char* pointer) {
+    if (*pointer == '/')
+        return pointer;
+    std::string ret("/");
+    for (const char* p = pointer; *p; ++p) {
+        if (*p == '~') ret += "~0";
+        else if (*p == '/') ret += "~1";
+        else ret += *p;
+    }
+    return ret;
+}
+
+YdsColumn::YdsColumn(const char* pointer, yds_column_type type)
+    : pointer_(column_pointer(pointer)), type_(type), rows_(0), nulls_(0), match_(0) {
+    /*按 RFC 6901 拆成各段, '~0' 还原为 '~', '~1' 还原为 '/'*/
+    for (size_t i = 0; i < pointer_.size(); ++i) {
+        if (pointer_[i] == '/')
+            path_.push_back(std::string());
+        else if (pointer_[i] == '~' && i + 1 < pointer_.size() && (pointer_[i + 1] == '0' || pointer_[i + 1] == '1'))
+            path_.back() += pointer_[++i] == '0' ? '~' : '/';
+        else
+            path_.back() += pointer_[i];
+    }
+    offsets_.push_back(0);
+}
+
+void YdsColumn::clear() {
+    rows_ = 0;
+    nulls_ = 0;
+    match_ = 0;
+    validity_.clear();
+    f64_.clear();
+    i64_.clear();
+    bools_.clear();
+    offsets_.assign(1, 0);
+    data_.clear();
+}
+
+/*调用者已经追加了这一行的值*/
+void YdsColumn::push_valid() {
+    if ((rows_ & 7) == 0)
+        validity_.push_back(0);
+    validity_[rows_ >> 3] |= static_cast<uint8_t>(1 << (rows_ & 7));
+    rows_++;
+}
+
+void YdsColumn::push_null() {
+    switch (type_) {
+        case YDS_COLUMN_DOUBLE: f64_.push_back(0); break;
+        case YDS_COLUMN_INT64:  i64_.push_back(0); break;
+        case YDS_COLUMN_BOOL:   bools_.push_back(0); break;
+        case YDS_COLUMN_STRING: offsets_.push_back(data_.size()); break;
+    }
+    if ((rows_ & 7) == 0)
+        validity_.push_back(0);
+    rows_++;
+    nulls_++;
+}
+
+size_t YdsColumns::add(const char* pointer, yds_column_type type) {
+    assert(pointer && rows_ == 0);
+    YdsColumn column(pointer, type);
+    /*按解码后的各段比较, "/ab" 不是 "/a" 的延伸; 相同的 pointer 也算作前缀*/
+    for (const YdsColumn& c : columns_) {
+        size_t n = c.path_.size() < column.path_.size() ? c.path_.size() : column.path_.size();
+        if (std::equal(c.path_.begin(), c.path_.begin() + n, column.path_.begin()))
+            return YDS_COLUMN_INVALID;
+    }
+    columns_.push_back(std::move(column));
+    return columns_.size() - 1;
+}
+
+const YdsColumn* YdsColumns::find(const char* pointer) const {
+    std::string p = column_pointer(pointer);
+    for (const YdsColumn& c : columns_)
+        if (c.pointer_ == p) return &c;
+    return nullptr;
+}
+
+void YdsColumns::clear() {
+    for (YdsColumn& c : columns_)
+        c.clear();
+    rows_ = 0;
+}
+
+/**
+ * 逐条解析记录, 声明过的字段直接追加到对应的列, 其它值只做语法检查
+ * 失败时清空 out, 错误信息与 begin_array/next_element 相同
+*/
+int YdsJson::parse_columns(YdsColumns* out, const char* json, const char* pointer, unsigned flags) {
+    assert(out);
+    out->clear();
+    int ret;
+    if ((ret = begin_array(json, pointer, flags)) != YDS_PARSE_OK)
+        return ret;
+
+    while (iter_.active) {
+        if (iter_.index > 0) {
+            parse_whitespace();
+            if (*context_.get_context() == ']') {
+                end_iteration(YDS_PARSE_OK);
+                break;
+            }
+            if (*context_.get_context() != ',') {
+                end_iteration(YDS_PARSE_MISS_COMMA_OR_SQUARE_BRACKET);
+                break;
+            }
+            context_.read_byte();
+            parse_whitespace();
+        }
+        const char* start = context_.get_context();
+        if (*start == '{')
+            ret = parse_record(out, 0);
+        else if ((ret = skip_value()) == YDS_PARSE_OK) {
+            context_.set_context(start);
+            ret = YDS_PARSE_TYPE_MISMATCH;      /*记录必须是对象*/
+        }
+        if (ret != YDS_PARSE_OK) {
+            error_path_index(iter_.index);
+            end_iteration(ret);
+            break;
+        }
+        /*本条记录里没有出现的字段记为空值*/
+        for (YdsColumn& c : out->columns_)
+            if (c.rows_ == out->rows_) c.push_null();
+        out->rows_++;
+        iter_.index++;
+    }
+    assert(context_.get_top() == 0);
+    if ((ret = error_.code) != YDS_PARSE_OK)
+        out->clear();
+    return ret;
+}
+
+/**
+ * 解析记录中第 level 层的一个对象
+ * 列的 match_ 等于 level 说明它的前 level 段与当前路径相同, 只有这些列需要和键比较
+*/
+int YdsJson::parse_record(YdsColumns* out, size_t level) {
+    int ret;
+    if (++depth_ > max_depth_) {
+        depth_--;
+        return YDS_PARSE_DEPTH_EXCEEDED;
+    }
+    context_.read_byte();
+    parse_whitespace();
+    if (*context_.get_context() == '}') {
+        context_.read_byte();
+        depth_--;
+        return YDS_PARSE_OK;
+    }
+    while (true) {
+        char* key;
+        size_t len;
+        if (*context_.get_context() != '"') {
+            ret = YDS_PARSE_MISS_KEY;
+            break;
+        }
+        size_t key_top = context_.get_top();
+        if ((ret = parse_string_raw(&key, &len)) != YDS_PARSE_OK)
+            break;
+        /*解码后的键刚刚出栈, 重新占住这段内存, 出错时还要用它构造路径*/
+        if (len) context_.buff_push(len);
+
+        YdsColumn* leaf = nullptr;
+        bool deeper = false;
+        for (YdsColumn& c : out->columns_) {
+            if (c.match_ != level || c.path_[level].size() != len ||
+                memcmp(c.path_[level].data(), context_.get_stack(key_top), len) != 0)
+                continue;
+            if (c.path_.size() == level + 1)
+                leaf = &c;
+            else {
+                c.match_ = level + 1;
+                deeper = true;
+            }
+        }
+
+        parse_whitespace();
+        if (*context_.get_context() != ':')
+            ret = YDS_PARSE_MISS_COLON;
+        else {
+            context_.read_byte();
+            parse_whitespace();
+            if (leaf && leaf->rows_ == out->rows_)
+                ret = parse_column_value(leaf);
+            else if (deeper && *context_.get_context() == '{')
+                ret = parse_record(out, level + 1);
+            else
+                ret = skip_value();     /*未声明的字段, 重复的键只取第一个*/
+            if (ret != YDS_PARSE_OK)
+                error_path_key(len ? static_cast<char *>(context_.get_stack(key_top)) : "", len);
+        }
+        for (YdsColumn& c : out->columns_)
+            if (c.match_ > level) c.match_ = level;
+        context_.set_top(key_top);
+        if (ret != YDS_PARSE_OK)
+            break;
+
+        parse_whitespace();
+        if (*context_.get_context() == ',') {
+            context_.read_byte();
+            parse_whitespace();
+        }
+        else if (*context_.get_context() == '}') {
+            context_.read_byte();
+            break;
+        }
+        else {
+            ret = YDS_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+            break;
+        }
+    }
+    depth_--;
+    return ret;
+}
+
+/**
+ * 把一个值按列的类型追加到列尾
+ * 类型不符时先按语法跳过, 语法错误优先报告, 再停在值的开头报告 YDS_PARSE_TYPE_MISMATCH
+*/
+int YdsJson::parse_column_value(YdsColumn* column) {
+    const char* start = context_.get_context();
+    char ch = *start;
+    int ret;
+    if (ch == 'n') {
+        if ((ret = skip_literal("null")) == YDS_PARSE_OK)
+            column->push_null();
+        return ret;
+    }
+
+    bool number = ch == '-' || (ch >= '0' && ch <= '9');
+    switch (column->type_) {
+        case YDS_COLUMN_DOUBLE: {
+            if (!number) break;
+            double d;
+            if ((ret = parse_number_raw(&d)) == YDS_PARSE_OK) {
+                column->f64_.push_back(d);
+                column->push_valid();
+            }
+            return ret;
+        }
+        case YDS_COLUMN_INT64: {
+            if (!number) break;
+            const char* end = scan_number(start);
+            if (!end)
+                return YDS_PARSE_INVALID_VALUE;
+            if (memchr(start, '.', end - start) || memchr(start, 'e', end - start) || memchr(start, 'E', end - start))
+                return YDS_PARSE_TYPE_MISMATCH;
+            errno = 0;
+            long long n = strtoll(start, NULL, 10);
+            if (errno == ERANGE)
+                return YDS_PARSE_NUMBER_TOO_BIG;
+            column->i64_.push_back(n);
+            column->push_valid();
+            context_.set_context(end);
+            return YDS_PARSE_OK;
+        }
+        case YDS_COLUMN_BOOL:
+            if (ch != 't' && ch != 'f') break;
+            if ((ret = skip_literal(ch == 't' ? "true" : "false")) == YDS_PARSE_OK) {
+                column->bools_.push_back(ch == 't');
+                column->push_valid();
+            }
+            return ret;
+        case YDS_COLUMN_STRING: {
+            if (ch != '"') break;
+            char* s;
+            size_t len;
+            if ((ret = parse_string_raw(&s, &len)) == YDS_PARSE_OK) {
+                column->data_.append(s, len);
+                column->offsets_.push_back(column->data_.size());
+                column->push_valid();
+            }
+            return ret;
+        }
+    }
+    if ((ret = skip_value()) != YDS_PARSE_OK)
+        return ret;
+    context_.set_context(start);
+    return YDS_PARSE_TYPE_MISMATCH;
+}
@@ -0,0 +1,110 @@
+#ifndef __YDSCOLUMN_H__
+#define __YDSCOLUMN_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "ydsjson.h"
+
+/**
+ * 列式加载: 把记录数组直接解析成按字段连续存放的列, 不生成 YdsValue
+ *
+ *   YdsColumns cols;
+ *   size_t ts = cols.add("ts", YDS_COLUMN_INT64);
+ *   size_t v = cols.add("/data/v", YDS_COLUMN_DOUBLE);
+ *   YdsJson json;
+ *   json.parse_columns(&cols, "[{\"ts\":1,\"data\":{\"v\":0.5}}, {\"ts\":2}]");
+ *   const double* values = cols[v].get_doubles();     // values[1] 为 0, cols[v].is_null(1) 为 true
+ *
+ * 没有声明的键直接跳过; 记录里缺失或为 null 的字段记为空值
+*/
+#define YDS_COLUMN_INVALID  ((size_t)-1)     /*YdsColumns::add 拒绝的声明*/
+
+typedef enum {
+    YDS_COLUMN_DOUBLE,
+    YDS_COLUMN_INT64,       /*只接受不带小数和指数的整数*/
+    YDS_COLUMN_BOOL,
+    YDS_COLUMN_STRING,
+} yds_column_type;
+
+/**
+ * 一列数据, 每条记录一行
+ * 空值所在行的有效位为 0, 值为 0/false/空串
+*/
+class YdsColumn {
+public:
+    YdsColumn(const char* pointer, yds_column_type type);
+
+    const std::string& get_pointer() const { return pointer_; }
+    yds_column_type get_type() const { return type_; }
+    size_t size() const { return rows_; }
+    size_t get_null_count() const { return nulls_; }
+    bool is_null(size_t row) const { assert(row < rows_); return !((validity_[row >> 3] >> (row & 7)) & 1); }
+
+    /*有效位图, 第 row 行是 validity[row / 8] 的第 row % 8 位, 1 表示有值*/
+    const uint8_t* get_validity() const { return validity_.data(); }
+    const double* get_doubles() const { assert(type_ == YDS_COLUMN_DOUBLE); return f64_.data(); }
+    const int64_t* get_int64s() const { assert(type_ == YDS_COLUMN_INT64); return i64_.data(); }
+    const uint8_t* get_bools() const { assert(type_ == YDS_COLUMN_BOOL); return bools_.data(); }
+    /*size() + 1 个偏移, 第 row 行是 data[offsets[row], offsets[row + 1])*/
+    const size_t* get_offsets() const { assert(type_ == YDS_COLUMN_STRING); return offsets_.data(); }
+    const char* get_string_data() const { assert(type_ == YDS_COLUMN_STRING); return data_.data(); }
+    const char* get_string(size_t row, size_t* len) const {
+        assert(type_ == YDS_COLUMN_STRING && row < rows_);
+        *len = offsets_[row + 1] - offsets_[row];
+        return data_.data() + offsets_[row];
+    }
+
+private:
+    friend class YdsJson;
+    friend class YdsColumns;
+
+    void clear();
+    void push_valid();
+    void push_null();
+
+    std::string pointer_;
+    std::vector<std::string> path_;     /*pointer 解码后的各段*/
+    yds_column_type type_;
+    size_t rows_;
+    size_t nulls_;
+    size_t match_;                      /*解析时当前路径已经匹配的段数*/
+    std::vector<uint8_t> validity_;
+    std::vector<double> f64_;
+    std::vector<int64_t> i64_;
+    std::vector<uint8_t> bools_;
+    std::vector<size_t> offsets_;
+    std::string data_;
+};
+
+/**
+ * 一组列, 所有列的行数相同
+*/
+class YdsColumns {
+public:
+    YdsColumns() : rows_(0) {}
+
+    /**
+     * 声明一列并返回它的下标
+     * pointer 为相对每条记录的 JSON Pointer; 不以 '/' 开头时视为一个键名
+     * 两列的 pointer 不能相同, 也不能一个是另一个的前缀(例如 "/a" 和 "/a/b"),
+     * 否则返回 YDS_COLUMN_INVALID, 不添加这一列
+    */
+    size_t add(const char* pointer, yds_column_type type);
+    size_t size() const { return columns_.size(); }
+    size_t get_row_count() const { return rows_; }
+    const YdsColumn& operator[](size_t index) const { return columns_[index]; }
+    /*按声明时的 pointer 查找, 找不到返回 nullptr*/
+    const YdsColumn* find(const char* pointer) const;
+    /*清空数据, 保留列的声明和已经申请的内存*/
+    void clear();
+
+private:
+    friend class YdsJson;
+
+    std::vector<YdsColumn> columns_;
+    size_t rows_;
+};
+
+#endif // !__YDSCOLUMN_H__
@@ -4,31 +4,63 @@
 #include <stddef.h>
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
+#include "ydsstats.h"
+#include "ydsallocator.h"
 
 #define YDS_PARSE_STATIC_INIT_SIZE  256
 
 class YdsContext {
 public:
-    YdsContext() : json_(nullptr), stack_(nullptr), top_(0), size_(0) {}
+    YdsContext() : json_(nullptr), stack_(nullptr), top_(0), size_(0), alloc_(nullptr), pin_(nullptr), owned_(false) {}
     ~YdsContext() {
-        if (stack_) free(stack_);
+        if (owned_) alloc_->free_fn(alloc_->ctx, stack_, size_);
     }
 
     void set_context(const char* json) { json_ = json; }
     const char* get_context() const { return json_; }
     void set_top(size_t top) { top_ = top; }
     size_t get_top() const { return top_; }
+    void* get_stack(size_t offset) const { assert(offset < top_); return stack_ + offset; }
+
+    /**
+     * 使用调用者提供的缓冲区作为解析栈, 只在栈为空时调用
+     * 栈不超出该缓冲区时解析过程不会申请堆内存, 超出后自动转到堆上
+    */
+    void set_buffer(char* buf, size_t size) {
+        assert(top_ == 0);
+        if (owned_) alloc_->free_fn(alloc_->ctx, stack_, size_);
+        stack_ = buf;
+        size_ = buf ? size : 0;
+        owned_ = false;
+    }
+
+    /**
+     * 指定解析栈第一次上堆时使用的分配器, nullptr 表示使用当时线程的分配器
+     * 解析期间线程的分配器会被整体回收(如 YdsArenaAllocator)时, 解析栈不能用它
+    */
+    void pin_allocator(const YdsAllocator* alloc) { pin_ = alloc; }
+
+    /*确保还能写入 size 字节, 栈顶不变*/
+    void reserve(size_t size) {
+        if (top_+size >= size_)
+            grow(top_+size);
+    }
+    /*预留 size 字节并返回写入位置, 写完后用 buff_commit 提交实际写入的字节数*/
+    char* buff_reserve(size_t size) {
+        reserve(size);
+        return stack_ + top_;
+    }
+    void buff_commit(size_t size) {
+        assert(top_+size < size_);
+        top_ += size;
+    }
 
     void* buff_push(size_t size) {
         void* ret;
         assert(size > 0);
-        if (top_+size >= size_) {
-            if (size_ == 0) 
-                size_ = YDS_PARSE_STATIC_INIT_SIZE;
-            while(top_+size >= size_) 
-                size_ += (size_ >> 1);
-            stack_ = static_cast<char *>(realloc(stack_, size_));
-        }
+        if (top_+size >= size_)
+            grow(top_+size);
         ret = stack_ + top_;
         top_ += size;
         return ret;
@@ -44,6 +76,29 @@ private:
     const char* json_;
     char* stack_;
     size_t top_, size_;
+    const YdsAllocator* alloc_;     /*解析栈所用的分配器*/
+    const YdsAllocator* pin_;
+    bool owned_;                    /*stack_ 是否由 alloc_ 分配*/
+
+    /*按 1.5 倍扩容直到容量大于 need*/
+    void grow(size_t need) {
+        size_t old_size = size_;
+        size_t new_size = size_ ? size_ : YDS_PARSE_STATIC_INIT_SIZE;
+        while (need >= new_size)
+            new_size += (new_size >> 1);
+        if (owned_)
+            stack_ = static_cast<char *>(alloc_->realloc_fn(alloc_->ctx, stack_, old_size, new_size));
+        else {
+            /*第一次上堆, 记住分配器, 析构时用同一个释放*/
+            alloc_ = pin_ ? pin_ : yds_get_allocator();
+            char* heap = static_cast<char *>(alloc_->malloc_fn(alloc_->ctx, new_size));
+            if (top_) memcpy(heap, stack_, top_);
+            stack_ = heap;
+            owned_ = true;
+        }
+        size_ = new_size;
+        YDS_STATS(yds_stats->stack_realloc_count++; yds_stats->stack_realloc_bytes += size_);
+    }
 };
 
 
@@ -1,4 +1,9 @@
 #include "ydsjson.h"
+#include "ydsutf8.h"
+#include <stdio.h>      /*snprintf*/
+#ifdef YDS_ENABLE_STATS
+#include <chrono>
+#endif
 
 #define ISDIGIT(ch)         ((ch) >= '0' && (ch) <= '9')
 #define ISDIGIT1TO9(ch)     (((ch) >= '1' && (ch) <= '9'))
@@ -16,55 +21,84 @@ void YdsJson::parse_whitespace() {
 }
 
 /**
- * 解析字面量，null，bool
+ * 匹配字面量并跳过
 */
-int YdsJson::parse_literial(const char* literal, yds_type type) {
+int YdsJson::skip_literal(const char* literal) {
     const char* p = context_.get_context();
 
     size_t i;
     for (i = 1; literal[i]; ++i) {
-        if (literal[i] != p[i]) return YDS_PARSE_INVALID_VALUE;
+        if (literal[i] != peek(p + i)) return YDS_PARSE_INVALID_VALUE;
     }
     
     context_.set_context(p+i);
-    value_->set_type(type);
     return YDS_PARSE_OK;
 }
 
 /**
- * 解析数字
+ * 解析字面量，null，bool
 */
-int YdsJson::parse_number() {
-    const char* p = context_.get_context();
-    if (*p == '-') p++;
-    if (*p == '0') p++;
+int YdsJson::parse_literial(const char* literal, yds_type type) {
+    int ret;
+    if ((ret = skip_literal(literal)) == YDS_PARSE_OK)
+        value_->set_type(type);
+    return ret;
+}
+
+/**
+ * 按数字语法扫描, 返回数字之后的位置, 不合法时返回 nullptr
+*/
+const char* YdsJson::scan_number(const char* p) const {
+    if (peek(p) == '-') p++;
+    if (peek(p) == '0') p++;
     else {
-        if (!ISDIGIT1TO9(*p)) return YDS_PARSE_INVALID_VALUE;
-        for (p++; ISDIGIT(*p); p++);
+        if (!ISDIGIT1TO9(peek(p))) return nullptr;
+        for (p++; ISDIGIT(peek(p)); p++);
     }
-    if (*p == '.') {
+    if (peek(p) == '.') {
         p++;
-        if (!ISDIGIT(*p)) return YDS_PARSE_INVALID_VALUE;
-        for (p++; ISDIGIT(*p); p++);
+        if (!ISDIGIT(peek(p))) return nullptr;
+        for (p++; ISDIGIT(peek(p)); p++);
     }
-    if (*p == 'e' || *p == 'E') {
+    if (peek(p) == 'e' || peek(p) == 'E') {
         p++;
-        if (*p == '+' || *p == '-') p++;
-        if (!ISDIGIT(*p)) return YDS_PARSE_INVALID_VALUE;
-        for (p++; ISDIGIT(*p); p++);
+        if (peek(p) == '+' || peek(p) == '-') p++;
+        if (!ISDIGIT(peek(p))) return nullptr;
+        for (p++; ISDIGIT(peek(p)); p++);
     }
+    return p;
+}
 
+/**
+ * 解析数字到 *num
+*/
+int YdsJson::parse_number_raw(double* num) {
+    const char* p = scan_number(context_.get_context());
+    if (!p) return YDS_PARSE_INVALID_VALUE;
+
+    char* end;
     errno = 0;
-    value_->set_number(strtod(context_.get_context(), NULL));
-    if (errno == ERANGE && 
-        (value_->get_number() == HUGE_VAL || value_->get_number() == -HUGE_VAL)) {
-        value_->set_type(YDS_NULL);
+    *num = strtod(context_.get_context(), &end);
+    /*strtod 会越过语法继续读(如 "01e309"、"0x1p9"), 这时按语法扫描到的数字只能是 0 或 -0*/
+    if (end != p)
+        *num = *context_.get_context() == '-' ? -0.0 : 0.0;
+    else if (errno == ERANGE && (*num == HUGE_VAL || *num == -HUGE_VAL))
         return YDS_PARSE_NUMBER_TOO_BIG;
-    }
     context_.set_context(p);
     return YDS_PARSE_OK;
 }
 
+/**
+ * 解析数字
+*/
+int YdsJson::parse_number() {
+    int ret;
+    double num;
+    if ((ret = parse_number_raw(&num)) == YDS_PARSE_OK)
+        value_->set_number(num);
+    return ret;
+}
+
 /**
  * 解析字符串
 */
@@ -73,7 +107,7 @@ const char* YdsJson::parse_hex4(const char* p, unsigned* u) {
     int i;
     *u = 0;
     for (i = 0; i < 4; ++i) {
-        char ch = *p++;
+        char ch = peek(p++);
         *u <<= 4;
         if      (ch >= '0' && ch <= '9') *u |= ch - '0';
         else if (ch >= 'A' && ch <= 'F') *u |= ch - ('A' - 10);
@@ -84,27 +118,35 @@ const char* YdsJson::parse_hex4(const char* p, unsigned* u) {
 }
 
 void YdsJson::encode_utf8(unsigned u) {
-    if (u <= 0x7F) 
-        PUTC(u & 0xFF);
+    /*一次预留最长的 4 字节, 直接写入后提交*/
+    char* p = context_.buff_reserve(4);
+    if (u <= 0x7F) {
+        p[0] = u & 0xFF;
+        context_.buff_commit(1);
+    }
     else if (u <= 0x7FF) {
-        PUTC(0xC0 | ((u >> 6) & 0xFF));
-        PUTC(0x80 | ( u       & 0x3F));
+        p[0] = 0xC0 | ((u >> 6) & 0xFF);
+        p[1] = 0x80 | ( u       & 0x3F);
+        context_.buff_commit(2);
     }
     else if (u <= 0xFFFF) {
-        PUTC(0xE0 | ((u >> 12) & 0xFF));
-        PUTC(0x80 | ((u >>  6) & 0x3F));
-        PUTC(0x80 | ( u        & 0x3F));
+        p[0] = 0xE0 | ((u >> 12) & 0xFF);
+        p[1] = 0x80 | ((u >>  6) & 0x3F);
+        p[2] = 0x80 | ( u        & 0x3F);
+        context_.buff_commit(3);
     }
     else {
         assert(u <= 0x10FFFF);
-        PUTC(0xF0 | ((u >> 18) & 0xFF));
-        PUTC(0x80 | ((u >> 12) & 0x3F));
-        PUTC(0x80 | ((u >>  6) & 0x3F));
-        PUTC(0x80 | ( u        & 0x3F));
+        p[0] = 0xF0 | ((u >> 18) & 0xFF);
+        p[1] = 0x80 | ((u >> 12) & 0x3F);
+        p[2] = 0x80 | ((u >>  6) & 0x3F);
+        p[3] = 0x80 | ( u        & 0x3F);
+        context_.buff_commit(4);
     }
 }
 
-#define STRING_ERROR(ret) do { context_.set_top(head); return ret; } while(0)
+/*出错时把解析位置停在出错的字符上, 供 get_error 报告*/
+#define STRING_ERROR(ret, pos) do { context_.set_top(head); context_.set_context(pos); return ret; } while(0)
 
 int YdsJson::parse_string_raw(char** str, size_t* len) {
     size_t head = context_.get_top();
@@ -116,12 +158,15 @@ int YdsJson::parse_string_raw(char** str, size_t* len) {
         switch(ch) {
             case '\"':
                 *len = context_.get_top() - head;
+                /*转义序列总比解码结果长, 长度不等说明有转义*/
+                YDS_STATS(if (*len != static_cast<size_t>(p - context_.get_context() - 2)) yds_stats->escaped_strings++);
                 *str = static_cast<char *>(context_.buff_pop(*len));
                 //value_->set_string(static_cast<const char*>(context_.buff_pop(len)), len);
                 context_.set_context(p);
                 return  YDS_PARSE_OK;
             
-            case '\\':
+            case '\\': {
+                const char* esc = p - 1;
                 switch(*p++) {
                     case '\"':  PUTC('\"'); break;
                     case '\\':  PUTC('\\'); break;
@@ -133,33 +178,41 @@ int YdsJson::parse_string_raw(char** str, size_t* len) {
                     case 't':   PUTC('\t'); break;
                     case 'u': 
                         if (!(p = parse_hex4(p, &u)))
-                            STRING_ERROR(YDS_PARSE_INVALID_UNICODE_HEX);
+                            STRING_ERROR(YDS_PARSE_INVALID_UNICODE_HEX, esc);
                         if (u >= 0xD800 && u <= 0xDBFF) {
                             if (*p++ != '\\')
-                                STRING_ERROR(YDS_PARSE_INVALID_UNICODE_SURROGATE);
+                                STRING_ERROR(YDS_PARSE_INVALID_UNICODE_SURROGATE, esc);
                             if (*p++ != 'u')
-                                STRING_ERROR(YDS_PARSE_INVALID_UNICODE_SURROGATE);
+                                STRING_ERROR(YDS_PARSE_INVALID_UNICODE_SURROGATE, esc);
                             if (!(p = parse_hex4(p, &u2)))
-                                STRING_ERROR(YDS_PARSE_INVALID_UNICODE_HEX);
+                                STRING_ERROR(YDS_PARSE_INVALID_UNICODE_HEX, esc);
                             if (u2 < 0xDC00 || u2 > 0xDFFF)
-                                STRING_ERROR(YDS_PARSE_INVALID_UNICODE_SURROGATE);
+                                STRING_ERROR(YDS_PARSE_INVALID_UNICODE_SURROGATE, esc);
                             u = (((u - 0xD800) << 10) | (u2 - 0xDC00)) + 0x10000;
                         }
                         encode_utf8(u);
                         break;
                     default:    
-                        STRING_ERROR(YDS_PARSE_INVALID_STRING_ESCAPE);
+                        STRING_ERROR(YDS_PARSE_INVALID_STRING_ESCAPE, esc);
                 }
                 break;
+            }
 
             case '\0':
-                STRING_ERROR(YDS_PARSE_MISS_QUOTATION_MARK);
+                STRING_ERROR(YDS_PARSE_MISS_QUOTATION_MARK, p - 1);
             
-            default:
+            default: {
                 if (static_cast<unsigned char>(ch) < 0x20) {
-                    STRING_ERROR(YDS_PARSE_INVALID_STRING_CHAR);
+                    STRING_ERROR(YDS_PARSE_INVALID_STRING_CHAR, p - 1);
                 }
-                PUTC(ch);
+                /*连续的普通字符整段拷贝, 不再逐字节入栈*/
+                const char* run = p - 1;
+                while (*p != '\"' && *p != '\\' && static_cast<unsigned char>(*p) >= 0x20)
+                    p++;
+                if ((flags_ & YDS_PARSE_VALIDATE_UTF8) && !yds_validate_utf8(run, p - run))
+                    STRING_ERROR(YDS_PARSE_INVALID_UTF8, run);
+                memcpy(context_.buff_push(p - run), run, p - run);
+            }
         }
     }
 }
@@ -173,6 +226,211 @@ int YdsJson::parse_string() {
     return ret;
 }
 
+/**
+ * 按字符串语法跳过一个字符串, 不解码也不入栈
+ * 出错位置与 parse_string_raw 相同
+*/
+#define SKIP_ERROR(ret, pos) do { context_.set_context(pos); return ret; } while(0)
+
+int YdsJson::skip_string() {
+    const char* p = context_.get_context() + 1;
+    unsigned u, u2;
+
+    while (true) {
+        char ch = peek(p++);
+        switch (ch) {
+            case '\"':
+                context_.set_context(p);
+                return YDS_PARSE_OK;
+
+            case '\\': {
+                const char* esc = p - 1;
+                switch (peek(p++)) {
+                    case '\"': case '\\': case '/': case 'b':
+                    case 'f': case 'n': case 'r': case 't':
+                        break;
+                    case 'u':
+                        if (!(p = parse_hex4(p, &u)))
+                            SKIP_ERROR(YDS_PARSE_INVALID_UNICODE_HEX, esc);
+                        if (u >= 0xD800 && u <= 0xDBFF) {
+                            if (peek(p++) != '\\' || peek(p++) != 'u')
+                                SKIP_ERROR(YDS_PARSE_INVALID_UNICODE_SURROGATE, esc);
+                            if (!(p = parse_hex4(p, &u2)))
+                                SKIP_ERROR(YDS_PARSE_INVALID_UNICODE_HEX, esc);
+                            if (u2 < 0xDC00 || u2 > 0xDFFF)
+                                SKIP_ERROR(YDS_PARSE_INVALID_UNICODE_SURROGATE, esc);
+                        }
+                        break;
+                    default:
+                        SKIP_ERROR(YDS_PARSE_INVALID_STRING_ESCAPE, esc);
+                }
+                break;
+            }
+
+            case '\0':
+                SKIP_ERROR(YDS_PARSE_MISS_QUOTATION_MARK, p - 1);
+
+            default: {
+                if (static_cast<unsigned char>(ch) < 0x20)
+                    SKIP_ERROR(YDS_PARSE_INVALID_STRING_CHAR, p - 1);
+                const char* run = p - 1;
+                while (p != end_ && *p != '\"' && *p != '\\' && static_cast<unsigned char>(*p) >= 0x20)
+                    p++;
+                if ((flags_ & YDS_PARSE_VALIDATE_UTF8) && !yds_validate_utf8(run, p - run))
+                    SKIP_ERROR(YDS_PARSE_INVALID_UTF8, run);
+            }
+        }
+    }
+}
+
+#undef SKIP_ERROR
+
+/**
+ * 跳过一个数字, 不调用 strtod(输入可能不以 '\0' 结尾)
+ * 只有十进制量级落在 DBL_MAX 附近时, 才把有效数字拷到局部缓冲区里精确判断是否溢出
+*/
+int YdsJson::skip_number() {
+    const char* p = context_.get_context();
+    const char* end = scan_number(p);
+    if (!end) return YDS_PARSE_INVALID_VALUE;
+
+    /*数值 = 0.d1d2d3... * 10^mag*/
+    char digits[48];
+    size_t n = 0;
+    long mag = 0;
+    const char* q = p;
+    if (*q == '-') q++;
+    for (; q < end && ISDIGIT(*q); ++q) {
+        if (n == 0 && *q == '0') continue;
+        if (n < 40) digits[n++] = *q;
+        mag++;
+    }
+    if (q < end && *q == '.') {
+        for (++q; q < end && ISDIGIT(*q); ++q) {
+            if (n == 0 && *q == '0') { mag--; continue; }
+            if (n < 40) digits[n++] = *q;
+        }
+    }
+    if (n == 0) {               /*0*/
+        context_.set_context(end);
+        return YDS_PARSE_OK;
+    }
+    if (q < end) {              /*指数部分*/
+        bool neg = *++q == '-';
+        if (*q == '+' || *q == '-') q++;
+        long e = 0;
+        for (; q < end; ++q)
+            if (e < 100000) e = e * 10 + (*q - '0');
+        mag += neg ? -e : e;
+    }
+
+    if (mag >= 310) return YDS_PARSE_NUMBER_TOO_BIG;
+    if (mag == 309) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "0.%.*se309", static_cast<int>(n), digits);
+        if (strtod(buf, NULL) == HUGE_VAL)
+            return YDS_PARSE_NUMBER_TOO_BIG;
+    }
+    context_.set_context(end);
+    return YDS_PARSE_OK;
+}
+
+/**
+ * 跳过空白, 到达 end_ 时停止
+*/
+void YdsJson::skip_whitespace() {
+    const char* p = context_.get_context();
+    while (p != end_ && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+        p++;
+    context_.set_context(p);
+}
+
+/**
+ * 按 parse_value 相同的语法跳过一个值, 不申请任何内存
+*/
+int YdsJson::skip_value() {
+    int ret;
+    if (++depth_ > max_depth_) {
+        depth_--;
+        return YDS_PARSE_DEPTH_EXCEEDED;
+    }
+    if (depth_ > scan_.max_depth) scan_.max_depth = depth_;
+    scan_.elements++;
+    switch (peek(context_.get_context())) {
+        case 'n':   ret = skip_literal("null"); break;
+        case 't':   ret = skip_literal("true"); break;
+        case 'f':   ret = skip_literal("false"); break;
+        case '"':   ret = skip_string(); break;
+        case '[':   ret = skip_array(); break;
+        case '{':   ret = skip_object(); break;
+        case '\0':  ret = YDS_PARSE_EXPECT_VALUE; break;
+        default:    ret = skip_number(); break;
+    }
+    depth_--;
+    return ret;
+}
+
+int YdsJson::skip_array() {
+    int ret;
+    context_.read_byte();
+    skip_whitespace();
+    if (peek(context_.get_context()) == ']') {
+        context_.read_byte();
+        return YDS_PARSE_OK;
+    }
+    while (true) {
+        if ((ret = skip_value()) != YDS_PARSE_OK)
+            return ret;
+        skip_whitespace();
+        char ch = peek(context_.get_context());
+        if (ch == ',') {
+            context_.read_byte();
+            skip_whitespace();
+        }
+        else if (ch == ']') {
+            context_.read_byte();
+            return YDS_PARSE_OK;
+        }
+        else
+            return YDS_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+    }
+}
+
+int YdsJson::skip_object() {
+    int ret;
+    context_.read_byte();
+    skip_whitespace();
+    if (peek(context_.get_context()) == '}') {
+        context_.read_byte();
+        return YDS_PARSE_OK;
+    }
+    while (true) {
+        if (peek(context_.get_context()) != '"')
+            return YDS_PARSE_MISS_KEY;
+        if ((ret = skip_string()) != YDS_PARSE_OK)
+            return ret;
+        skip_whitespace();
+        if (peek(context_.get_context()) != ':')
+            return YDS_PARSE_MISS_COLON;
+        context_.read_byte();
+        skip_whitespace();
+        if ((ret = skip_value()) != YDS_PARSE_OK)
+            return ret;
+        skip_whitespace();
+        char ch = peek(context_.get_context());
+        if (ch == ',') {
+            context_.read_byte();
+            skip_whitespace();
+        }
+        else if (ch == '}') {
+            context_.read_byte();
+            return YDS_PARSE_OK;
+        }
+        else
+            return YDS_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+    }
+}
+
 int YdsJson::parse_array() {
     size_t size = 0;
     int ret;
@@ -184,13 +442,18 @@ int YdsJson::parse_array() {
         value_->set_array(nullptr, 0);
         return YDS_PARSE_OK;
     }
+    if ((flags_ & YDS_PARSE_PACK_NUMBERS) && parse_number_array(&ret))
+        return ret;
 
     YdsValue* tmp = value_;
-    value_ = static_cast<YdsValue *>(malloc(sizeof(YdsValue)));
+    value_ = static_cast<YdsValue *>(yds_malloc(sizeof(YdsValue)));
+    YDS_STATS(yds_stats->alloc_count++; yds_stats->alloc_bytes += sizeof(YdsValue));
     while (true) {
         value_->init();
-        if ((ret = parse_value()) != YDS_PARSE_OK) 
+        if ((ret = parse_value()) != YDS_PARSE_OK) {
+            error_path_index(size);
             break;
+        }
         memcpy(context_.buff_push(sizeof(YdsValue)), value_, sizeof(YdsValue));
         size++;
 
@@ -206,7 +469,7 @@ int YdsJson::parse_array() {
             //tmp->set_array_size(size);
             //size *= sizeof(YdsValue);
             tmp->set_array(static_cast<char *>(context_.buff_pop(size*sizeof(YdsValue))), size);
-            free(value_);
+            yds_free(value_, sizeof(YdsValue));
             value_ = tmp;
             return YDS_PARSE_OK;
         }
@@ -215,7 +478,7 @@ int YdsJson::parse_array() {
             break;
         }
     }
-    free(value_);
+    yds_free(value_, sizeof(YdsValue));
     value_ = tmp;
     for (int i = 0; i < size; i++) {
        static_cast<YdsValue *>(context_.buff_pop(sizeof(YdsValue)))->destroy();
@@ -223,6 +486,166 @@ int YdsJson::parse_array() {
     return ret;
 }
 
+/**
+ * YDS_PARSE_PACK_NUMBERS 时先假设数组全是数字, 从第一个元素开始
+ * 逐个解析成 double 放到解析栈上, 不生成子节点、不检查每个元素的类型和深度
+ * 遇到不是数字的元素就退回数组开头并返回 false, 由通用的数组解析重新解析
+ * 返回 true 时 *ret 为解析结果, 出错的位置和错误码与通用解析相同
+*/
+bool YdsJson::parse_number_array(int* ret) {
+    const char* start = context_.get_context();
+    size_t head = context_.get_top();
+    size_t size = 0;
+    if (depth_ + 1 > max_depth_)
+        return false;
+    while (true) {
+        char ch = *context_.get_context();
+        if (ch != '-' && !ISDIGIT(ch)) {
+            context_.set_top(head);
+            context_.set_context(start);
+            return false;
+        }
+        double d;
+        if ((*ret = parse_number_raw(&d)) != YDS_PARSE_OK) {
+            error_path_index(size);
+            break;
+        }
+        memcpy(context_.buff_push(sizeof(double)), &d, sizeof(double));
+        size++;
+
+        parse_whitespace();
+        if (*context_.get_context() == ',') {
+            context_.read_byte();
+            parse_whitespace();
+        }
+        else if (*context_.get_context() == ']') {
+            context_.read_byte();
+            size_t bytes = size * sizeof(double);
+            double* a = static_cast<double *>(yds_malloc(bytes));
+            YDS_STATS(yds_stats->alloc_count++; yds_stats->alloc_bytes += bytes);
+            memcpy(a, context_.buff_pop(bytes), bytes);
+            value_->adopt_packed_numbers(a, size);
+            *ret = YDS_PARSE_OK;
+            return true;
+        }
+        else {
+            *ret = YDS_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+            break;
+        }
+    }
+    context_.set_top(head);
+    return true;
+}
+
+/**
+ * YDS_PARSE_IN_PLACE 时子节点的内存
+ * 容量不够时按 1.5 倍扩容, 结束时缩小到恰好 size 个, 与 destroy 释放的大小一致
+*/
+template <typename T>
+static T* grow_children(T* buf, size_t* capacity, size_t hint) {
+    size_t cap = *capacity ? *capacity + (*capacity >> 1) + 1 : hint;
+    if (buf)
+        buf = static_cast<T *>(yds_realloc(buf, *capacity * sizeof(T), cap * sizeof(T)));
+    else
+        buf = static_cast<T *>(yds_malloc(cap * sizeof(T)));
+    YDS_STATS(yds_stats->alloc_count++; yds_stats->alloc_bytes += cap * sizeof(T));
+    *capacity = cap;
+    return buf;
+}
+
+template <typename T>
+static T* shrink_children(T* buf, size_t capacity, size_t size) {
+    if (size == capacity)
+        return buf;
+    if (size == 0) {
+        yds_free(buf, capacity * sizeof(T));
+        return nullptr;
+    }
+    return static_cast<T *>(yds_realloc(buf, capacity * sizeof(T), size * sizeof(T)));
+}
+
+/**
+ * 子节点直接解析到数组最终的内存里, 不在解析栈上暂存, 也不再整体拷贝一次
+ * 只有扩容时 realloc 可能移动已经解析好的子节点
+ * 初始容量取同一层上一个数组/对象的大小, 结构相同的记录通常一次就申请到恰好的大小
+*/
+int YdsJson::parse_array_in_place() {
+    context_.read_byte();
+    parse_whitespace();
+    if (*context_.get_context() == ']') {
+        context_.read_byte();
+        value_->adopt_array(nullptr, 0);
+        return YDS_PARSE_OK;
+    }
+
+    int ret;
+    if ((flags_ & YDS_PARSE_PACK_NUMBERS) && parse_number_array(&ret))
+        return ret;
+
+    YdsValue* tmp = value_;
+    YdsValue* e = nullptr;
+    size_t size = 0, capacity = 0;
+    while (true) {
+        if (size == capacity)
+            e = grow_children(e, &capacity, children_hint());
+        value_ = &e[size];
+        value_->init();
+        ret = parse_value();
+        value_ = tmp;
+        if (ret != YDS_PARSE_OK) {
+            error_path_index(size);
+            break;
+        }
+        size++;
+
+        parse_whitespace();
+        if (*context_.get_context() == ',') {
+            context_.read_byte();
+            parse_whitespace();
+        }
+        else if (*context_.get_context() == ']') {
+            context_.read_byte();
+            value_->adopt_array(shrink_children(e, capacity, size), size);
+            update_children_hint(size);
+            return YDS_PARSE_OK;
+        }
+        else {
+            ret = YDS_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+            break;
+        }
+    }
+    for (size_t i = 0; i < size; ++i)
+        e[i].destroy();
+    yds_free(e, capacity * sizeof(YdsValue));
+    return ret;
+}
+
+/**
+ * 解析对象的键以及后面的冒号, 成功时 *key 持有键的一个引用
+ * 开启 YDS_PARSE_INTERN_KEYS 时相同的键共享同一块内存
+*/
+int YdsJson::parse_key(char** key, size_t* len) {
+    int ret;
+    char* str;
+    /*解析key, 先判断在解析*/
+    if (*context_.get_context() != '"')
+        return YDS_PARSE_MISS_KEY;
+    if ((ret = parse_string_raw(&str, len)) != YDS_PARSE_OK)
+        return ret;
+
+    parse_whitespace();
+    if (*context_.get_context() != ':')
+        return YDS_PARSE_MISS_COLON;
+    context_.read_byte();
+
+    if (flags_ & YDS_PARSE_INTERN_KEYS)
+        *key = keys_.intern(str, *len);
+    else
+        *key = yds_key_new(str, *len, yds_key_hash(str, *len));
+    parse_whitespace();
+    return YDS_PARSE_OK;
+}
+
 int YdsJson::parse_object() {
     context_.read_byte();
 
@@ -240,33 +663,24 @@ int YdsJson::parse_object() {
     m.key = nullptr;
     //m.v = static_cast<YdsValue *>(malloc(sizeof(YdsValue)));
     while (true) {
-        char* str;
         m.v.init();
 
-        /*解析key, 先判断在解析*/
-        if (*context_.get_context() != '"') {
-            ret = YDS_PARSE_MISS_KEY;
+        if ((ret = parse_key(&m.key, &m.key_len)) != YDS_PARSE_OK)
             break;
-        }
-        if ((ret = parse_string_raw(&str, &m.key_len)) != YDS_PARSE_OK)
-            break;
-        memcpy(m.key = static_cast<char *>(malloc(m.key_len+1)), str, m.key_len);
-        m.key[m.key_len] = '\0';
-
-        parse_whitespace();
-        if (*context_.get_context() != ':') {
-            ret = YDS_PARSE_MISS_COLON;
-            break;
-        }
-        context_.read_byte();
 
         /*解析键值*/
-        parse_whitespace();
-        if ((ret = parse_value()) != YDS_PARSE_OK)
+        YdsValue* tmp = value_;
+        value_ = &m.v;
+        ret = parse_value();
+        value_ = tmp;
+        if (ret != YDS_PARSE_OK) {
+            error_path_key(m.key, m.key_len);
             break;
+        }
         memcpy(context_.buff_push(sizeof(YdsMember)), &m, sizeof(YdsMember));
         size++;
         m.key = nullptr;
+        m.v.init();
 
         parse_whitespace();
         if (*context_.get_context() == ',') {
@@ -279,25 +693,262 @@ int YdsJson::parse_object() {
             return YDS_PARSE_OK;
         }
         else {
-            ret = YDS_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+            ret = YDS_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
             break;
         }
     }
 
-    free(m.key);
+    yds_key_release(m.key, m.key_len);
     for (int i = 0; i < size; ++i) {
         YdsMember* m = static_cast<YdsMember *>(context_.buff_pop(sizeof(YdsMember)));
-        free(m->key);
+        yds_key_release(m->key, m->key_len);
         m->v.destroy();//?
     }
     value_->set_type(YDS_NULL);
     return ret;
 }
 
+/*与 parse_array_in_place 相同, 成员直接写入对象最终的内存*/
+int YdsJson::parse_object_in_place() {
+    context_.read_byte();
+    parse_whitespace();
+    if (*context_.get_context() == '}') {
+        context_.read_byte();
+        value_->adopt_object(nullptr, 0);
+        return YDS_PARSE_OK;
+    }
+
+    YdsValue* tmp = value_;
+    YdsMember* m = nullptr;
+    size_t size = 0, capacity = 0;
+    int ret;
+    while (true) {
+        if (size == capacity)
+            m = grow_children(m, &capacity, children_hint());
+        YdsMember& member = m[size];
+        if ((ret = parse_key(&member.key, &member.key_len)) != YDS_PARSE_OK)
+            break;
+
+        value_ = &member.v;
+        value_->init();
+        ret = parse_value();
+        value_ = tmp;
+        if (ret != YDS_PARSE_OK) {
+            error_path_key(member.key, member.key_len);
+            yds_key_release(member.key, member.key_len);
+            break;
+        }
+        size++;
+
+        parse_whitespace();
+        if (*context_.get_context() == ',') {
+            context_.read_byte();
+            parse_whitespace();
+        }
+        else if (*context_.get_context() == '}') {
+            context_.read_byte();
+            value_->adopt_object(shrink_children(m, capacity, size), size);
+            update_children_hint(size);
+            return YDS_PARSE_OK;
+        }
+        else {
+            ret = YDS_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+            break;
+        }
+    }
+    for (size_t i = 0; i < size; ++i) {
+        yds_key_release(m[i].key, m[i].key_len);
+        m[i].v.destroy();
+    }
+    yds_free(m, capacity * sizeof(YdsMember));
+    value_->set_type(YDS_NULL);
+    return ret;
+}
+
 /**
- * 根据类型解析数据
+ * 解析一个值, 并检查嵌套深度(根为第 1 层)
+ * 开启统计时记录最深层数和各类型耗时
 */
 int YdsJson::parse_value() {
+    int ret;
+#ifdef YDS_ENABLE_STATS
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if (depth_ + 1 > stats_.max_depth)
+        stats_.max_depth = depth_ + 1;
+#endif
+    if (++depth_ > max_depth_)
+        ret = YDS_PARSE_DEPTH_EXCEEDED;
+    else
+        ret = dispatch_value();
+    depth_--;
+#ifdef YDS_ENABLE_STATS
+    if (ret == YDS_PARSE_OK)
+        stats_.type_ns[value_->get_type()] += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+#endif
+    return ret;
+}
+
+/**
+ * 非递归解析
+ * 数组/对象的状态以 YdsFrame 的形式和子元素一起放在解析栈上,
+ * 嵌套深度只消耗堆内存, 不消耗调用栈
+*/
+int YdsJson::parse_iterative() {
+    const size_t no_frame = static_cast<size_t>(-1);
+    size_t frame = no_frame;    /*当前所在数组/对象的帧在解析栈上的偏移*/
+    YdsValue* root = value_;
+    YdsValue v;
+    int ret;
+    bool in_child = true;       /*错误发生在当前层的某个子元素里, 而不是分隔符或键上*/
+
+    while (true) {
+        /*解析一个值到 v*/
+        char ch = *context_.get_context();
+        if (ch == '[' || ch == '{') {
+            if (depth_ + 1 > max_depth_) {
+                ret = YDS_PARSE_DEPTH_EXCEEDED;
+                break;
+            }
+            YDS_STATS(if (depth_ + 1 > yds_stats->max_depth) yds_stats->max_depth = depth_ + 1);
+            context_.read_byte();
+            parse_whitespace();
+            if (ch == '[' && *context_.get_context() == ']') {
+                context_.read_byte();
+                v.set_array(nullptr, 0);
+            }
+            else if (ch == '{' && *context_.get_context() == '}') {
+                context_.read_byte();
+                v.set_object(nullptr, 0, 0);
+            }
+            else {
+                /*进入新的一层, 对象先解析第一个键*/
+                YdsFrame* f = static_cast<YdsFrame *>(context_.buff_push(sizeof(YdsFrame)));
+                f->prev = frame;
+                f->size = 0;
+                f->type = ch == '[' ? YDS_ARRAY : YDS_OBJECT;
+                frame = context_.get_top() - sizeof(YdsFrame);
+                depth_++;
+                if (ch == '{' && (ret = push_member()) != YDS_PARSE_OK) {
+                    in_child = false;
+                    break;
+                }
+                continue;
+            }
+        }
+        else {
+            value_ = &v;
+            ret = parse_value();
+            value_ = root;
+            if (ret != YDS_PARSE_OK)
+                break;
+        }
+
+        /*把 v 交给所在的数组/对象, 遇到结束符就合成上一层的值, 继续向上交付*/
+        while (true) {
+            if (frame == no_frame) {
+                memcpy(static_cast<void *>(root), &v, sizeof(YdsValue));
+                v.init();
+                return YDS_PARSE_OK;
+            }
+            YdsFrame* f = static_cast<YdsFrame *>(context_.get_stack(frame));
+            if (f->type == YDS_ARRAY)
+                memcpy(context_.buff_push(sizeof(YdsValue)), &v, sizeof(YdsValue));
+            else
+                memcpy(static_cast<void *>(&static_cast<YdsMember *>(context_.get_stack(context_.get_top() - sizeof(YdsMember)))->v),
+                       &v, sizeof(YdsValue));
+            v.init();
+            f = static_cast<YdsFrame *>(context_.get_stack(frame));
+            f->size++;
+
+            parse_whitespace();
+            ch = *context_.get_context();
+            if (ch == ',') {
+                context_.read_byte();
+                parse_whitespace();
+                ret = f->type == YDS_OBJECT ? push_member() : YDS_PARSE_OK;
+                in_child = ret == YDS_PARSE_OK;
+                break;
+            }
+            if ((f->type == YDS_ARRAY && ch != ']') || (f->type == YDS_OBJECT && ch != '}')) {
+                ret = f->type == YDS_ARRAY ? YDS_PARSE_MISS_COMMA_OR_SQUARE_BRACKET : YDS_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+                in_child = false;
+                break;
+            }
+            context_.read_byte();
+
+            /*本层结束, 子元素出栈合成数组/对象, 再弹出帧*/
+            size_t size = f->size;
+            size_t prev = f->prev;
+            if (f->type == YDS_ARRAY)
+                v.set_array(static_cast<char *>(context_.buff_pop(size*sizeof(YdsValue))), size);
+            else
+                v.set_object(static_cast<char *>(context_.buff_pop(size*sizeof(YdsMember))), size*sizeof(YdsMember), size);
+            context_.buff_pop(sizeof(YdsFrame));
+            frame = prev;
+            depth_--;
+        }
+        if (ret != YDS_PARSE_OK)
+            break;
+    }
+
+    /*出错时逐层释放已经解析的子元素*/
+    v.destroy();
+    unwind_frames(frame, in_child);
+    return ret;
+}
+
+/**
+ * 非递归解析出错后, 从 frame 开始逐层释放解析栈上的子元素并弹出帧, 同时记录出错路径
+ * in_child 表示错误发生在最内层正在解析的子元素里
+*/
+void YdsJson::unwind_frames(size_t frame, bool in_child) {
+    const size_t no_frame = static_cast<size_t>(-1);
+    while (frame != no_frame) {
+        YdsFrame* f = static_cast<YdsFrame *>(context_.get_stack(frame));
+        size_t elem = f->type == YDS_ARRAY ? sizeof(YdsValue) : sizeof(YdsMember);
+        size_t size = (context_.get_top() - frame - sizeof(YdsFrame)) / elem;
+        if (in_child) {
+            /*数组里正在解析的是第 size 个元素, 对象里是栈顶成员的值*/
+            if (f->type == YDS_ARRAY)
+                error_path_index(size);
+            else {
+                YdsMember* m = static_cast<YdsMember *>(context_.get_stack(context_.get_top() - elem));
+                error_path_key(m->key, m->key_len);
+            }
+        }
+        in_child = true;
+        for (size_t i = 0; i < size; ++i) {
+            if (f->type == YDS_ARRAY)
+                static_cast<YdsValue *>(context_.buff_pop(elem))->destroy();
+            else {
+                YdsMember* m = static_cast<YdsMember *>(context_.buff_pop(elem));
+                yds_key_release(m->key, m->key_len);
+                m->v.destroy();
+            }
+        }
+        frame = f->prev;
+        context_.buff_pop(sizeof(YdsFrame));
+        depth_--;
+    }
+}
+
+/**
+ * 非递归模式下解析对象的键, 压入一个值为空的成员
+*/
+int YdsJson::push_member() {
+    YdsMember m;
+    int ret;
+    if ((ret = parse_key(&m.key, &m.key_len)) != YDS_PARSE_OK)
+        return ret;
+    memcpy(context_.buff_push(sizeof(YdsMember)), &m, sizeof(YdsMember));
+    return YDS_PARSE_OK;
+}
+
+/**
+ * 根据类型解析数据
+*/
+int YdsJson::dispatch_value() {
     const char* p = context_.get_context();
 
     switch (*p) {
@@ -317,34 +968,432 @@ int YdsJson::parse_value() {
             return parse_string();
 
         case '[':
-            return parse_array();
+            return (flags_ & YDS_PARSE_IN_PLACE) ? parse_array_in_place() : parse_array();
         
         case '{':
-            return parse_object();
+            return (flags_ & YDS_PARSE_IN_PLACE) ? parse_object_in_place() : parse_object();
 
         case '\0': 
             return YDS_PARSE_EXPECT_VALUE;
     }
 }
 
+YdsJson::YdsJson() : value_(nullptr), end_(nullptr), flags_(0), depth_(0), max_depth_(YDS_PARSE_MAX_DEPTH) {
+    for (size_t i = 0; i < YDS_PARSE_HINT_DEPTH; ++i)
+        hint_[i] = YDS_PARSE_IN_PLACE_INIT;
+    iter_.json = nullptr;
+    iter_.index = 0;
+    iter_.active = false;
+    iter_.root = false;
+    iter_.many = false;
+    error_.code = YDS_PARSE_OK;
+    error_.offset = 0;
+    error_.json = nullptr;
+    context_.set_buffer(stack_buffer_, sizeof(stack_buffer_));
+}
+
+/**
+ * 使用调用者提供的解析栈, 传 nullptr 恢复为内置的小缓冲区
+*/
+void YdsJson::set_stack_buffer(char* buf, size_t size) {
+    if (buf)
+        context_.set_buffer(buf, size);
+    else
+        context_.set_buffer(stack_buffer_, sizeof(stack_buffer_));
+}
+
+/**
+ * 按预计的字符串/数组大小预先扩充解析栈, 避免解析过程中多次 realloc
+ * 输入长度 len 是任意字符串解码后长度的上限
+*/
+void YdsJson::reserve_stack(size_t len) {
+    context_.reserve(len);
+}
+
 /**
  * 解析json数据
 */
-int YdsJson::parse(YdsValue* value, const char* json) {
+int YdsJson::parse(YdsValue* value, const char* json, unsigned flags) {
     assert(json && value);
     context_.set_context(json);
     value_ = value;
     value_->set_type(YDS_NULL);
+#ifdef YDS_ENABLE_STATS
+    stats_.reset();
+    YdsStats* prev_stats = yds_current_stats;
+    yds_current_stats = &stats_;
+#endif
+    flags_ = flags;
+    depth_ = 0;
+    error_.path.clear();
     
     int ret;
     parse_whitespace();
-    if ((ret = parse_value()) == YDS_PARSE_OK) {    //解析成功
+    ret = (flags & YDS_PARSE_ITERATIVE) ? parse_iterative() : parse_value();
+    if (ret == YDS_PARSE_OK) {    //解析成功
         parse_whitespace();
         if (*context_.get_context() != '\0') { //解析成功但不是末尾
             value->set_type(YDS_NULL);
-            return YDS_PARSE_ROOT_NOT_SINGULAR;
+            ret = YDS_PARSE_ROOT_NOT_SINGULAR;
         }
     }
+    /*驻留表只在一份文档内共享, 键的内存由文档持有*/
+    keys_.clear();
+    error_.code = ret;
+    error_.json = json;
+    error_.offset = ret == YDS_PARSE_OK ? 0 : context_.get_context() - json;
+#ifdef YDS_ENABLE_STATS
+    yds_current_stats = prev_stats;
+#endif
     assert(context_.get_top() == 0);
     return ret; //解析失败或解析到末尾
-}
\ No newline at end of file
+}
+/**
+ * 只检查 data[0, len) 是否为合法的 json, 语法与 parse 相同
+ * 不解码字符串、不生成节点、不申请内存, data 不需要以 '\0' 结尾
+ * info 不为空时返回出错位置、最深层数和值的个数
+*/
+int YdsJson::validate(const char* data, size_t len, YdsValidateInfo* info, unsigned flags) {
+    assert(data || len == 0);
+    context_.set_context(data);
+    end_ = data + len;
+    flags_ = flags;
+    depth_ = 0;
+    scan_.max_depth = 0;
+    scan_.elements = 0;
+
+    int ret;
+    skip_whitespace();
+    if ((ret = skip_value()) == YDS_PARSE_OK) {
+        skip_whitespace();
+        if (context_.get_context() != end_)
+            ret = YDS_PARSE_ROOT_NOT_SINGULAR;
+    }
+    if (info) {
+        info->offset = ret == YDS_PARSE_OK ? len : context_.get_context() - data;
+        info->max_depth = scan_.max_depth;
+        info->elements = scan_.elements;
+    }
+    end_ = nullptr;
+    return ret;
+}
+
+/**
+ * 定位到 pointer 指向的数组并跳过 '['
+ * 定位过程只做语法扫描, 不生成路径上其它值的节点
+*/
+int YdsJson::begin_array(const char* json, const char* pointer, unsigned flags) {
+    assert(json && pointer);
+    context_.set_context(json);
+    keys_.clear();
+    flags_ = flags;
+    depth_ = 0;
+    error_.path.clear();
+    error_.json = json;
+    iter_.json = json;
+    iter_.pointer = pointer;
+    iter_.index = 0;
+    iter_.active = false;
+    iter_.root = *pointer == '\0';
+    iter_.many = false;
+
+    int ret;
+    parse_whitespace();
+    if ((ret = seek_pointer(pointer)) == YDS_PARSE_OK) {
+        if (*context_.get_context() != '[')
+            ret = YDS_PARSE_TYPE_MISMATCH;
+        else if (++depth_ > max_depth_)
+            ret = YDS_PARSE_DEPTH_EXCEEDED;
+        else {
+            context_.read_byte();
+            parse_whitespace();
+            iter_.active = true;
+            error_.code = YDS_PARSE_OK;
+            if (*context_.get_context() == ']')
+                end_iteration(YDS_PARSE_OK);
+            return error_.code;
+        }
+    }
+    end_iteration(ret);
+    return ret;
+}
+
+/**
+ * 解析下一个元素到 value
+ * 解析栈和 value 本身在元素之间复用, 峰值内存只取决于最大的一个元素
+*/
+bool YdsJson::next_element(YdsValue* value) {
+    assert(value && !iter_.many);
+    if (!iter_.active)
+        return false;
+    if (iter_.index > 0) {
+        parse_whitespace();
+        if (*context_.get_context() == ']')
+            return end_iteration(YDS_PARSE_OK);
+        if (*context_.get_context() != ',')
+            return end_iteration(YDS_PARSE_MISS_COMMA_OR_SQUARE_BRACKET);
+        context_.read_byte();
+        parse_whitespace();
+    }
+
+    value_ = value;
+    value_->set_type(YDS_NULL);
+#ifdef YDS_ENABLE_STATS
+    stats_.reset();
+    YdsStats* prev_stats = yds_current_stats;
+    yds_current_stats = &stats_;
+#endif
+    int ret = (flags_ & YDS_PARSE_ITERATIVE) ? parse_iterative() : parse_value();
+#ifdef YDS_ENABLE_STATS
+    yds_current_stats = prev_stats;
+#endif
+    assert(context_.get_top() == 0);
+    if (ret != YDS_PARSE_OK) {
+        error_path_index(iter_.index);
+        return end_iteration(ret);
+    }
+    iter_.index++;
+    return true;
+}
+
+void YdsJson::begin_many(const char* json, unsigned flags) {
+    assert(json);
+    context_.set_context(json);
+    keys_.clear();
+    flags_ = flags;
+    depth_ = 0;
+    error_.code = YDS_PARSE_OK;
+    error_.offset = 0;
+    error_.path.clear();
+    error_.json = json;
+    iter_.json = json;
+    iter_.pointer.clear();
+    iter_.index = 0;
+    iter_.active = true;
+    iter_.root = false;
+    iter_.many = true;
+}
+
+/**
+ * 解析下一个根值, 输入只剩空白时结束
+ * 与 next_element 一样复用 value 和解析栈, 开启 YDS_PARSE_INTERN_KEYS 时各文档共享驻留表
+*/
+bool YdsJson::next_document(YdsValue* value, size_t* offset) {
+    assert(value && iter_.many);
+    if (!iter_.active)
+        return false;
+    parse_whitespace();
+    if (*context_.get_context() == '\0')
+        return end_iteration(YDS_PARSE_OK);
+    if (offset)
+        *offset = context_.get_context() - iter_.json;
+
+    value_ = value;
+    value_->set_type(YDS_NULL);
+#ifdef YDS_ENABLE_STATS
+    stats_.reset();
+    YdsStats* prev_stats = yds_current_stats;
+    yds_current_stats = &stats_;
+#endif
+    int ret = (flags_ & YDS_PARSE_ITERATIVE) ? parse_iterative() : parse_value();
+#ifdef YDS_ENABLE_STATS
+    yds_current_stats = prev_stats;
+#endif
+    assert(context_.get_top() == 0 && depth_ == 0);
+    if (ret != YDS_PARSE_OK)
+        return end_iteration(ret);
+    iter_.index++;
+    return true;
+}
+
+/**
+ * 结束遍历, 记录错误信息并释放驻留表, 总是返回 false
+ * 根数组正常结束时还要求 ']' 之后只剩空白
+*/
+bool YdsJson::end_iteration(int ret) {
+    if (ret == YDS_PARSE_OK && iter_.active && !iter_.many) {
+        context_.read_byte();
+        if (iter_.root) {
+            parse_whitespace();
+            if (*context_.get_context() != '\0')
+                ret = YDS_PARSE_ROOT_NOT_SINGULAR;
+        }
+    }
+    if (ret != YDS_PARSE_OK)
+        error_.path.insert(0, iter_.pointer);
+    iter_.active = false;
+    keys_.clear();
+    error_.code = ret;
+    error_.offset = ret == YDS_PARSE_OK ? 0 : context_.get_context() - iter_.json;
+    return false;
+}
+
+/**
+ * 按 JSON Pointer (RFC 6901) 逐段向下定位, 停在目标值的第一个字符上
+ * depth_ 记录经过的层数, 后面解析元素时仍然受 max_depth_ 限制
+*/
+int YdsJson::seek_pointer(const char* pointer) {
+    if (*pointer == '\0')
+        return YDS_PARSE_OK;
+    if (*pointer != '/')
+        return YDS_PARSE_POINTER_NOT_FOUND;
+
+    std::string seg;
+    const char* p = pointer;
+    while (*p == '/') {
+        seg.clear();
+        for (p++; *p && *p != '/'; p++) {
+            if (*p != '~')
+                seg += *p;
+            else if (p[1] == '0' || p[1] == '1')
+                seg += *++p == '0' ? '~' : '/';
+            else
+                return YDS_PARSE_POINTER_NOT_FOUND;
+        }
+        if (++depth_ > max_depth_)
+            return YDS_PARSE_DEPTH_EXCEEDED;
+
+        int ret;
+        switch (*context_.get_context()) {
+            case '{':   ret = seek_member(seg.data(), seg.size()); break;
+            case '[':   ret = seek_index(seg.data(), seg.size()); break;
+            default:    ret = YDS_PARSE_POINTER_NOT_FOUND; break;
+        }
+        if (ret != YDS_PARSE_OK)
+            return ret;
+    }
+    return YDS_PARSE_OK;
+}
+
+/*在对象里找键为 seg 的成员, 不相同的成员值直接跳过*/
+int YdsJson::seek_member(const char* seg, size_t len) {
+    int ret;
+    context_.read_byte();
+    parse_whitespace();
+    if (*context_.get_context() == '}')
+        return YDS_PARSE_POINTER_NOT_FOUND;
+    while (true) {
+        char* key;
+        size_t key_len;
+        if (*context_.get_context() != '"')
+            return YDS_PARSE_MISS_KEY;
+        if ((ret = parse_string_raw(&key, &key_len)) != YDS_PARSE_OK)
+            return ret;
+        /*key 指向已经出栈的内存, 在下一次入栈前比较*/
+        bool found = key_len == len && memcmp(key, seg, len) == 0;
+        parse_whitespace();
+        if (*context_.get_context() != ':')
+            return YDS_PARSE_MISS_COLON;
+        context_.read_byte();
+        parse_whitespace();
+        if (found)
+            return YDS_PARSE_OK;
+        if ((ret = skip_value()) != YDS_PARSE_OK)
+            return ret;
+        parse_whitespace();
+        if (*context_.get_context() == ',') {
+            context_.read_byte();
+            parse_whitespace();
+        }
+        else if (*context_.get_context() == '}')
+            return YDS_PARSE_POINTER_NOT_FOUND;
+        else
+            return YDS_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+    }
+}
+
+/*seg 必须是不带前导 0 的十进制下标, 前面的元素直接跳过*/
+int YdsJson::seek_index(const char* seg, size_t len) {
+    if (len == 0 || (len > 1 && seg[0] == '0'))
+        return YDS_PARSE_POINTER_NOT_FOUND;
+    size_t index = 0;
+    for (size_t i = 0; i < len; ++i) {
+        if (!ISDIGIT(seg[i]))
+            return YDS_PARSE_POINTER_NOT_FOUND;
+        index = index * 10 + (seg[i] - '0');
+    }
+
+    int ret;
+    context_.read_byte();
+    parse_whitespace();
+    if (*context_.get_context() == ']')
+        return YDS_PARSE_POINTER_NOT_FOUND;
+    for (size_t i = 0; i < index; ++i) {
+        if ((ret = skip_value()) != YDS_PARSE_OK)
+            return ret;
+        parse_whitespace();
+        if (*context_.get_context() == ',') {
+            context_.read_byte();
+            parse_whitespace();
+        }
+        else if (*context_.get_context() == ']')
+            return YDS_PARSE_POINTER_NOT_FOUND;
+        else
+            return YDS_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+    }
+    return YDS_PARSE_OK;
+}
+
+/**
+ * 出错后逐层返回时, 在路径前面加上当前层的下标或键(JSON Pointer 格式)
+ * 只在失败时调用, 成功的解析不构造路径
+*/
+void YdsJson::error_path_index(size_t index) {
+    error_.path.insert(0, "/" + std::to_string(index));
+}
+
+void YdsJson::error_path_key(const char* key, size_t len) {
+    std::string seg("/");
+    for (size_t i = 0; i < len; ++i) {
+        if (key[i] == '~') seg += "~0";
+        else if (key[i] == '/') seg += "~1";
+        else seg += key[i];
+    }
+    error_.path.insert(0, seg);
+}
+
+/**
+ * 行号和列号(从 1 开始, 列按字节计)在需要时才从原始输入计算
+ * 要求 parse 的输入仍然有效
+*/
+size_t YdsErrorInfo::line() const {
+    if (!json) return 0;
+    size_t line = 1;
+    for (size_t i = 0; i < offset; ++i)
+        if (json[i] == '\n') line++;
+    return line;
+}
+
+size_t YdsErrorInfo::column() const {
+    if (!json) return 0;
+    size_t i = offset;
+    while (i > 0 && json[i - 1] != '\n') i--;
+    return offset - i + 1;
+}
+
+/**
+ * 出错位置期望出现的记号
+*/
+const char* YdsErrorInfo::expected() const {
+    switch (code) {
+        case YDS_PARSE_OK:                              return "";
+        case YDS_PARSE_EXPECT_VALUE:
+        case YDS_PARSE_INVALID_VALUE:                   return "value";
+        case YDS_PARSE_ROOT_NOT_SINGULAR:               return "end of input";
+        case YDS_PARSE_NUMBER_TOO_BIG:                  return "number within double range";
+        case YDS_PARSE_INVALID_STRING_ESCAPE:           return "escape \\\" \\\\ \\/ \\b \\f \\n \\r \\t or \\u";
+        case YDS_PARSE_MISS_QUOTATION_MARK:             return "'\"'";
+        case YDS_PARSE_INVALID_STRING_CHAR:             return "character >= 0x20 or escape";
+        case YDS_PARSE_INVALID_UNICODE_HEX:             return "4 hex digits after \\u";
+        case YDS_PARSE_INVALID_UNICODE_SURROGATE:       return "low surrogate \\uDC00-\\uDFFF";
+        case YDS_PARSE_MISS_COMMA_OR_SQUARE_BRACKET:    return "',' or ']'";
+        case YDS_PARSE_MISS_KEY:                        return "string key";
+        case YDS_PARSE_MISS_COLON:                      return "':'";
+        case YDS_PARSE_MISS_COMMA_OR_CURLY_BRACKET:     return "',' or '}'";
+        case YDS_PARSE_DEPTH_EXCEEDED:                  return "nesting within max depth";
+        case YDS_PARSE_INVALID_UTF8:                    return "valid UTF-8";
+        case YDS_PARSE_TYPE_MISMATCH:                   return "value of the bound field type";
+        case YDS_PARSE_POINTER_NOT_FOUND:               return "value at the JSON Pointer";
+        default:                                        return "";
+    }
+}
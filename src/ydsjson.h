@@ -8,6 +8,7 @@
 #include <math.h>       /*HUGE_VAL*/
 #include "ydsvalue.h"
 #include "ydscontext.h"
+#include "ydsstats.h"
 /**
  * 定义解析结果返回值
 */
@@ -30,28 +31,171 @@ enum {
     YDS_PARSE_MISS_KEY,                     /*缺少键*/
     YDS_PARSE_MISS_COLON,                   /*缺少冒号*/
     YDS_PARSE_MISS_COMMA_OR_CURLY_BRACKET,  /*缺少圆括号*/
+
+    YDS_PARSE_DEPTH_EXCEEDED,               /*嵌套层数超过上限*/
+    YDS_PARSE_INVALID_UTF8,                 /*字符串不是合法的 UTF-8*/
+    YDS_PARSE_TYPE_MISMATCH,                /*值的类型与绑定的字段不符*/
+    YDS_PARSE_POINTER_NOT_FOUND,            /*JSON Pointer 指向的值不存在*/
+};
+
+/**
+ * 解析选项, 可按位组合后传给 parse
+*/
+enum {
+    YDS_PARSE_ITERATIVE = 1 << 0,           /*非递归解析, 嵌套深度不占用调用栈*/
+    YDS_PARSE_VALIDATE_UTF8 = 1 << 1,       /*校验字符串是否为合法的 UTF-8*/
+    YDS_PARSE_INTERN_KEYS = 1 << 2,         /*文档内相同的键共享内存*/
+    YDS_PARSE_IN_PLACE = 1 << 3,            /*数组/对象的子节点直接写入最终的内存, 不经过解析栈(只用于递归解析)*/
+    YDS_PARSE_PACK_NUMBERS = 1 << 4,        /*全是数字的数组存成紧凑的 double 数组(只用于递归解析), 见 YdsValue::is_packed*/
+};
+
+#define YDS_PARSE_INLINE_STACK_SIZE 256    /*内置解析栈大小, 小文档不需要申请堆内存*/
+#define YDS_PARSE_MAX_DEPTH         512    /*默认最大嵌套层数*/
+#define YDS_PARSE_IN_PLACE_INIT     4      /*YDS_PARSE_IN_PLACE 时子节点数组的默认初始容量*/
+#define YDS_PARSE_HINT_DEPTH        32     /*按层记录子节点个数的层数, 更深的层使用默认容量*/
+
+/**
+ * validate 的结果
+*/
+struct YdsValidateInfo {
+    size_t offset;          /*出错时停下的字节偏移, 成功时为输入长度*/
+    size_t max_depth;       /*最深嵌套层数(根为第 1 层)*/
+    size_t elements;        /*值的个数, 包括根、数组元素和对象成员的值*/
 };
 
+/**
+ * 最近一次 parse 的错误信息
+ * 成功时只记录 code, 行列号和期望的记号在调用时才计算
+*/
+struct YdsErrorInfo {
+    int code;               /*与 parse 的返回值相同*/
+    size_t offset;          /*出错的字节偏移*/
+    std::string path;       /*出错的值在文档中的位置, JSON Pointer 格式, 根为 ""*/
+    const char* json;       /*parse 的输入*/
+
+    size_t line() const;    /*需要 json 仍然有效, json 为 nullptr 时返回 0*/
+    size_t column() const;
+    const char* expected() const;
+};
+
+template <typename T, typename Enable = void> struct YdsReader;
+class YdsColumn;
+class YdsColumns;
+class YdsBatch;
+
 class YdsJson {
 public:
-    int parse(YdsValue* value, const char* json);
+    YdsJson();
+    int parse(YdsValue* value, const char* json, unsigned flags = 0);
+    int validate(const char* data, size_t len, YdsValidateInfo* info = nullptr, unsigned flags = 0);
+    void set_stack_buffer(char* buf, size_t size);
+    void reserve_stack(size_t len);
+    void set_max_depth(size_t depth) { max_depth_ = depth; }
+    size_t get_max_depth() const { return max_depth_; }
+    const YdsErrorInfo& get_error() const { return error_; }
+
+    /**
+     * 逐个读取数组元素, 不把整个数组放到解析栈上
+     * pointer 为 JSON Pointer, 指向要遍历的数组, "" 表示根
+     * 成功后反复调用 next_element, 返回 false 时结束, 出错时 get_error().code 不为 YDS_PARSE_OK
+     * 同一个 value 在每次迭代之间复用, 下一次 next_element 会释放上一个元素
+     * 开启 YDS_PARSE_INTERN_KEYS 时驻留表在整次遍历中共享, 各元素相同的键只保存一份
+    */
+    int begin_array(const char* json, const char* pointer = "", unsigned flags = 0);
+    bool next_element(YdsValue* value);
+    size_t get_element_index() const { return iter_.index; }  /*已读出的元素个数*/
+
+    /**
+     * 逐个读取首尾相接的多个根值, 例如 "{...}{...} [...] 1 2"
+     * 根值之间可以有空白, 也可以没有(两个数字或字面量之间必须有空白才能分开)
+     * 用法与 begin_array/next_element 相同, offset 返回该根值在输入中的字节偏移
+    */
+    void begin_many(const char* json, unsigned flags = 0);
+    bool next_document(YdsValue* value, size_t* offset = nullptr);
+    /*读取接下来最多 max_docs 个根值到 batch, 返回个数, 见 ydsbatch.h*/
+    size_t next_batch(YdsBatch* batch, size_t max_docs);
     //int parse(const std::string& json);
+    template <typename T> int parse_into(T* out, const char* json, unsigned flags = 0);  /*见 ydsbind.h*/
+    /*把 pointer 指向的记录数组加载到 out 的各列, 见 ydscolumn.h*/
+    int parse_columns(YdsColumns* out, const char* json, const char* pointer = "", unsigned flags = 0);
+#ifdef YDS_ENABLE_STATS
+    const YdsStats& get_stats() const { return stats_; }    /*最近一次 parse 的统计*/
+#endif
 
 private:
     int parse_value();
+    int dispatch_value();
     void parse_whitespace();
+    int skip_literal(const char* literal);
     int parse_literial(const char* literal, yds_type type);     /*解析字面量*/
+    const char* scan_number(const char* p) const;
+    int parse_number_raw(double* num);
     int parse_number();
     int parse_string();
     int parse_string_raw(char** str, size_t* len);
     const char* parse_hex4(const char* p, unsigned* u);
     void encode_utf8(unsigned u);
     int parse_array();
+    int parse_array_in_place();
+    bool parse_number_array(int* ret);
+    size_t children_hint() const { return depth_ < YDS_PARSE_HINT_DEPTH ? hint_[depth_] : YDS_PARSE_IN_PLACE_INIT; }
+    void update_children_hint(size_t size) { if (depth_ < YDS_PARSE_HINT_DEPTH) hint_[depth_] = size ? size : 1; }
+    int parse_key(char** key, size_t* len);
     int parse_object();
+    int parse_object_in_place();
+    int parse_iterative();
+    int push_member();
+    void unwind_frames(size_t frame, bool in_child);
+    void error_path_index(size_t index);
+    void error_path_key(const char* key, size_t len);
+    char peek(const char* p) const { return p == end_ ? '\0' : *p; }   /*到达 end_ 视为 '\0'*/
+    void skip_whitespace();
+    int skip_value();           /*只检查语法, 不生成节点*/
+    int skip_string();
+    int skip_number();
+    int skip_array();
+    int skip_object();
+    int seek_pointer(const char* pointer);
+    int seek_member(const char* seg, size_t len);
+    int seek_index(const char* seg, size_t len);
+    bool end_iteration(int ret);
+    int parse_record(YdsColumns* out, size_t level);
+    int parse_column_value(YdsColumn* column);
+
+    template <typename T, typename Enable> friend struct YdsReader;
+    template <typename T> friend int yds_read_value(YdsJson& json, T* out);
+    friend class YdsAsyncParser;
+
+    /*非递归解析时每层数组/对象在解析栈上的状态*/
+    struct YdsFrame {
+        size_t prev;        /*上一层帧的偏移*/
+        size_t size;        /*已完成的子元素个数*/
+        yds_type type;
+    };
 
 private:
     YdsValue* value_;        /*保存解析结果的数据结构*/
+    const char* end_;       /*skip 系列函数的输入结尾, nullptr 表示以 '\0' 结尾*/
     YdsContext context_;    /*解析过程的缓存空间*/
+    YdsKeyTable keys_;      /*键的驻留表*/
+    alignas(8) char stack_buffer_[YDS_PARSE_INLINE_STACK_SIZE];
+    unsigned flags_;        /*本次 parse 的选项*/
+    size_t depth_;          /*当前嵌套层数*/
+    size_t max_depth_;
+    struct { size_t max_depth, elements; } scan_;     /*skip 系列函数的计数*/
+    struct {
+        const char* json;   /*begin_array 的输入*/
+        std::string pointer;
+        size_t index;
+        bool active;        /*还有元素可读*/
+        bool root;          /*遍历的是根数组, 结束时检查后面没有其它内容*/
+        bool many;          /*begin_many 开始的遍历*/
+    } iter_;
+    YdsErrorInfo error_;
+    size_t hint_[YDS_PARSE_HINT_DEPTH];     /*每层上一个数组/对象的子节点个数, 跨 parse 保留*/
+#ifdef YDS_ENABLE_STATS
+    YdsStats stats_;
+#endif
 };
 
 #endif // !__YDSJSON_H__
\ No newline at end of file
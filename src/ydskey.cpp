@@ -0,0 +1,84 @@
+#include "ydskey.h"
+#include <assert.h>
+#include <string.h>
+#include "ydsstats.h"
+
+char* yds_key_new(const char* s, size_t len, uint32_t hash) {
+    size_t bytes = sizeof(YdsKeyHeader) + len + 1;
+    YdsKeyHeader* h = static_cast<YdsKeyHeader *>(yds_malloc(bytes));
+    YDS_STATS(yds_stats->alloc_count++; yds_stats->alloc_bytes += bytes);
+    h->refcnt = 1;
+    h->hash = hash;
+    h->owner = yds_allocator_id();
+    char* key = reinterpret_cast<char *>(h + 1);
+    if (len) memcpy(key, s, len);
+    key[len] = '\0';
+    return key;
+}
+
+char* yds_key_retain(char* key) {
+    yds_key_header(key)->refcnt++;
+    return key;
+}
+
+void yds_key_release(char* key, size_t len) {
+    if (!key) return;
+    YdsKeyHeader* h = yds_key_header(key);
+    if (--h->refcnt == 0)
+        yds_free(h->owner, h, sizeof(YdsKeyHeader) + len + 1);
+}
+
+YdsKeyTable::~YdsKeyTable() {
+    clear();
+    if (slots_) alloc_->free_fn(alloc_->ctx, slots_, capacity_ * sizeof(Slot));
+}
+
+/**
+ * 查找相同的键, 没有就新建并加入表中
+*/
+char* YdsKeyTable::intern(const char* s, size_t len) {
+    if ((count_ + 1) * 2 > capacity_)
+        grow();
+    uint32_t hash = yds_key_hash(s, len);
+    size_t mask = capacity_ - 1;
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+        Slot& slot = slots_[i];
+        if (!slot.key) {
+            slot.key = yds_key_new(s, len, hash);
+            slot.len = len;
+            count_++;
+            return yds_key_retain(slot.key);
+        }
+        if (slot.len == len && yds_key_get_hash(slot.key) == hash && memcmp(slot.key, s, len) == 0) {
+            YDS_STATS(yds_stats->interned_keys++);
+            return yds_key_retain(slot.key);
+        }
+    }
+}
+
+void YdsKeyTable::clear() {
+    if (!count_) return;
+    for (size_t i = 0; i < capacity_; ++i) {
+        yds_key_release(slots_[i].key, slots_[i].len);
+        slots_[i].key = nullptr;
+    }
+    count_ = 0;
+}
+
+/*负载超过一半时容量翻倍, 重新插入已有的键*/
+void YdsKeyTable::grow() {
+    const YdsAllocator* a = pin_ ? pin_ : yds_get_allocator();
+    size_t capacity = capacity_ ? capacity_ * 2 : 16;
+    Slot* slots = static_cast<Slot *>(a->malloc_fn(a->ctx, capacity * sizeof(Slot)));
+    memset(slots, 0, capacity * sizeof(Slot));
+    for (size_t i = 0; i < capacity_; ++i) {
+        if (!slots_[i].key) continue;
+        size_t j = yds_key_get_hash(slots_[i].key) & (capacity - 1);
+        while (slots[j].key) j = (j + 1) & (capacity - 1);
+        slots[j] = slots_[i];
+    }
+    if (slots_) alloc_->free_fn(alloc_->ctx, slots_, capacity_ * sizeof(Slot));
+    slots_ = slots;
+    capacity_ = capacity;
+    alloc_ = a;
+}
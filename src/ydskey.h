@@ -0,0 +1,68 @@
+#ifndef __YDSKEY_H__
+#define __YDSKEY_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ydsallocator.h"
+
+/**
+ * 对象的键
+ * 键的内存前面带一个头部, 保存引用计数和哈希值, YdsMember::key 指向头部之后的字符
+ * 同一份文档中相同的键可以共享一块内存, 最后一个引用释放时才真正 free
+ * 引用计数不是原子的, 键只在一份文档(或一次 begin_array/begin_many 遍历)内共享, clone 会复制键
+*/
+struct YdsKeyHeader {
+    size_t refcnt;
+    uint32_t hash;
+    uint8_t owner;      /*申请时的分配器编号, 释放时使用, 见 yds_allocator_from_id*/
+};
+
+/*FNV-1a, 结构体绑定的编译期哈希也使用它*/
+constexpr uint32_t yds_key_hash(const char* s, size_t len, uint32_t seed = 0) {
+    uint32_t h = 2166136261u ^ seed;
+    for (size_t i = 0; i < len; ++i)
+        h = (h ^ static_cast<unsigned char>(s[i])) * 16777619u;
+    return h;
+}
+
+inline YdsKeyHeader* yds_key_header(const char* key) {
+    return reinterpret_cast<YdsKeyHeader *>(const_cast<char *>(key)) - 1;
+}
+inline uint32_t yds_key_get_hash(const char* key) { return yds_key_header(key)->hash; }
+
+char* yds_key_new(const char* s, size_t len, uint32_t hash);   /*引用计数为 1*/
+char* yds_key_retain(char* key);
+void yds_key_release(char* key, size_t len);                    /*key 可以为 nullptr*/
+
+/**
+ * 键的驻留表, 开放寻址
+ * 表本身持有每个键的一个引用, clear() 时释放, 但保留槽位的内存供下一份文档使用
+*/
+class YdsKeyTable {
+public:
+    YdsKeyTable() : slots_(nullptr), capacity_(0), count_(0), alloc_(nullptr), pin_(nullptr) {}
+    ~YdsKeyTable();
+    YdsKeyTable(const YdsKeyTable&) = delete;
+    YdsKeyTable& operator=(const YdsKeyTable&) = delete;
+
+    char* intern(const char* s, size_t len);    /*返回一个新的引用*/
+    void clear();
+    size_t size() const { return count_; }
+    /*槽位数组使用的分配器, nullptr 表示扩容时线程的分配器; 键本身总是用线程的分配器*/
+    void pin_allocator(const YdsAllocator* alloc) { pin_ = alloc; }
+
+private:
+    struct Slot {
+        char* key;
+        size_t len;
+    };
+    void grow();
+
+    Slot* slots_;
+    size_t capacity_;       /*2 的幂*/
+    size_t count_;
+    const YdsAllocator* alloc_;     /*槽位数组所用的分配器*/
+    const YdsAllocator* pin_;
+};
+
+#endif // !__YDSKEY_H__
@@ -0,0 +1,170 @@
+#include "ydssource.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+size_t YdsMemorySource::read(char* buf, size_t cap) {
+    size_t n = len_ < cap ? len_ : cap;
+    memcpy(buf, data_, n);
+    data_ += n;
+    len_ -= n;
+    return n;
+}
+
+size_t YdsFdSource::read(char* buf, size_t cap) {
+    while (true) {
+        ssize_t n = ::read(fd_, buf, cap);
+        if (n >= 0)
+            return static_cast<size_t>(n);
+        if (errno != EINTR) {
+            error_ = YDS_SOURCE_IO_ERROR;
+            errno_ = errno;
+            return 0;
+        }
+    }
+}
+
+#ifdef YDS_WITH_ZLIB
+/****************************************************************
+ * gzip/zlib 解压
+ * *************************************************************/
+YdsGzipSource::YdsGzipSource(YdsSource* in, size_t window)
+    : in_(in), window_(window ? window : 1), in_eof_(false), done_(false) {
+    assert(in);
+    memset(&z_, 0, sizeof(z_));
+    /*15 位窗口 + 32: 根据头部自动识别 gzip 或 zlib*/
+    if (inflateInit2(&z_, 15 + 32) != Z_OK) {
+        error_ = YDS_SOURCE_CORRUPT;
+        done_ = true;
+    }
+}
+
+YdsGzipSource::~YdsGzipSource() {
+    inflateEnd(&z_);
+}
+
+/*上一块压缩数据用完时读取下一块, 读取失败返回 false*/
+bool YdsGzipSource::fill() {
+    if (z_.avail_in > 0 || in_eof_)
+        return true;
+    size_t n = in_->read(window_.data(), window_.size());
+    if (n == 0) {
+        if ((error_ = in_->get_error()) != YDS_SOURCE_OK) {
+            errno_ = in_->get_errno();
+            return false;
+        }
+        in_eof_ = true;
+    }
+    z_.next_in = reinterpret_cast<Bytef *>(window_.data());
+    z_.avail_in = static_cast<uInt>(n);
+    return true;
+}
+
+/*出错前已经解压的数据照常返回, 之后的调用返回 0*/
+size_t YdsGzipSource::read(char* buf, size_t cap) {
+    z_.next_out = reinterpret_cast<Bytef *>(buf);
+    z_.avail_out = static_cast<uInt>(cap < UINT32_MAX ? cap : UINT32_MAX);
+    while (!done_ && z_.avail_out > 0) {
+        if (!fill()) {
+            done_ = true;
+            break;
+        }
+        uInt before = z_.avail_out;
+        int ret = inflate(&z_, Z_NO_FLUSH);
+        if (ret == Z_STREAM_END) {
+            /*后面还有数据时是下一个 gzip 成员*/
+            if (!fill() || z_.avail_in == 0)
+                done_ = true;
+            else
+                inflateReset(&z_);
+        }
+        else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+            error_ = YDS_SOURCE_CORRUPT;
+            done_ = true;
+        }
+        else if (in_eof_ && z_.avail_in == 0 && z_.avail_out == before) {
+            error_ = YDS_SOURCE_TRUNCATED;
+            done_ = true;
+        }
+    }
+    return cap - z_.avail_out;
+}
+#endif
+
+/****************************************************************
+ * 后台线程预读
+ * *************************************************************/
+YdsThreadSource::YdsThreadSource(YdsSource* in, size_t window, size_t depth)
+    : in_(in), ring_(depth ? depth : 1), head_(0), count_(0), stop_(false), finished_(false) {
+    assert(in);
+    for (Block& b : ring_) {
+        b.data.resize(window ? window : 1);
+        b.len = b.pos = 0;
+    }
+    thread_ = std::thread(&YdsThreadSource::produce, this);
+}
+
+YdsThreadSource::~YdsThreadSource() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    drained_.notify_one();
+    thread_.join();
+}
+
+void YdsThreadSource::produce() {
+    size_t tail = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            drained_.wait(lock, [this] { return stop_ || count_ < ring_.size(); });
+            if (stop_)
+                return;
+        }
+        /*空闲的块只有生产端访问, 读取时不需要持有锁*/
+        Block& b = ring_[tail];
+        b.len = in_->read(b.data.data(), b.data.size());
+        b.pos = 0;
+        bool end = b.len == 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (end) {
+                error_ = in_->get_error();
+                errno_ = in_->get_errno();
+            }
+            count_++;
+        }
+        filled_.notify_one();
+        if (end)
+            return;
+        tail = (tail + 1) % ring_.size();
+    }
+}
+
+size_t YdsThreadSource::read(char* buf, size_t cap) {
+    if (finished_)
+        return 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    filled_.wait(lock, [this] { return count_ > 0; });
+    Block& b = ring_[head_];
+    if (b.len == 0) {
+        finished_ = true;
+        return 0;
+    }
+    lock.unlock();
+    /*填好的块只有消费端访问*/
+    size_t n = b.len - b.pos < cap ? b.len - b.pos : cap;
+    memcpy(buf, b.data.data() + b.pos, n);
+    b.pos += n;
+    if (b.pos == b.len) {
+        head_ = (head_ + 1) % ring_.size();
+        lock.lock();
+        count_--;
+        lock.unlock();
+        drained_.notify_one();
+    }
+    return n;
+}
@@ -0,0 +1,130 @@
+#ifndef __YDSSOURCE_H__
+#define __YDSSOURCE_H__
+
+#include <stddef.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#ifdef YDS_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#define YDS_SOURCE_WINDOW   (64 << 10)  /*解压和读取时每块的默认大小*/
+#define YDS_SOURCE_DEPTH    4           /*YdsThreadSource 默认预读的块数*/
+
+/**
+ * 数据源的错误
+*/
+enum {
+    YDS_SOURCE_OK = 0,
+    YDS_SOURCE_IO_ERROR,        /*read 失败, 见 get_errno()*/
+    YDS_SOURCE_CORRUPT,         /*压缩数据损坏*/
+    YDS_SOURCE_TRUNCATED,       /*压缩数据不完整*/
+};
+
+/**
+ * 输入源: 按块提供字节流, 配合 YdsAsyncParser::read_source 边读边解析
+ * 整个输入不需要同时放在内存里, 解析器只保留还没解析完的部分
+ *
+ *   YdsFdSource file(fd);
+ *   YdsGzipSource gz(&file);
+ *   YdsThreadSource pipe(&gz);         // 可选: 在另一个线程里解压
+ *   YdsValue v;
+ *   YdsAsyncParser parser(&v, 0, SIZE_MAX);
+ *   if (parser.read_source(&pipe) != YDS_ASYNC_DONE) ...
+ *
+ * 各个源不持有被包装的源, 使用期间需要保证它有效
+*/
+class YdsSource {
+public:
+    virtual ~YdsSource() {}
+    /*读取最多 cap 字节, 返回读到的字节数; 返回 0 表示结束, 出错时 get_error() 不为 YDS_SOURCE_OK*/
+    virtual size_t read(char* buf, size_t cap) = 0;
+    int get_error() const { return error_; }
+    int get_errno() const { return errno_; }
+
+protected:
+    YdsSource() : error_(YDS_SOURCE_OK), errno_(0) {}
+    int error_;
+    int errno_;
+};
+
+class YdsMemorySource : public YdsSource {
+public:
+    YdsMemorySource(const char* data, size_t len) : data_(data), len_(len) {}
+    size_t read(char* buf, size_t cap) override;
+
+private:
+    const char* data_;
+    size_t len_;
+};
+
+/*阻塞的 fd(文件、管道); 非阻塞的 fd 直接用 YdsAsyncParser::read_fd*/
+class YdsFdSource : public YdsSource {
+public:
+    explicit YdsFdSource(int fd) : fd_(fd) {}
+    size_t read(char* buf, size_t cap) override;
+
+private:
+    int fd_;
+};
+
+#ifdef YDS_WITH_ZLIB
+/**
+ * 解压 gzip 或 zlib 格式(自动识别), 支持首尾相接的多个 gzip 成员
+ * 每次从 in 读取 window 字节的压缩数据
+*/
+class YdsGzipSource : public YdsSource {
+public:
+    explicit YdsGzipSource(YdsSource* in, size_t window = YDS_SOURCE_WINDOW);
+    ~YdsGzipSource();
+    YdsGzipSource(const YdsGzipSource&) = delete;
+    YdsGzipSource& operator=(const YdsGzipSource&) = delete;
+    size_t read(char* buf, size_t cap) override;
+
+private:
+    bool fill();
+
+    YdsSource* in_;
+    std::vector<char> window_;
+    z_stream z_;
+    bool in_eof_;
+    bool done_;
+};
+#endif
+
+/**
+ * 在后台线程里读取 in, 最多预读 depth 块, 每块 window 字节
+ * 包装解压源时解压和解析在两个核上同时进行
+ * in 只在后台线程中使用; 析构时等待后台线程结束
+*/
+class YdsThreadSource : public YdsSource {
+public:
+    explicit YdsThreadSource(YdsSource* in, size_t window = YDS_SOURCE_WINDOW, size_t depth = YDS_SOURCE_DEPTH);
+    ~YdsThreadSource();
+    YdsThreadSource(const YdsThreadSource&) = delete;
+    YdsThreadSource& operator=(const YdsThreadSource&) = delete;
+    size_t read(char* buf, size_t cap) override;
+
+private:
+    struct Block {
+        std::vector<char> data;
+        size_t len;         /*0 表示 in 已经结束*/
+        size_t pos;         /*已经被 read 取走的字节*/
+    };
+    void produce();
+
+    YdsSource* in_;
+    std::vector<Block> ring_;
+    size_t head_;           /*消费端正在读的块*/
+    size_t count_;          /*已经填好还没读完的块数*/
+    bool stop_;
+    bool finished_;         /*生产端已经放入了结束块*/
+    std::mutex mutex_;
+    std::condition_variable filled_;
+    std::condition_variable drained_;
+    std::thread thread_;
+};
+
+#endif // !__YDSSOURCE_H__
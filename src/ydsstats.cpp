@@ -0,0 +1,5 @@
+#include "ydsstats.h"
+
+#ifdef YDS_ENABLE_STATS
+thread_local YdsStats* yds_current_stats = nullptr;
+#endif
@@ -0,0 +1,37 @@
+#ifndef __YDSSTATS_H__
+#define __YDSSTATS_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * 单次解析的统计信息
+ * 只有定义了 YDS_ENABLE_STATS 才会统计, 否则所有埋点展开为空
+*/
+struct YdsStats {
+    size_t alloc_count;         /*YdsValue 分配次数(字符串/数组/对象/键)*/
+    size_t alloc_bytes;         /*YdsValue 分配字节数*/
+    size_t stack_realloc_count; /*解析栈 realloc 次数*/
+    size_t stack_realloc_bytes; /*解析栈 realloc 后的容量累计*/
+    size_t max_depth;           /*最深嵌套层数*/
+    size_t escaped_strings;     /*包含转义的字符串个数*/
+    size_t interned_keys;       /*驻留表命中、没有重新分配的键个数*/
+    uint64_t type_ns[7];        /*按 yds_type 统计的解析耗时(纳秒, 包含子节点)*/
+
+    void reset() { memset(this, 0, sizeof(*this)); }
+};
+
+#ifdef YDS_ENABLE_STATS
+/*当前线程正在统计的解析, 由 YdsJson::parse 设置*/
+extern thread_local YdsStats* yds_current_stats;
+
+#define YDS_STATS(stmt) \
+    do { \
+        if (YdsStats* yds_stats = yds_current_stats) { stmt; } \
+    } while (0)
+#else
+#define YDS_STATS(stmt) do { } while (0)
+#endif
+
+#endif // !__YDSSTATS_H__
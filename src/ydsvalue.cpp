@@ -1 +1,212 @@
 #include "ydsvalue.h"
+#include <vector>
+
+/**
+ * 深拷贝
+ * 每个数组/对象只申请一次, 子节点整块 memcpy, 之后只处理持有内存的子节点(字符串/数组/对象)
+ * 键也复制一份: 原文档的键可能在区域分配器里(YdsBatch), 引用计数也不是原子的,
+ * 共享会让副本的生命周期和所在线程受原文档限制
+*/
+void YdsValue::clone(YdsValue* out) const {
+    assert(out && out != this);
+    out->destroy();
+    clone_into(out);
+}
+
+/*out 的内容视为未初始化, 不能调用 destroy(按位拷贝过来的指针仍属于原文档)*/
+void YdsValue::clone_into(YdsValue* out) const {
+    if (!owns_memory()) {
+        /*数字、字面量和短字符串整个节点就是全部内容*/
+        memcpy(static_cast<void *>(out), this, sizeof(YdsValue));
+        return;
+    }
+    switch (get_type()) {
+        case YDS_STRING:
+            out->s_.s = static_cast<char *>(yds_malloc(s_.len + 1));
+            YDS_STATS(yds_stats->alloc_count++; yds_stats->alloc_bytes += s_.len + 1);
+            memcpy(out->s_.s, s_.s, s_.len + 1);
+            out->s_.len = s_.len;
+            break;
+
+        case YDS_ARRAY:
+            if (is_packed()) {
+                out->p_.size = p_.size;
+                out->p_.d = static_cast<double *>(yds_malloc(p_.size * sizeof(double)));
+                YDS_STATS(yds_stats->alloc_count++; yds_stats->alloc_bytes += p_.size * sizeof(double));
+                memcpy(out->p_.d, p_.d, p_.size * sizeof(double));
+                break;
+            }
+            out->a_.size = a_.size;
+            out->a_.e = nullptr;
+            if (a_.size) {
+                size_t bytes = a_.size * sizeof(YdsValue);
+                out->a_.e = static_cast<YdsValue *>(yds_malloc(bytes));
+                YDS_STATS(yds_stats->alloc_count++; yds_stats->alloc_bytes += bytes);
+                memcpy(static_cast<void *>(out->a_.e), a_.e, bytes);
+                for (size_t i = 0; i < a_.size; ++i)
+                    if (a_.e[i].owns_memory())
+                        a_.e[i].clone_into(&out->a_.e[i]);
+            }
+            break;
+
+        case YDS_OBJECT:
+            out->o_.size = o_.size;
+            out->o_.m = nullptr;
+            if (o_.size) {
+                size_t bytes = o_.size * sizeof(YdsMember);
+                out->o_.m = static_cast<YdsMember *>(yds_malloc(bytes));
+                YDS_STATS(yds_stats->alloc_count++; yds_stats->alloc_bytes += bytes);
+                memcpy(static_cast<void *>(out->o_.m), o_.m, bytes);
+                for (size_t i = 0; i < o_.size; ++i) {
+                    const YdsMember& m = o_.m[i];
+                    out->o_.m[i].key = yds_key_new(m.key, m.key_len, yds_key_get_hash(m.key));
+                    if (o_.m[i].v.owns_memory())
+                        o_.m[i].v.clone_into(&out->o_.m[i].v);
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+    out->h_.tag = h_.tag;
+    out->h_.owner = yds_allocator_id();
+}
+
+static inline bool same_key(const YdsMember& a, const YdsMember& b) {
+    return a.key == b.key ||
+           (a.key_len == b.key_len && yds_key_get_hash(a.key) == yds_key_get_hash(b.key) &&
+            memcmp(a.key, b.key, a.key_len) == 0);
+}
+
+/**
+ * 结构相等
+ * 同一个节点、类型/长度/成员数不同时立即返回
+ * 对象先按相同位置比较成员(通常顺序一致), 不一致时再在 other 中找键和值都相同、还没有匹配过的成员
+*/
+bool YdsValue::equals(const YdsValue& other) const {
+    if (this == &other) return true;
+    if (get_type() != other.get_type()) return false;
+    switch (get_type()) {
+        case YDS_NUMBER:
+            return n_.num == other.n_.num;
+        case YDS_STRING:
+            return get_string_len() == other.get_string_len() &&
+                   memcmp(get_string(), other.get_string(), get_string_len()) == 0;
+        case YDS_ARRAY:
+            if (a_.size != other.a_.size) return false;
+            if (is_packed() || other.is_packed()) {
+                /*紧凑数组与元素全是数字的普通数组相等*/
+                for (size_t i = 0; i < a_.size; ++i) {
+                    if ((!is_packed() && a_.e[i].get_type() != YDS_NUMBER) ||
+                        (!other.is_packed() && other.a_.e[i].get_type() != YDS_NUMBER) ||
+                        get_array_number(i) != other.get_array_number(i))
+                        return false;
+                }
+                return true;
+            }
+            for (size_t i = 0; i < a_.size; ++i)
+                if (!a_.e[i].equals(other.a_.e[i])) return false;
+            return true;
+        case YDS_OBJECT: {
+            if (o_.size != other.o_.size) return false;
+            /*other 的每个成员只能匹配一次, 否则 {"a":1,"a":1} 会等于 {"a":1,"b":2}*/
+            const size_t size = o_.size;
+            uint64_t small = 0;
+            std::vector<bool> large(size > 64 ? size : 0);
+            auto used = [&](size_t j) { return size > 64 ? static_cast<bool>(large[j]) : ((small >> j) & 1) != 0; };
+            auto mark = [&](size_t j) { if (size > 64) large[j] = true; else small |= static_cast<uint64_t>(1) << j; };
+            for (size_t i = 0; i < size; ++i) {
+                const YdsMember& m = o_.m[i];
+                size_t j = i;
+                if (used(i) || !same_key(m, other.o_.m[i]) || !m.v.equals(other.o_.m[i].v)) {
+                    for (j = 0; j < size; ++j) {
+                        if (j == i || used(j)) continue;
+                        if (same_key(m, other.o_.m[j]) && m.v.equals(other.o_.m[j].v)) break;
+                    }
+                    if (j == size) return false;
+                }
+                mark(j);
+            }
+            return true;
+        }
+        default:
+            return true;
+    }
+}
+
+static inline uint64_t hash_mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+/*每次处理 8 字节, 按小端组装, 结果与平台和进程无关*/
+static uint64_t hash_bytes(const char* s, size_t len, uint64_t seed) {
+    uint64_t h = seed ^ (len * 0x9E3779B97F4A7C15ull);
+    const unsigned char* p = reinterpret_cast<const unsigned char *>(s);
+    for (; len >= 8; p += 8, len -= 8) {
+        uint64_t k = 0;
+        for (int i = 7; i >= 0; --i) k = (k << 8) | p[i];
+        h = hash_mix(h ^ k);
+    }
+    uint64_t k = 0;
+    for (size_t i = len; i > 0; --i) k = (k << 8) | p[i - 1];
+    return hash_mix(h ^ k ^ 0x27D4EB2F165667C5ull);
+}
+
+static uint64_t hash_number(double num) {
+    double d = num == 0 ? 0.0 : num;     /*-0 与 0 相等*/
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    return hash_mix(0x9E3779B97F4A7C15ull * (YDS_NUMBER + 1) ^ bits);
+}
+
+/**
+ * 内容哈希, equals 为真的两个值哈希一定相同
+ * 数组按顺序组合; 对象各成员的哈希相加, 与成员顺序无关
+*/
+uint64_t YdsValue::hash() const {
+    uint64_t seed = 0x9E3779B97F4A7C15ull * (get_type() + 1);
+    switch (get_type()) {
+        case YDS_NUMBER:
+            return hash_number(n_.num);
+        case YDS_STRING:
+            return hash_bytes(get_string(), get_string_len(), seed);
+        case YDS_ARRAY: {
+            /*紧凑数组与对应的普通数组哈希相同*/
+            uint64_t h = seed ^ a_.size;
+            for (size_t i = 0; i < a_.size; ++i)
+                h = hash_mix(h * 31 + (is_packed() ? hash_number(p_.d[i]) : a_.e[i].hash()));
+            return h;
+        }
+        case YDS_OBJECT: {
+            uint64_t sum = 0;
+            for (size_t i = 0; i < o_.size; ++i) {
+                const YdsMember& m = o_.m[i];
+                /*键的哈希在解析时已经算好*/
+                uint64_t key = hash_mix((static_cast<uint64_t>(yds_key_get_hash(m.key)) << 32) ^ m.key_len);
+                sum += hash_mix(key ^ (m.v.hash() * 0xC2B2AE3D27D4EB4Full));
+            }
+            return hash_mix(seed ^ o_.size ^ sum);
+        }
+        default:
+            return hash_mix(seed);
+    }
+}
+
+void YdsValue::unpack() {
+    if (!is_packed())
+        return;
+    size_t size = p_.size;
+    YdsValue* e = static_cast<YdsValue *>(yds_malloc(size * sizeof(YdsValue)));
+    YDS_STATS(yds_stats->alloc_count++; yds_stats->alloc_bytes += size * sizeof(YdsValue));
+    for (size_t i = 0; i < size; ++i) {
+        e[i].init();
+        e[i].set_number(p_.d[i]);
+    }
+    adopt_array(e, size);
+}
@@ -1,10 +1,14 @@
 #ifndef __YDSVALUE_H__
 #define __YDSVALUE_H__
 
+#include <stdint.h>
 #include <string.h>
 #include <stdlib.h>
 #include <assert.h>
 #include <iostream>
+#include "ydsstats.h"
+#include "ydsallocator.h"
+#include "ydskey.h"
 
 /**
  * 数据类型
@@ -19,106 +23,237 @@ typedef enum {
     YDS_OBJECT
 } yds_type;
 
+struct YdsMember;
+
+#define YDS_KEY_NOT_EXIST   ((size_t)-1)
+#define YDS_SHORT_STRING_MAX    14      /*不超过此长度的字符串直接存放在节点内, 不申请内存*/
+
 /**
- * 保存数据的结构体
+ * 保存数据的结构体, 固定 16 字节
+ * 字符串长度和数组/对象的元素个数用 32 位保存, 不能超过 UINT32_MAX
 */
 class YdsValue {
 public:
-    YdsValue() : type_(YDS_NULL) {}
+    YdsValue() { h_.tag = YDS_NULL; }
     ~YdsValue() { destroy(); }
-    void init() { type_ = YDS_NULL; }
+    /*子节点只能有一个所有者, 需要副本时使用 clone*/
+    YdsValue(const YdsValue&) = delete;
+    YdsValue& operator=(const YdsValue&) = delete;
+    void init() { h_.tag = YDS_NULL; }
 
-    yds_type get_type() const { return type_; }
-    void set_type(yds_type type) { destroy(); type_ = type; }
+    yds_type get_type() const { return static_cast<yds_type>(h_.tag & YDS_TAG_TYPE_MASK); }
+    void set_type(yds_type type) { destroy(); h_.tag = type; }
 
     bool get_boolean() const { 
-        assert(type_ == YDS_TRUE || type_ == YDS_FALSE); 
-        return type_ == YDS_TRUE; 
+        assert(get_type() == YDS_TRUE || get_type() == YDS_FALSE); 
+        return get_type() == YDS_TRUE; 
     }
-    void set_boolean(bool value) { destroy(); type_ = value ? YDS_TRUE : YDS_FALSE; }
+    void set_boolean(bool value) { destroy(); h_.tag = value ? YDS_TRUE : YDS_FALSE; }
 
-    double get_number() const { assert(type_ == YDS_NUMBER); return num_; }
-    void set_number(double number) { destroy(); num_ = number; type_ = YDS_NUMBER; }
+    double get_number() const { assert(get_type() == YDS_NUMBER); return n_.num; }
+    void set_number(double number) { destroy(); n_.num = number; h_.tag = YDS_NUMBER; }
 
-    const char* get_string() const { assert(type_ == YDS_STRING); return s_.s; }
-    size_t get_string_len() const { assert(type_ == YDS_STRING); return s_.len; }
+    const char* get_string() const { assert(get_type() == YDS_STRING); return is_short_string() ? ss_.s : s_.s; }
+    size_t get_string_len() const {
+        assert(get_type() == YDS_STRING);
+        return is_short_string() ? h_.tag >> YDS_TAG_LEN_SHIFT : s_.len;
+    }
     void set_string(const char* s, size_t len) { 
-        assert(s || len == 0);
+        assert((s || len == 0) && len <= UINT32_MAX);
         destroy();
-        s_.s = static_cast<char *>(malloc(len + 1));
-        memcpy(s_.s, s, len); s_.len = len; 
+        if (len <= YDS_SHORT_STRING_MAX) {
+            if (len) memcpy(ss_.s, s, len);
+            ss_.s[len] = '\0';
+            h_.tag = static_cast<uint8_t>(YDS_STRING | YDS_TAG_SHORT_STRING | (len << YDS_TAG_LEN_SHIFT));
+            return;
+        }
+        s_.s = static_cast<char *>(yds_malloc(len + 1));
+        YDS_STATS(yds_stats->alloc_count++; yds_stats->alloc_bytes += len + 1);
+        memcpy(s_.s, s, len);
         s_.s[len] = '\0';
-        s_.len = len;
-        type_ = YDS_STRING;
+        s_.len = static_cast<uint32_t>(len);
+        h_.tag = YDS_STRING;
+        h_.owner = yds_allocator_id();
     }
 
+    /*接管 a 中 size 个子节点的所有权(按位拷贝, 调用者不能再释放它们)*/
     void set_array(char* a, size_t size) {
+        assert(size <= UINT32_MAX);
         destroy();
         if (size) {
-            a_.e = static_cast<YdsValue *>(malloc(size * sizeof(YdsValue)));
-            memcpy(a_.e, a, size * sizeof(YdsValue));
+            a_.e = static_cast<YdsValue *>(yds_malloc(size * sizeof(YdsValue)));
+            YDS_STATS(yds_stats->alloc_count++; yds_stats->alloc_bytes += size * sizeof(YdsValue));
+            memcpy(static_cast<void *>(a_.e), a, size * sizeof(YdsValue));
         }
         else a_.e = nullptr;
         
-        a_.size = size;
-        type_ = YDS_ARRAY;
+        a_.size = static_cast<uint32_t>(size);
+        h_.tag = YDS_ARRAY;
+        h_.owner = yds_allocator_id();
+    }
+    /*直接接管 e 的所有权, e 必须是当前分配器申请的、恰好 size 个元素大小的内存*/
+    void adopt_array(YdsValue* e, size_t size) {
+        assert((e || size == 0) && size <= UINT32_MAX);
+        destroy();
+        a_.e = e;
+        a_.size = static_cast<uint32_t>(size);
+        h_.tag = YDS_ARRAY;
+        h_.owner = yds_allocator_id();
     }
     //void set_array_size(size_t size) {}
-    YdsValue* get_array_element(size_t index) const { assert(type_ == YDS_ARRAY); return &a_.e[index]; }
-    size_t get_array_size() const { assert(type_ == YDS_ARRAY); return a_.size; }
+    /*紧凑的数字数组没有子节点, 需要先 unpack*/
+    YdsValue* get_array_element(size_t index) const { assert(get_type() == YDS_ARRAY && !is_packed()); return &a_.e[index]; }
+    size_t get_array_size() const { assert(get_type() == YDS_ARRAY); return a_.size; }
 
+    /**
+     * 紧凑的数字数组(YDS_PARSE_PACK_NUMBERS)
+     * 类型仍然是 YDS_ARRAY, 元素直接存成连续的 get_array_size() 个 double
+    */
+    bool is_packed() const { return get_type() == YDS_ARRAY && (h_.tag & YDS_TAG_PACKED); }
+    const double* get_packed_numbers() const { assert(is_packed()); return p_.d; }
+    double get_array_number(size_t index) const {
+        assert(index < get_array_size());
+        return is_packed() ? p_.d[index] : a_.e[index].get_number();
+    }
+    /*直接接管 d 的所有权, d 必须是当前分配器申请的、恰好 size 个 double 大小的内存*/
+    void adopt_packed_numbers(double* d, size_t size) {
+        assert(d && size && size <= UINT32_MAX);
+        destroy();
+        p_.d = d;
+        p_.size = static_cast<uint32_t>(size);
+        h_.tag = YDS_ARRAY | YDS_TAG_PACKED;
+        h_.owner = yds_allocator_id();
+    }
+    void unpack();          /*转换成每个元素一个节点的普通数组*/
+
+    /*接管 o 中 size 个成员的所有权, len 为字节数*/
     void set_object(char* o, size_t len, size_t size) { 
+        assert(size <= UINT32_MAX);
         destroy();
         if (size) {
-            o_.m = static_cast<YdsMember *>(malloc(len));
-            memcpy(o_.m, o, size * sizeof(YdsValue));
+            o_.m = static_cast<YdsMember *>(yds_malloc(len));
+            YDS_STATS(yds_stats->alloc_count++; yds_stats->alloc_bytes += len);
+            memcpy(static_cast<void *>(o_.m), o, len);
         }
         else o_.m = nullptr;
 
-        o_.size = size;
-        type_ = YDS_OBJECT;
+        o_.size = static_cast<uint32_t>(size);
+        h_.tag = YDS_OBJECT;
+        h_.owner = yds_allocator_id();
     }
-    const char* get_object_key(size_t index) const { assert(type_ == YDS_OBJECT); return o_.m[index].key; }
-    size_t get_object_key_len(size_t index) const { assert(type_ == YDS_OBJECT); return o_.m[index].key_len; }
-    YdsValue* get_object_value(size_t index) const { assert(type_ == YDS_OBJECT); return o_.m[index].v; }
-    size_t get_object_size() const { assert(type_ == YDS_OBJECT); return o_.size; }
-
-    void destroy() {
-        switch (type_) {
-            case YDS_STRING:
-                free(s_.s);
-                break;
-            case YDS_ARRAY:
-                for (int i = 0; i < a_.size; ++i) {
-                    //destroy(&a_.e[i]);
-                    a_.e[i].destroy();
-                }
-                //free(&a_);
-                free(a_.e);
-                break;
-            default: 
-                break;
-        }
-        type_ = YDS_NULL;
+    void adopt_object(YdsMember* m, size_t size) {
+        assert((m || size == 0) && size <= UINT32_MAX);
+        destroy();
+        o_.m = m;
+        o_.size = static_cast<uint32_t>(size);
+        h_.tag = YDS_OBJECT;
+        h_.owner = yds_allocator_id();
     }
+    inline const char* get_object_key(size_t index) const;
+    inline size_t get_object_key_len(size_t index) const;
+    inline YdsValue* get_object_value(size_t index) const;
+    size_t get_object_size() const { assert(get_type() == YDS_OBJECT); return o_.size; }
+    inline size_t find_object_index(const char* key, size_t len) const;
+
+    inline void destroy();
+
+    void clone(YdsValue* out) const;                /*深拷贝到 out, 与原文档不共享任何内存*/
+    bool equals(const YdsValue& other) const;       /*结构相等, 对象成员不区分顺序*/
+    uint64_t hash() const;                          /*与 equals 一致的 64 位内容哈希*/
 
 private:
-    struct YdsMember;
-    /*使用联合体节省内存*/
-    union {
-        double num_;/*数字*/
-        struct { char* s; size_t len; } s_;/*字符串*/
-        struct { YdsValue* e; size_t size; } a_; /*数组*/
-        struct { YdsMember* m; size_t size; }o_;
+    void clone_into(YdsValue* out) const;
+
+    /**
+     * 标签: 低 3 位为类型, 高 4 位为短字符串的长度
+     * 第 3 位对字符串表示短字符串, 对数组表示紧凑的数字数组
+    */
+    enum {
+        YDS_TAG_TYPE_MASK = 0x07,
+        YDS_TAG_SHORT_STRING = 0x08,
+        YDS_TAG_PACKED = 0x08,
+        YDS_TAG_LEN_SHIFT = 4,
+    };
+    bool is_short_string() const { return (h_.tag & YDS_TAG_SHORT_STRING) != 0; }
+    /*节点是否持有堆内存(长字符串/数组/对象), 按位拷贝后需要深拷贝的就是这些*/
+    bool owns_memory() const { return get_type() > YDS_STRING || (get_type() == YDS_STRING && !is_short_string()); }
 
+    /**
+     * 使用联合体节省内存
+     * 每种布局都以标签字节开头, 任何时候都可以通过 h_ 读取类型
+     * 持有内存的节点在标签之后的空位记下申请时的分配器编号(短字符串的这个字节是字符)
+     * 释放时按编号走原来的分配器, 见 yds_allocator_from_id
+    */
+    union {
+        struct { uint8_t tag; uint8_t owner; } h_;
+        struct { uint8_t tag; double num; } n_;                                 /*数字*/
+        struct { uint8_t tag; uint32_t len; char* s; } s_;                      /*字符串*/
+        struct { uint8_t tag; char s[YDS_SHORT_STRING_MAX + 1]; } ss_;          /*短字符串, 以 '\0' 结尾*/
+        struct { uint8_t tag; uint32_t size; YdsValue* e; } a_;                 /*数组*/
+        struct { uint8_t tag; uint32_t size; double* d; } p_;                   /*紧凑的数字数组*/
+        struct { uint8_t tag; uint32_t size; YdsMember* m; } o_;
     };
-    yds_type type_;
 };
 
+static_assert(sizeof(YdsValue) == 16, "YdsValue should be 16 bytes");
+
 struct YdsMember {
-    char* key;
+    char* key;          /*带引用计数, 见 ydskey.h*/
     size_t key_len;
     YdsValue v;//?
 };
 
+/*YdsMember 定义完整之后才能访问成员*/
+inline const char* YdsValue::get_object_key(size_t index) const { assert(get_type() == YDS_OBJECT); return o_.m[index].key; }
+inline size_t YdsValue::get_object_key_len(size_t index) const { assert(get_type() == YDS_OBJECT); return o_.m[index].key_len; }
+inline YdsValue* YdsValue::get_object_value(size_t index) const { assert(get_type() == YDS_OBJECT); return &o_.m[index].v; }
+
+/**
+ * 按键查找成员下标, 找不到返回 YDS_KEY_NOT_EXIST
+ * 传入的 key 如果就是驻留的键(例如另一条记录的 get_object_key), 比较指针即可命中
+*/
+inline size_t YdsValue::find_object_index(const char* key, size_t len) const {
+    assert(get_type() == YDS_OBJECT && (key || len == 0));
+    for (size_t i = 0; i < o_.size; ++i)
+        if (o_.m[i].key == key) return i;
+    uint32_t hash = yds_key_hash(key, len);
+    for (size_t i = 0; i < o_.size; ++i) {
+        const YdsMember& m = o_.m[i];
+        if (m.key_len == len && yds_key_get_hash(m.key) == hash && memcmp(m.key, key, len) == 0)
+            return i;
+    }
+    return YDS_KEY_NOT_EXIST;
+}
+
+inline void YdsValue::destroy() {
+    switch (get_type()) {
+        case YDS_STRING:
+            if (!is_short_string())
+                yds_free(h_.owner, s_.s, s_.len + 1);
+            break;
+        case YDS_ARRAY:
+            if (is_packed()) {
+                yds_free(h_.owner, p_.d, p_.size * sizeof(double));
+                break;
+            }
+            for (size_t i = 0; i < a_.size; ++i) {
+                //destroy(&a_.e[i]);
+                a_.e[i].destroy();
+            }
+            //free(&a_);
+            yds_free(h_.owner, a_.e, a_.size * sizeof(YdsValue));
+            break;
+        case YDS_OBJECT:
+            for (size_t i = 0; i < o_.size; ++i) {
+                yds_key_release(o_.m[i].key, o_.m[i].key_len);
+                o_.m[i].v.destroy();
+            }
+            yds_free(h_.owner, o_.m, o_.size * sizeof(YdsMember));
+            break;
+        default: 
+            break;
+    }
+    h_.tag = YDS_NULL;
+}
+
 #endif // !__YDSVALUE_H__
\ No newline at end of file
@@ -1,5 +1,14 @@
 #include "../src/ydsjson.h"
+#include "../src/ydsutf8.h"
+#include "../src/ydsbind.h"
+#include "../src/ydscolumn.h"
+#include "../src/ydsbatch.h"
+#include "../src/ydsasync.h"
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
 #include <iostream>
+#include <thread>
 
 static int main_ret = 0;
 static int test_count = 0;
@@ -54,6 +63,17 @@ static void test_parse_false() {
     EXPECT_EQ(YDS_FALSE, value.get_type());
 }
 
+/*把 json 拷到恰好等长、不以 '\0' 结尾的缓冲区里再 validate, 越界读取会被 sanitizer 发现*/
+static int validate_exact(const char* json, YdsValidateInfo* info = nullptr) {
+    size_t len = strlen(json);
+    char* buf = static_cast<char *>(malloc(len ? len : 1));
+    memcpy(buf, json, len);
+    YdsJson json_parse;
+    int ret = json_parse.validate(buf, len, info);
+    free(buf);
+    return ret;
+}
+
 #define TEST_NUMBER(EXPECT, json) \
     do { \
         YdsJson json_parse; \
@@ -165,8 +185,254 @@ static void test_parse_object() {
     EXPECT_EQ_SIZE(0, value.get_object_size());
 
     //value.set_type((YDS_NULL));
+    EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&value,
+        " { "
+        "\"n\" : null , "
+        "\"t\" : true , "
+        "\"i\" : 123 , "
+        "\"s\" : \"abc\", "
+        "\"a\" : [ 1, 2, 3 ],"
+        "\"o\" : { \"1\" : 1, \"2\" : 2 }"
+        " } "));
+    EXPECT_EQ(YDS_OBJECT, value.get_type());
+    EXPECT_EQ_SIZE(6, value.get_object_size());
+    EXPECT_EQ_STRING("n", value.get_object_key(0), value.get_object_key_len(0));
+    EXPECT_EQ(YDS_NULL, value.get_object_value(0)->get_type());
+    EXPECT_EQ(YDS_TRUE, value.get_object_value(1)->get_type());
+    EXPECT_EQ(123.0, value.get_object_value(2)->get_number());
+    EXPECT_EQ_STRING("abc", value.get_object_value(3)->get_string(),
+                     value.get_object_value(3)->get_string_len());
+    EXPECT_EQ_SIZE(3, value.get_object_value(4)->get_array_size());
+    EXPECT_EQ(3.0, value.get_object_value(4)->get_array_element(2)->get_number());
+    EXPECT_EQ_STRING("o", value.get_object_key(5), value.get_object_key_len(5));
+    EXPECT_EQ_SIZE(2, value.get_object_value(5)->get_object_size());
+    EXPECT_EQ(2.0, value.get_object_value(5)->get_object_value(1)->get_number());
+}
+
+#define TEST_UTF8(expect, json) \
+    do { \
+        YdsValue value; \
+        YdsJson json_parse; \
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&value, json)); \
+        EXPECT_EQ(expect, json_parse.parse(&value, json, YDS_PARSE_VALIDATE_UTF8)); \
+        EXPECT_EQ(expect, json_parse.parse(&value, json, YDS_PARSE_VALIDATE_UTF8 | YDS_PARSE_ITERATIVE)); \
+    } while (0)
+
+static void test_parse_utf8() {
+    TEST_UTF8(YDS_PARSE_OK, "\"\xC2\xA2\xE2\x82\xAC\xF0\x9D\x84\x9E\xED\x9F\xBF\xF4\x8F\xBF\xBF\"");
+    TEST_UTF8(YDS_PARSE_OK, "{\"\xE4\xBD\xA0\xE5\xA5\xBD\":[\"\\n\xC3\xA9\"]}");
+    TEST_UTF8(YDS_PARSE_INVALID_UTF8, "\"\x80\"");                  /*单独的后续字节*/
+    TEST_UTF8(YDS_PARSE_INVALID_UTF8, "\"\xC0\xAF\"");              /*过长编码*/
+    TEST_UTF8(YDS_PARSE_INVALID_UTF8, "\"\xE0\x80\xAF\"");
+    TEST_UTF8(YDS_PARSE_INVALID_UTF8, "\"\xED\xA0\x80\"");          /*代理码*/
+    TEST_UTF8(YDS_PARSE_INVALID_UTF8, "\"\xF4\x90\x80\x80\"");      /*超过 U+10FFFF*/
+    TEST_UTF8(YDS_PARSE_INVALID_UTF8, "\"\xE2\x82\"");              /*不完整*/
+    TEST_UTF8(YDS_PARSE_INVALID_UTF8, "\"\xC2\\n\"");
+    TEST_UTF8(YDS_PARSE_INVALID_UTF8, "{\"\xFF\":1}");
+    TEST_UTF8(YDS_PARSE_INVALID_UTF8, "[\"0123456789012345678901234567890123456789\xFE\"]");
+
+    std::string ascii(100, 'a');
+    EXPECT_EQ_TRUE(yds_validate_utf8(ascii.data(), ascii.size()));
+    for (size_t i = 0; i < ascii.size(); ++i) {
+        std::string s = ascii;
+        s[i] = '\x80';
+        EXPECT_EQ_FALSE(yds_validate_utf8(s.data(), s.size()));
+    }
+}
+
+static void test_parse_iterative() {
+    YdsJson json_parse;
+    YdsValue value;
+    EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&value,
+        " [ 1, [ ], { }, [ [ \"x\" ], { \"a\" : [ true, { \"b\" : null } ], \"c\" : \"d\" } ] ] ", YDS_PARSE_ITERATIVE));
+    EXPECT_EQ(YDS_ARRAY, value.get_type());
+    EXPECT_EQ_SIZE(4, value.get_array_size());
+    EXPECT_EQ(1.0, value.get_array_element(0)->get_number());
+    EXPECT_EQ_SIZE(0, value.get_array_element(1)->get_array_size());
+    EXPECT_EQ_SIZE(0, value.get_array_element(2)->get_object_size());
+    YdsValue* a = value.get_array_element(3);
+    EXPECT_EQ_SIZE(2, a->get_array_size());
+    EXPECT_EQ_STRING("x", a->get_array_element(0)->get_array_element(0)->get_string(), 1);
+    YdsValue* o = a->get_array_element(1);
+    EXPECT_EQ_SIZE(2, o->get_object_size());
+    EXPECT_EQ_STRING("a", o->get_object_key(0), o->get_object_key_len(0));
+    EXPECT_EQ(YDS_TRUE, o->get_object_value(0)->get_array_element(0)->get_type());
+    EXPECT_EQ(YDS_NULL, o->get_object_value(0)->get_array_element(1)->get_object_value(0)->get_type());
+    EXPECT_EQ_STRING("c", o->get_object_key(1), o->get_object_key_len(1));
+    EXPECT_EQ_STRING("d", o->get_object_value(1)->get_string(), 1);
+
+    EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&value, "\"abc\"", YDS_PARSE_ITERATIVE));
+    EXPECT_EQ_STRING("abc", value.get_string(), value.get_string_len());
+}
+
+static void test_parse_depth() {
+    YdsJson json_parse;
+    YdsValue value;
+    json_parse.set_max_depth(3);
+    EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&value, "[[1]]"));
+    EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&value, "[[1]]", YDS_PARSE_ITERATIVE));
+    EXPECT_EQ(YDS_PARSE_DEPTH_EXCEEDED, json_parse.parse(&value, "[[[1]]]"));
+    EXPECT_EQ(YDS_NULL, value.get_type());
+    EXPECT_EQ(YDS_PARSE_DEPTH_EXCEEDED, json_parse.parse(&value, "[[[1]]]", YDS_PARSE_ITERATIVE));
+    EXPECT_EQ(YDS_NULL, value.get_type());
+    EXPECT_EQ(YDS_PARSE_DEPTH_EXCEEDED, json_parse.parse(&value, "{\"a\":{\"b\":[1]}}"));
+    EXPECT_EQ(YDS_PARSE_DEPTH_EXCEEDED, json_parse.parse(&value, "{\"a\":{\"b\":[1]}}", YDS_PARSE_ITERATIVE));
+
+    /*非递归模式下深度只受内存限制*/
+    const size_t n = 100000;
+    std::string deep = std::string(n, '[') + std::string(n, ']');
+    json_parse.set_max_depth(n);
+    EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&value, deep.c_str(), YDS_PARSE_ITERATIVE));
+    EXPECT_EQ(YDS_ARRAY, value.get_type());
+    json_parse.set_max_depth(YDS_PARSE_MAX_DEPTH);
+    EXPECT_EQ(YDS_PARSE_DEPTH_EXCEEDED, json_parse.parse(&value, deep.c_str()));
+    EXPECT_EQ(YDS_PARSE_DEPTH_EXCEEDED, json_parse.parse(&value, deep.c_str(), YDS_PARSE_ITERATIVE));
+}
+
+/*把 json 每 chunk 字节喂给 YdsAsyncParser 一次, 每次调用只允许处理 budget 字节*/
+static int parse_async(YdsValue* value, const char* json, size_t chunk, size_t budget = 1, YdsErrorInfo* error = nullptr) {
+    YdsAsyncParser parser(value, 0, budget);
+    size_t len = strlen(json);
+    yds_async_status st = YDS_ASYNC_WANT_READ;
+    for (size_t i = 0; i < len && st == YDS_ASYNC_WANT_READ; i += chunk) {
+        st = parser.feed(json + i, len - i < chunk ? len - i : chunk);
+        while (st == YDS_ASYNC_YIELD)
+            st = parser.resume();
+    }
+    if (st == YDS_ASYNC_WANT_READ)
+        st = parser.finish();
+    while (st == YDS_ASYNC_YIELD)
+        st = parser.resume();
+    if (error)
+        *error = parser.get_error();
+    return st == YDS_ASYNC_DONE ? YDS_PARSE_OK : parser.get_error().code;
+}
+
+#define TEST_ERROR_INFO(error, json, expect_offset, expect_path) \
+    do { \
+        for (unsigned flags : { 0u, (unsigned)YDS_PARSE_ITERATIVE, (unsigned)YDS_PARSE_IN_PLACE, (unsigned)YDS_PARSE_PACK_NUMBERS }) { \
+            YdsJson json_parse; \
+            YdsValue value; \
+            EXPECT_EQ(error, json_parse.parse(&value, json, flags)); \
+            EXPECT_EQ(error, json_parse.get_error().code); \
+            EXPECT_EQ_SIZE(expect_offset, json_parse.get_error().offset); \
+            EXPECT_EQ_TRUE(json_parse.get_error().path == expect_path); \
+        } \
+        YdsValue async_value; \
+        YdsErrorInfo async_error; \
+        EXPECT_EQ(error, parse_async(&async_value, json, 1, 1, &async_error)); \
+        EXPECT_EQ_SIZE(expect_offset, async_error.offset); \
+        EXPECT_EQ_TRUE(async_error.path == expect_path); \
+    } while (0)
+
+static void test_parse_error_info() {
+    TEST_ERROR_INFO(YDS_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, "[1, 2 3]", 6, "");
+    TEST_ERROR_INFO(YDS_PARSE_MISS_COLON, "{\"a\":{\"b\" 1}}", 10, "/a");
+    TEST_ERROR_INFO(YDS_PARSE_MISS_KEY, "{\"a\":[{}, {1}]}", 11, "/a/1");
+    TEST_ERROR_INFO(YDS_PARSE_INVALID_STRING_ESCAPE, "[\"ab\\x\"]", 4, "/0");
+    TEST_ERROR_INFO(YDS_PARSE_INVALID_UNICODE_SURROGATE, "[[], {\"k\" : [0, \"\\uD800\"]}]", 17, "/1/k/1");
+    TEST_ERROR_INFO(YDS_PARSE_MISS_QUOTATION_MARK, "[\"abc", 5, "/0");
+    TEST_ERROR_INFO(YDS_PARSE_ROOT_NOT_SINGULAR, "[] x", 3, "");
+
+    std::string deep(YDS_PARSE_MAX_DEPTH, '['), deep_path;
+    deep += "[]";
+    for (int i = 0; i < YDS_PARSE_MAX_DEPTH; ++i)
+        deep_path += "/0";
+    TEST_ERROR_INFO(YDS_PARSE_DEPTH_EXCEEDED, deep.c_str(), YDS_PARSE_MAX_DEPTH, deep_path);
+
+    const char* json = "{\n  \"a\" : [1, 2,\n    {\"b~/\" : tru}]\n}";
+    YdsJson json_parse;
+    YdsValue value;
+    EXPECT_EQ(YDS_PARSE_INVALID_VALUE, json_parse.parse(&value, json));
+    const YdsErrorInfo& error = json_parse.get_error();
+    EXPECT_EQ_TRUE(error.path == "/a/2/b~0~1");
+    EXPECT_EQ_SIZE(3, error.line());
+    EXPECT_EQ_SIZE(14, error.column());
+    EXPECT_EQ_TRUE(strcmp("value", error.expected()) == 0);
+
+    EXPECT_EQ(YDS_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, json_parse.parse(&value, "[1\n,2\n,3 4]"));
+    EXPECT_EQ_SIZE(3, json_parse.get_error().line());
+    EXPECT_EQ_SIZE(4, json_parse.get_error().column());
+    EXPECT_EQ_TRUE(strcmp("',' or ']'", json_parse.get_error().expected()) == 0);
+
+    EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&value, "[1]"));
+    EXPECT_EQ(YDS_PARSE_OK, json_parse.get_error().code);
+    EXPECT_EQ_TRUE(json_parse.get_error().path.empty());
+}
+
+static void test_validate() {
+    YdsValidateInfo info;
+    EXPECT_EQ(YDS_PARSE_OK, validate_exact(" { \"a\" : [ 1, 2, { \"b\" : null } ], \"c\" : \"\\u00e9\" } ", &info));
+    EXPECT_EQ_SIZE(4, info.max_depth);
+    EXPECT_EQ_SIZE(7, info.elements);
+
+    EXPECT_EQ(YDS_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, validate_exact("[1, 2 3]", &info));
+    EXPECT_EQ_SIZE(6, info.offset);
+    EXPECT_EQ(YDS_PARSE_ROOT_NOT_SINGULAR, validate_exact("[] x", &info));
+    EXPECT_EQ_SIZE(3, info.offset);
+    EXPECT_EQ(YDS_PARSE_MISS_QUOTATION_MARK, validate_exact("\"abc", &info));
+    EXPECT_EQ_SIZE(4, info.offset);
+    EXPECT_EQ(YDS_PARSE_INVALID_UNICODE_HEX, validate_exact("[\"a\\u00\"]", &info));
+    EXPECT_EQ_SIZE(3, info.offset);
+    EXPECT_EQ(YDS_PARSE_INVALID_VALUE, validate_exact("tru"));
+    EXPECT_EQ(YDS_PARSE_INVALID_VALUE, validate_exact("1."));
+    EXPECT_EQ(YDS_PARSE_INVALID_VALUE, validate_exact("-"));
+
+    /*只看前 len 个字节*/
+    YdsJson json_parse;
+    EXPECT_EQ(YDS_PARSE_OK, json_parse.validate("[1]xyz", 3));
+    EXPECT_EQ(YDS_PARSE_ROOT_NOT_SINGULAR, json_parse.validate("[1]\0", 4));
+    EXPECT_EQ(YDS_PARSE_OK, json_parse.validate("\"\xC3\xA9\"", 4, nullptr, YDS_PARSE_VALIDATE_UTF8));
+    EXPECT_EQ(YDS_PARSE_INVALID_UTF8, json_parse.validate("\"\xC3\"", 3, nullptr, YDS_PARSE_VALIDATE_UTF8));
+
+    /*只在量级接近 DBL_MAX 时才精确判断溢出*/
+    EXPECT_EQ(YDS_PARSE_OK, validate_exact("1.7976931348623157e308"));
+    EXPECT_EQ(YDS_PARSE_OK, validate_exact("-0.00017976931348623157e312"));
+    EXPECT_EQ(YDS_PARSE_OK, validate_exact("1e-400"));
+    EXPECT_EQ(YDS_PARSE_OK, validate_exact("0.000e999999999999"));
+    EXPECT_EQ(YDS_PARSE_NUMBER_TOO_BIG, validate_exact("1.8e308"));
+    EXPECT_EQ(YDS_PARSE_NUMBER_TOO_BIG, validate_exact("-1e309"));
+    EXPECT_EQ(YDS_PARSE_NUMBER_TOO_BIG, validate_exact("1e99999999999999999999"));
+    EXPECT_EQ(YDS_PARSE_NUMBER_TOO_BIG, validate_exact(("1" + std::string(400, '0')).c_str()));
+
+    std::string deep(YDS_PARSE_MAX_DEPTH + 1, '[');
+    deep += std::string(YDS_PARSE_MAX_DEPTH + 1, ']');
+    EXPECT_EQ(YDS_PARSE_DEPTH_EXCEEDED, validate_exact(deep.c_str()));
+}
+
+#ifdef YDS_ENABLE_STATS
+static void test_parse_stats() {
+    YdsJson json_parse;
+    YdsValue value;
+    EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&value, "[ \"a\\nb\", \"c\", [ [ 1 ] ], { \"k\" : 2 } ]"));
+    const YdsStats& stats = json_parse.get_stats();
+    EXPECT_EQ_SIZE(4, stats.max_depth);
+    EXPECT_EQ_SIZE(1, stats.escaped_strings);
+    /*3 个数组各一个临时节点和一块元素, 对象一块成员和一个键; 短字符串不申请内存*/
+    EXPECT_EQ_SIZE(8, stats.alloc_count);
+    EXPECT_EQ_SIZE(3 * sizeof(YdsValue) + (4 + 1 + 1) * sizeof(YdsValue) + sizeof(YdsMember) + sizeof(YdsKeyHeader) + 2,
+                   stats.alloc_bytes);
+    EXPECT_EQ_SIZE(0, stats.stack_realloc_count);
+    EXPECT_EQ_TRUE(stats.type_ns[YDS_ARRAY] > 0);
+    EXPECT_EQ_TRUE(stats.type_ns[YDS_OBJECT] > 0);
 
+    /*每次 parse 重新统计*/
+    EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&value, "1"));
+    EXPECT_EQ_SIZE(1, json_parse.get_stats().max_depth);
+    EXPECT_EQ_SIZE(0, json_parse.get_stats().alloc_count);
+    EXPECT_EQ_SIZE(0, json_parse.get_stats().alloc_bytes);
+    EXPECT_EQ_SIZE(0, json_parse.get_stats().escaped_strings);
+    EXPECT_EQ_TRUE(json_parse.get_stats().type_ns[YDS_ARRAY] == 0);
+
+    /*长字符串和键各申请一次*/
+    EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&value, "{\"a long key name!\":\"a long string value\"}"));
+    EXPECT_EQ_SIZE(2, json_parse.get_stats().max_depth);
+    EXPECT_EQ_SIZE(0, json_parse.get_stats().escaped_strings);
+    EXPECT_EQ_SIZE(3, json_parse.get_stats().alloc_count);
+    EXPECT_EQ_SIZE(sizeof(YdsMember) + sizeof(YdsKeyHeader) + 17 + 20, json_parse.get_stats().alloc_bytes);
+    EXPECT_EQ_TRUE(json_parse.get_stats().type_ns[YDS_ARRAY] == 0);
 }
+#endif
 
 #define TEST_ERROR(error, json) \
     do { \
@@ -207,6 +473,8 @@ static void test_parse_root_not_singular() {
     TEST_ERROR(YDS_PARSE_ROOT_NOT_SINGULAR, "0123");
     TEST_ERROR(YDS_PARSE_ROOT_NOT_SINGULAR, "0x0");
     TEST_ERROR(YDS_PARSE_ROOT_NOT_SINGULAR, "0x123");
+    TEST_ERROR(YDS_PARSE_ROOT_NOT_SINGULAR, "01e309");
+    TEST_ERROR(YDS_PARSE_ROOT_NOT_SINGULAR, "-0x1p9999");
 }
 
 static void test_parse_number_too_big() {
@@ -263,6 +531,61 @@ static void test_parse_miss_comma_or_square_bracket() {
     TEST_ERROR(YDS_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, "[[]");
 }
 
+static void test_parse_miss_comma_or_curly_bracket() {
+    TEST_ERROR(YDS_PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"a\":1");
+    TEST_ERROR(YDS_PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"a\":1]");
+    TEST_ERROR(YDS_PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"a\":1 \"b\"");
+    TEST_ERROR(YDS_PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"a\":{}");
+    TEST_ERROR(YDS_PARSE_MISS_COMMA_OR_CURLY_BRACKET, "[{\"a\":[1,2]]");
+}
+
+/*其它解析方式对同样的错误输入给出同样的错误码, 并把 value 置为 null*/
+static void test_parse_error_modes() {
+    static const struct { int error; const char* json; } cases[] = {
+        { YDS_PARSE_EXPECT_VALUE, " " },
+        { YDS_PARSE_INVALID_VALUE, "nul" },
+        { YDS_PARSE_INVALID_VALUE, "1." },
+        { YDS_PARSE_INVALID_VALUE, "[1,]" },
+        { YDS_PARSE_INVALID_VALUE, "[\"a\", nul]" },
+        { YDS_PARSE_ROOT_NOT_SINGULAR, "null x" },
+        { YDS_PARSE_ROOT_NOT_SINGULAR, "0123" },
+        { YDS_PARSE_NUMBER_TOO_BIG, "-1E309" },
+        { YDS_PARSE_NUMBER_TOO_BIG, "[1,1E309]" },
+        { YDS_PARSE_MISS_QUOTATION_MARK, "\"abc" },
+        { YDS_PARSE_INVALID_STRING_ESCAPE, "\"\\x12\"" },
+        { YDS_PARSE_INVALID_STRING_CHAR, "\"\x01\"" },
+        { YDS_PARSE_INVALID_UNICODE_HEX, "\"\\u00G0\"" },
+        { YDS_PARSE_INVALID_UNICODE_SURROGATE, "\"\\uD800\\uE000\"" },
+        { YDS_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, "[1 2" },
+        { YDS_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, "[[]" },
+        { YDS_PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"a\":1 \"b\"" },
+        { YDS_PARSE_MISS_COMMA_OR_CURLY_BRACKET, "[{\"a\":[1,2]]" },
+    };
+    for (auto& c : cases) {
+        for (unsigned flags : { (unsigned)YDS_PARSE_ITERATIVE, (unsigned)YDS_PARSE_IN_PLACE,
+                                (unsigned)(YDS_PARSE_PACK_NUMBERS | YDS_PARSE_IN_PLACE) }) {
+            YdsJson json_parse;
+            YdsValue value;
+            value.set_boolean(false);
+            EXPECT_EQ(c.error, json_parse.parse(&value, c.json, flags));
+            EXPECT_EQ(YDS_NULL, value.get_type());
+        }
+        YdsValue value;
+        value.set_boolean(false);
+        EXPECT_EQ(c.error, parse_async(&value, c.json, 1));
+        EXPECT_EQ(YDS_NULL, value.get_type());
+        EXPECT_EQ(c.error, validate_exact(c.json));
+    }
+
+    /*validate 接受的数字和 parse 一致*/
+    static const char* numbers[] = {
+        "0", "-0", "-0.0", "1.5", "-1E-10", "1.234E+10", "1e-10000",
+        "4.9406564584124654e-324", "2.2250738585072009e-308", "-1.7976931348623157e+308"
+    };
+    for (const char* n : numbers)
+        EXPECT_EQ(YDS_PARSE_OK, validate_exact(n));
+}
+
 static void test_parse() {
     test_parse_null();
     test_parse_true();
@@ -270,6 +593,7 @@ static void test_parse() {
     test_parse_number();
     test_parse_string();
     test_parse_array();
+    test_parse_object();
 
     test_parse_EXPECT_value();
     test_parse_invalid_value();
@@ -281,6 +605,16 @@ static void test_parse() {
     test_parse_invalid_unicode_hex();
     test_parse_invalid_unicode_surrogate();
     test_parse_miss_comma_or_square_bracket();
+    test_parse_miss_comma_or_curly_bracket();
+    test_parse_utf8();
+    test_parse_iterative();
+    test_parse_depth();
+    test_parse_error_info();
+    test_validate();
+    test_parse_error_modes();
+#ifdef YDS_ENABLE_STATS
+    test_parse_stats();
+#endif
 }
 
 static void test_access_null() {
@@ -314,6 +648,1075 @@ static void test_access_string() {
     EXPECT_EQ_STRING("Hello", value.get_string(), value.get_string_len());
 }
 
+static size_t alloc_live = 0;
+static void* counting_malloc(void*, size_t size) { alloc_live += size; return malloc(size); }
+static void* counting_realloc(void*, void* ptr, size_t old_size, size_t new_size) {
+    alloc_live += new_size - old_size;
+    return realloc(ptr, new_size);
+}
+static void counting_free(void*, void* ptr, size_t size) { alloc_live -= size; free(ptr); }
+
+static void test_short_string() {
+    static const YdsAllocator counting = { counting_malloc, counting_realloc, counting_free, nullptr };
+    YdsAllocatorScope scope(&counting);
+    EXPECT_EQ_SIZE(16, sizeof(YdsValue));
+    {
+        YdsValue value;
+        const char* s = "0123456789abcdef";
+        for (size_t len = 0; len <= 16; ++len) {
+            value.set_string(s, len);
+            EXPECT_EQ_SIZE(len, value.get_string_len());
+            EXPECT_EQ_TRUE(memcmp(s, value.get_string(), len) == 0);
+            EXPECT_EQ_TRUE(value.get_string()[len] == '\0');
+            EXPECT_EQ_SIZE((len <= YDS_SHORT_STRING_MAX ? 0 : len + 1), alloc_live);
+        }
+        value.set_string("a\0b", 3);
+        EXPECT_EQ_STRING("a\0b", value.get_string(), value.get_string_len());
+        value.set_number(1.5);
+        EXPECT_EQ(1.5, value.get_number());
+
+        /*节点按位移动后短字符串跟着移动*/
+        YdsJson json_parse;
+        YdsValue a, b;
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&a, "[\"x\",\"0123456789abcd\",\"0123456789abcde\",{\"k\":\"\\u00E9\"}]"));
+        EXPECT_EQ_STRING("x", a.get_array_element(0)->get_string(), a.get_array_element(0)->get_string_len());
+        EXPECT_EQ_STRING("0123456789abcd", a.get_array_element(1)->get_string(), a.get_array_element(1)->get_string_len());
+        EXPECT_EQ_STRING("0123456789abcde", a.get_array_element(2)->get_string(), a.get_array_element(2)->get_string_len());
+        EXPECT_EQ_STRING("\xC3\xA9", a.get_array_element(3)->get_object_value(0)->get_string(), a.get_array_element(3)->get_object_value(0)->get_string_len());
+        a.clone(&b);
+        EXPECT_EQ_TRUE(a.equals(b));
+        EXPECT_EQ_TRUE(a.hash() == b.hash());
+        a.destroy();
+        EXPECT_EQ_STRING("x", b.get_array_element(0)->get_string(), b.get_array_element(0)->get_string_len());
+        EXPECT_EQ_STRING("0123456789abcde", b.get_array_element(2)->get_string(), b.get_array_element(2)->get_string_len());
+    }
+    EXPECT_EQ_SIZE(0, alloc_live);
+}
+
+static void test_allocator() {
+    static const YdsAllocator counting = { counting_malloc, counting_realloc, counting_free, nullptr };
+    const char* json = "{ \"a\" : [ 1, \"two\", { \"three\" : [ ] } ], \"bb\" : \"ccc\" }";
+    {
+        YdsAllocatorScope scope(&counting);
+        YdsJson json_parse;
+        YdsValue value;
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&value, json));
+        EXPECT_EQ_TRUE(alloc_live > 0);
+        value.destroy();
+    }
+    EXPECT_EQ_SIZE(0, alloc_live);
+    EXPECT_EQ_TRUE(yds_get_allocator() == &yds_default_allocator);
+
+    YdsPoolAllocator pool;
+    {
+        YdsAllocatorScope scope(pool.allocator());
+        YdsJson json_parse;
+        YdsValue value;
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&value, json));
+        EXPECT_EQ_SIZE(2, value.get_object_size());
+        EXPECT_EQ_STRING("ccc", value.get_object_value(1)->get_string(), value.get_object_value(1)->get_string_len());
+        YdsValue* a = value.get_object_value(0);
+        EXPECT_EQ_STRING("two", a->get_array_element(1)->get_string(), a->get_array_element(1)->get_string_len());
+        EXPECT_EQ(YDS_ARRAY, a->get_array_element(2)->get_object_value(0)->get_type());
+    }
+
+    /*节点记下申请它的分配器, 在作用域外或其它线程销毁也走原来的分配器*/
+    {
+        YdsValue value, other;
+        {
+            YdsAllocatorScope scope(&counting);
+            YdsJson json_parse;
+            EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&value, json));
+            EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&other, "[\"a string longer than short\", {\"k\":[1]}]"));
+        }
+        EXPECT_EQ_TRUE(alloc_live > 0);
+        value.get_object_value(1)->set_string("replaced, also long", 19);
+        value.destroy();
+        std::thread([&] { other.destroy(); }).join();
+        EXPECT_EQ_SIZE(0, alloc_live);
+
+        {
+            YdsAllocatorScope scope(pool.allocator());
+            YdsJson json_parse;
+            EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&value, json));
+        }
+        /*树的一部分换成默认分配器申请的内存, 各自释放*/
+        value.get_object_value(0)->get_array_element(1)->set_string("allocated by default", 20);
+    }
+    EXPECT_EQ_SIZE(0, alloc_live);
+
+    void* p = pool.allocate(20);
+    void* q = pool.reallocate(p, 20, 30);
+    EXPECT_EQ_TRUE(p == q);
+    void* r = pool.reallocate(q, 30, 2000);
+    EXPECT_EQ_TRUE(r != q);
+    pool.deallocate(r, 2000);
+    EXPECT_EQ_TRUE(pool.allocate(32) == q);
+}
+
+static void test_intern_keys() {
+    static const YdsAllocator counting = { counting_malloc, counting_realloc, counting_free, nullptr };
+    std::string json = "[";
+    for (int i = 0; i < 100; ++i)
+        json += std::string(i ? "," : "") + "{ \"id\" : 1, \"name\" : \"x\", \"tags\" : { \"id\" : 2 } }";
+    json += "]";
+
+    size_t plain = 0, interned = 0;
+    for (unsigned flags : { 0u, (unsigned)YDS_PARSE_INTERN_KEYS, (unsigned)(YDS_PARSE_INTERN_KEYS | YDS_PARSE_ITERATIVE) }) {
+        YdsAllocatorScope scope(&counting);
+        YdsJson json_parse;
+        YdsValue value;
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&value, json.c_str(), flags));
+        EXPECT_EQ_SIZE(100, value.get_array_size());
+        YdsValue* first = value.get_array_element(0);
+        YdsValue* last = value.get_array_element(99);
+        EXPECT_EQ_STRING("name", last->get_object_key(1), last->get_object_key_len(1));
+        bool shared = first->get_object_key(0) == last->get_object_key(0) &&
+                      first->get_object_key(0) == last->get_object_value(2)->get_object_key(0);
+        EXPECT_EQ_TRUE((flags != 0) == shared);
+
+        /*按指针和按内容都能找到*/
+        EXPECT_EQ_SIZE(2, last->find_object_index(first->get_object_key(2), 4));
+        EXPECT_EQ_SIZE(1, last->find_object_index("name", 4));
+        EXPECT_EQ_SIZE(YDS_KEY_NOT_EXIST, last->find_object_index("nam", 3));
+
+        /*解析结束时驻留表已放开自己的引用, 键随文档一起释放*/
+        size_t live = alloc_live;
+        value.destroy();
+        if (flags) interned = live - alloc_live;
+        else plain = live - alloc_live;
+    }
+    EXPECT_EQ_SIZE(0, alloc_live);
+    EXPECT_EQ_TRUE(interned < plain);
+
+    YdsJson json_parse;
+    YdsValue value;
+    EXPECT_EQ(YDS_PARSE_MISS_COLON,
+              json_parse.parse(&value, "[{\"a\":1},{\"a\":2, \"b\" 3}]", YDS_PARSE_INTERN_KEYS | YDS_PARSE_ITERATIVE));
+    EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&value, "{\"a\":{\"a\":{}}}", YDS_PARSE_INTERN_KEYS));
+    EXPECT_EQ_TRUE(value.get_object_key(0) == value.get_object_value(0)->get_object_key(0));
+}
+
+static void test_stack_buffer() {
+    static const YdsAllocator counting = { counting_malloc, counting_realloc, counting_free, nullptr };
+    YdsAllocatorScope scope(&counting);
+    {
+        /*小文档只用内置缓冲区*/
+        YdsJson json_parse;
+        YdsValue value;
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&value, "\"abc\\u20AC\""));
+        EXPECT_EQ_STRING("abc\xE2\x82\xAC", value.get_string(), value.get_string_len());
+        /*短字符串存放在节点内*/
+        EXPECT_EQ_SIZE(0, alloc_live);
+    }
+    EXPECT_EQ_SIZE(0, alloc_live);
+
+    std::string big(1000, 'x');
+    std::string json = "[\"" + big + "\", \"" + big + "\\n\"]";
+    {
+        /*调用者提供的缓冲区放不下时自动转到堆上*/
+        char buf[16];
+        YdsJson json_parse;
+        YdsValue value;
+        json_parse.set_stack_buffer(buf, sizeof(buf));
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&value, json.c_str()));
+        EXPECT_EQ_SIZE(2, value.get_array_size());
+        EXPECT_EQ_SIZE(1000, value.get_array_element(0)->get_string_len());
+        EXPECT_EQ_SIZE(1001, value.get_array_element(1)->get_string_len());
+        EXPECT_EQ_TRUE(memcmp(big.data(), value.get_array_element(1)->get_string(), 1000) == 0);
+        EXPECT_EQ('\n', value.get_array_element(1)->get_string()[1000]);
+    }
+    EXPECT_EQ_SIZE(0, alloc_live);
+    {
+        YdsJson json_parse;
+        YdsValue value;
+        json_parse.reserve_stack(json.size());
+        size_t reserved = alloc_live;
+        EXPECT_EQ_TRUE(reserved > json.size());
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&value, json.c_str()));
+        value.destroy();
+        EXPECT_EQ_SIZE(reserved, alloc_live);
+    }
+    EXPECT_EQ_SIZE(0, alloc_live);
+}
+
+struct BindInner {
+    int id;
+    bool ok;
+};
+YDS_BIND(BindInner, YDS_FIELD(BindInner, id), YDS_FIELD(BindInner, ok));
+
+struct BindOuter {
+    double x;
+    std::string name;
+    std::vector<int> ids;
+    std::vector<BindInner> items;
+    BindInner inner;
+};
+YDS_BIND(BindOuter, YDS_FIELD(BindOuter, x), YDS_FIELD(BindOuter, name), YDS_FIELD(BindOuter, ids),
+         YDS_FIELD(BindOuter, items), YDS_FIELD(BindOuter, inner));
+
+struct BindInts {
+    int8_t i8;
+    unsigned u;
+    int64_t i64;
+    uint64_t u64;
+};
+YDS_BIND(BindInts, YDS_FIELD(BindInts, i8), YDS_FIELD(BindInts, u), YDS_FIELD(BindInts, i64), YDS_FIELD(BindInts, u64));
+
+static void test_bind() {
+    YdsJson json_parse;
+    BindOuter v;
+    v.x = 0;
+    v.inner.id = 7;
+    v.inner.ok = false;
+    const char* json = "{ \"name\" : \"a\\nb\", \"skip\" : { \"k\" : [1, \"}\", null] }, \"x\" : -1.5,"
+                       " \"ids\" : [1, 2, 3], \"items\" : [ { \"id\" : 1, \"ok\" : true }, { } ],"
+                       " \"inner\" : { \"id\" : null, \"ok\" : true } }";
+    EXPECT_EQ(YDS_PARSE_OK, json_parse.parse_into(&v, json));
+    EXPECT_EQ(-1.5, v.x);
+    EXPECT_EQ_STRING("a\nb", v.name.data(), v.name.size());
+    EXPECT_EQ_SIZE(3, v.ids.size());
+    EXPECT_EQ(3, v.ids[2]);
+    EXPECT_EQ_SIZE(2, v.items.size());
+    EXPECT_EQ(1, v.items[0].id);
+    EXPECT_EQ_TRUE(v.items[0].ok);
+    /*null 保持原值*/
+    EXPECT_EQ(7, v.inner.id);
+    EXPECT_EQ_TRUE(v.inner.ok);
+
+    std::string str;
+    yds_stringify(v.inner, str);
+    EXPECT_EQ_STRING("{\"id\":7,\"ok\":true}", str.data(), str.size());
+
+    str.clear();
+    v.items.resize(1);
+    yds_stringify(v, str);
+    BindOuter w;
+    EXPECT_EQ(YDS_PARSE_OK, json_parse.parse_into(&w, str.c_str()));
+    EXPECT_EQ(v.x, w.x);
+    EXPECT_EQ_TRUE(v.name == w.name);
+    EXPECT_EQ_TRUE(v.ids == w.ids);
+    EXPECT_EQ_SIZE(1, w.items.size());
+    EXPECT_EQ(7, w.inner.id);
+
+    /*NaN/Inf 不能写成 json*/
+    str.clear();
+    v.x = HUGE_VAL;
+    bool ok = yds_stringify(v, str);
+    EXPECT_EQ_FALSE(ok);
+    v.x = NAN;
+    ok = yds_stringify(v, str);
+    EXPECT_EQ_FALSE(ok);
+
+    EXPECT_EQ(YDS_PARSE_TYPE_MISMATCH, json_parse.parse_into(&w, "{\"x\":\"1\"}"));
+    EXPECT_EQ(YDS_PARSE_TYPE_MISMATCH, json_parse.parse_into(&w, "{\"ids\":[true]}"));
+    EXPECT_EQ(YDS_PARSE_TYPE_MISMATCH, json_parse.parse_into(&w, "[]"));
+    EXPECT_EQ(YDS_PARSE_MISS_COLON, json_parse.parse_into(&w, "{\"x\" 1}"));
+    EXPECT_EQ(YDS_PARSE_MISS_COMMA_OR_CURLY_BRACKET, json_parse.parse_into(&w, "{\"x\":1 \"y\":2}"));
+    EXPECT_EQ(YDS_PARSE_ROOT_NOT_SINGULAR, json_parse.parse_into(&w, "{} x"));
+    EXPECT_EQ(YDS_PARSE_INVALID_VALUE, json_parse.parse_into(&w, "{\"skip\":[nul]}"));
+
+    /*整数字段: 不经过 double, 不接受小数和超出范围的值*/
+    BindInts n;
+    EXPECT_EQ(YDS_PARSE_OK, json_parse.parse_into(&n, "{\"i8\":-128,\"u\":-0,\"i64\":-9223372036854775808,\"u64\":18446744073709551615}"));
+    EXPECT_EQ(-128, n.i8);
+    EXPECT_EQ_TRUE(n.u == 0 && n.i64 == INT64_MIN && n.u64 == UINT64_MAX);
+    EXPECT_EQ(YDS_PARSE_OK, json_parse.parse_into(&n, "{\"i64\":9007199254740993}"));
+    EXPECT_EQ_TRUE(n.i64 == 9007199254740993LL);
+    EXPECT_EQ(YDS_PARSE_NUMBER_TOO_BIG, json_parse.parse_into(&n, "{\"i8\":128}"));
+    EXPECT_EQ(YDS_PARSE_NUMBER_TOO_BIG, json_parse.parse_into(&n, "{\"u\":-1}"));
+    EXPECT_EQ(YDS_PARSE_NUMBER_TOO_BIG, json_parse.parse_into(&n, "{\"u\":4294967296}"));
+    EXPECT_EQ(YDS_PARSE_NUMBER_TOO_BIG, json_parse.parse_into(&n, "{\"u64\":18446744073709551616}"));
+    EXPECT_EQ(YDS_PARSE_TYPE_MISMATCH, json_parse.parse_into(&n, "{\"i64\":1e300}"));
+    EXPECT_EQ(YDS_PARSE_TYPE_MISMATCH, json_parse.parse_into(&n, "{\"u\":1.5}"));
+    EXPECT_EQ(YDS_PARSE_MISS_COMMA_OR_CURLY_BRACKET, json_parse.parse_into(&n, "{\"u\":01}"));
+
+    /*整数写出后能原样读回*/
+    static const int64_t i64s[] = { INT64_MIN, INT64_MAX, 9007199254740993LL, -9007199254740993LL };
+    for (int64_t i : i64s) {
+        BindInts m = { -7, 42, i, UINT64_MAX }, r = { 0, 0, 0, 0 };
+        str.clear();
+        EXPECT_EQ_TRUE(yds_stringify(m, str));
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.parse_into(&r, str.c_str()));
+        EXPECT_EQ_TRUE(r.i8 == m.i8 && r.u == m.u && r.i64 == m.i64 && r.u64 == m.u64);
+    }
+    str.clear();
+    BindInts m = { INT8_MIN, UINT32_MAX, 9007199254740993LL, UINT64_MAX };
+    yds_stringify(m, str);
+    EXPECT_EQ_TRUE(str == "{\"i8\":-128,\"u\":4294967295,\"i64\":9007199254740993,\"u64\":18446744073709551615}");
+}
+
+static void test_clone_equals_hash() {
+    static const YdsAllocator counting = { counting_malloc, counting_realloc, counting_free, nullptr };
+    YdsAllocatorScope scope(&counting);
+    {
+        YdsJson json_parse;
+        YdsValue a, b, c;
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&a, "{ \"n\" : 0, \"s\" : \"abc\", \"a\" : [ 1, [ ], { } , \"x\" ], \"o\" : { \"t\" : true } }"));
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&b, "{ \"o\" : { \"t\" : true }, \"a\" : [ 1, [ ], { }, \"x\" ], \"s\" : \"abc\", \"n\" : -0 }"));
+        EXPECT_EQ_TRUE(a.equals(b));
+        EXPECT_EQ_TRUE(b.equals(a));
+        EXPECT_EQ_TRUE(a.hash() == b.hash());
+
+        size_t live = alloc_live;
+        a.clone(&c);
+        size_t cloned = alloc_live - live;
+        EXPECT_EQ_TRUE(c.equals(a));
+        EXPECT_EQ_TRUE(c.hash() == a.hash());
+        /*键和字符串都各自独立*/
+        EXPECT_EQ_TRUE(c.get_object_key(1) != a.get_object_key(1));
+        EXPECT_EQ_TRUE(c.get_object_value(1)->get_string() != a.get_object_value(1)->get_string());
+        a.destroy();
+        EXPECT_EQ_STRING("abc", c.get_object_value(1)->get_string(), c.get_object_value(1)->get_string_len());
+        EXPECT_EQ_STRING("s", c.get_object_key(1), c.get_object_key_len(1));
+        /*副本与 a 占用的内存相同*/
+        EXPECT_EQ_TRUE(cloned > 0);
+        EXPECT_EQ_SIZE(live, alloc_live);
+
+        c.get_object_value(2)->get_array_element(3)->set_string("y", 1);
+        EXPECT_EQ_FALSE(c.equals(b));
+        EXPECT_EQ_TRUE(c.hash() != b.hash());
+    }
+    EXPECT_EQ_SIZE(0, alloc_live);
+
+#define TEST_EQUALS(expect, json1, json2) \
+    do { \
+        YdsJson json_parse; \
+        YdsValue v1, v2; \
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&v1, json1)); \
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&v2, json2)); \
+        EXPECT_EQ(expect, (v1.equals(v2))); \
+        EXPECT_EQ(expect, (v1.hash() == v2.hash())); \
+    } while (0)
+
+    TEST_EQUALS(true, "null", "null");
+    TEST_EQUALS(false, "null", "false");
+    TEST_EQUALS(false, "true", "false");
+    TEST_EQUALS(true, "1.5", "15e-1");
+    TEST_EQUALS(false, "1", "2");
+    TEST_EQUALS(true, "\"a\\u0000b\"", "\"a\\u0000b\"");
+    TEST_EQUALS(false, "\"a\\u0000b\"", "\"a\\u0000c\"");
+    TEST_EQUALS(false, "[1,2]", "[2,1]");
+    TEST_EQUALS(false, "[1,2]", "[1,2,3]");
+    TEST_EQUALS(false, "[[]]", "[{}]");
+    TEST_EQUALS(true, "{\"a\":1,\"b\":[2]}", "{\"b\":[2],\"a\":1}");
+    TEST_EQUALS(false, "{\"a\":1,\"b\":2}", "{\"a\":2,\"b\":1}");
+    TEST_EQUALS(false, "{\"a\":1}", "{\"b\":1}");
+    TEST_EQUALS(false, "{\"a\":1}", "{\"a\":1,\"b\":1}");
+    /*重复的键: 成员一一对应*/
+    TEST_EQUALS(false, "{\"a\":1,\"a\":1}", "{\"a\":1,\"b\":2}");
+    TEST_EQUALS(false, "{\"a\":1,\"b\":2}", "{\"a\":1,\"a\":1}");
+    TEST_EQUALS(false, "{\"a\":1,\"a\":1}", "{\"a\":1,\"a\":2}");
+    TEST_EQUALS(true, "{\"a\":1,\"a\":2}", "{\"a\":2,\"a\":1}");
+    {
+        /*超过 64 个成员*/
+        std::string x = "{", y = "{", z = "{";
+        for (int i = 0; i < 100; ++i) {
+            std::string m = (i ? "," : "") + std::string("\"k") + std::to_string(i % 50) + "\":" + std::to_string(i);
+            x += m;
+            z += (i ? "," : "") + std::string("\"k") + std::to_string(i % 50) + "\":" + std::to_string(i % 50);
+        }
+        for (int i = 99; i >= 0; --i)
+            y += (i != 99 ? "," : "") + std::string("\"k") + std::to_string(i % 50) + "\":" + std::to_string(i);
+        x += "}"; y += "}"; z += "}";
+        TEST_EQUALS(true, x.c_str(), y.c_str());
+        TEST_EQUALS(false, x.c_str(), z.c_str());
+    }
+#undef TEST_EQUALS
+}
+
+static void test_parse_in_place() {
+    static const YdsAllocator counting = { counting_malloc, counting_realloc, counting_free, nullptr };
+    YdsAllocatorScope scope(&counting);
+    {
+        YdsJson json_parse;
+        YdsValue a, b;
+        std::string json("{\"e\":[],\"o\":{},\"n\":[");
+        for (int i = 0; i < 100; ++i)
+            json += (i ? "," : "") + std::to_string(i);
+        json += "],\"m\":[{\"k\":\"v\",\"a\":[[1,2,3,4,5],[]]},{\"x\":{\"y\":{\"z\":null}}}]}";
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&a, json.c_str()));
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&b, json.c_str(), YDS_PARSE_IN_PLACE));
+        EXPECT_EQ_TRUE(a.equals(b));
+        EXPECT_EQ_SIZE(100, b.get_object_value(2)->get_array_size());
+        EXPECT_EQ(99.0, b.get_object_value(2)->get_array_element(99)->get_number());
+        EXPECT_EQ_SIZE(0, b.get_object_value(0)->get_array_size());
+        EXPECT_EQ_SIZE(0, b.get_object_value(1)->get_object_size());
+
+        /*子节点不经过解析栈, 内置的小缓冲区就够用*/
+        size_t live = alloc_live;
+        b.destroy();
+        size_t freed = live - alloc_live;
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&b, json.c_str(), YDS_PARSE_IN_PLACE));
+        EXPECT_EQ_SIZE(live, alloc_live);
+        EXPECT_EQ_TRUE(freed > 0);
+#ifdef YDS_ENABLE_STATS
+        EXPECT_EQ_SIZE(0, json_parse.get_stats().stack_realloc_count);
+#endif
+
+        YdsPoolAllocator pool;
+        YdsAllocatorScope pool_scope(pool.allocator());
+        YdsJson pool_parse;
+        YdsValue c;
+        EXPECT_EQ(YDS_PARSE_OK, pool_parse.parse(&c, json.c_str(), YDS_PARSE_IN_PLACE | YDS_PARSE_INTERN_KEYS));
+        EXPECT_EQ_TRUE(c.equals(a));
+        c.destroy();
+    }
+    EXPECT_EQ_SIZE(0, alloc_live);
+}
+
+static void test_parse_packed() {
+    static const YdsAllocator counting = { counting_malloc, counting_realloc, counting_free, nullptr };
+    YdsAllocatorScope scope(&counting);
+    {
+        YdsJson json_parse;
+        YdsValue a, b;
+        const char* json = "{\"p\":[ 1, -2.5 ,3e2,0 ],\"m\":[1,2,\"x\"],\"n\":[[0.5],[],[1,[2]]],\"e\":[]}";
+        for (unsigned flags : { (unsigned)YDS_PARSE_PACK_NUMBERS, (unsigned)(YDS_PARSE_PACK_NUMBERS | YDS_PARSE_IN_PLACE) }) {
+            EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&a, json, flags));
+            EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&b, json));
+            YdsValue* p = a.get_object_value(0);
+            EXPECT_EQ_TRUE(p->is_packed());
+            EXPECT_EQ_SIZE(4, p->get_array_size());
+            const double* d = p->get_packed_numbers();
+            EXPECT_EQ_TRUE(d[0] == 1.0 && d[1] == -2.5 && d[2] == 300.0 && d[3] == 0.0);
+            EXPECT_EQ(-2.5, p->get_array_number(1));
+            /*混合数组退回普通数组, 嵌套的数字数组各自紧凑*/
+            EXPECT_EQ_FALSE(a.get_object_value(1)->is_packed());
+            EXPECT_EQ(2.0, a.get_object_value(1)->get_array_number(1));
+            YdsValue* n = a.get_object_value(2);
+            EXPECT_EQ_FALSE(n->is_packed());
+            EXPECT_EQ_TRUE(n->get_array_element(0)->is_packed());
+            EXPECT_EQ_FALSE(n->get_array_element(1)->is_packed());
+            EXPECT_EQ_FALSE(n->get_array_element(2)->is_packed());
+            EXPECT_EQ_TRUE(n->get_array_element(2)->get_array_element(1)->is_packed());
+            EXPECT_EQ_FALSE(a.get_object_value(3)->is_packed());
+
+            /*与普通数组相等, 哈希相同*/
+            EXPECT_EQ_TRUE(a.equals(b) && b.equals(a));
+            EXPECT_EQ_TRUE(a.hash() == b.hash());
+            YdsValue c;
+            a.clone(&c);
+            EXPECT_EQ_TRUE(c.get_object_value(0)->is_packed());
+            EXPECT_EQ_TRUE(c.equals(a));
+            c.get_object_value(0)->unpack();
+            EXPECT_EQ_FALSE(c.get_object_value(0)->is_packed());
+            EXPECT_EQ(YDS_NUMBER, c.get_object_value(0)->get_array_element(2)->get_type());
+            EXPECT_EQ(300.0, c.get_object_value(0)->get_array_element(2)->get_number());
+            EXPECT_EQ_TRUE(c.equals(a));
+            EXPECT_EQ_TRUE(c.hash() == a.hash());
+        }
+
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&a, "[1,2]", YDS_PARSE_PACK_NUMBERS));
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&b, "[1,\"2\"]"));
+        EXPECT_EQ_FALSE(a.equals(b) || b.equals(a));
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&b, "[1,2,3]"));
+        EXPECT_EQ_FALSE(a.equals(b));
+
+        /*每个数字只占 8 字节*/
+        std::string big("[");
+        for (int i = 0; i < 1000; ++i)
+            big += (i ? "," : "") + std::to_string(i);
+        big += "]";
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&a, big.c_str(), YDS_PARSE_PACK_NUMBERS));
+        a.destroy();
+        b.destroy();
+        size_t live = alloc_live;       /*解析栈已经扩好*/
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&a, big.c_str(), YDS_PARSE_PACK_NUMBERS));
+        EXPECT_EQ_SIZE(1000 * sizeof(double), alloc_live - live);
+        EXPECT_EQ(999.0, a.get_packed_numbers()[999]);
+    }
+    EXPECT_EQ_SIZE(0, alloc_live);
+
+    TEST_ERROR_INFO(YDS_PARSE_NUMBER_TOO_BIG, "[[1, 2, 1e309]]", 8, "/0/2");
+    TEST_ERROR_INFO(YDS_PARSE_INVALID_VALUE, "[1, 2, -]", 7, "/2");
+}
+
+static void test_array_stream() {
+    static const YdsAllocator counting = { counting_malloc, counting_realloc, counting_free, nullptr };
+    YdsAllocatorScope scope(&counting);
+    {
+        YdsJson json_parse;
+        YdsValue v;
+        const char* json = " [ {\"id\":0,\"tags\":[]}, {\"id\":1,\"tags\":[\"a\"]} , {\"id\":2,\"tags\":[\"b\",\"c\"]} ] ";
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.begin_array(json, "", YDS_PARSE_INTERN_KEYS));
+        size_t n = 0;
+        const char* id_key = nullptr;
+        while (json_parse.next_element(&v)) {
+            EXPECT_EQ(YDS_OBJECT, v.get_type());
+            EXPECT_EQ(n, v.get_object_value(0)->get_number());
+            EXPECT_EQ_SIZE(n, v.get_object_value(1)->get_array_size());
+            /*驻留表在整次遍历中共享*/
+            if (!id_key) id_key = v.get_object_key(0);
+            EXPECT_EQ_TRUE(id_key == v.get_object_key(0));
+            n++;
+            EXPECT_EQ_SIZE(n, json_parse.get_element_index());
+        }
+        EXPECT_EQ_SIZE(3, n);
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.get_error().code);
+        EXPECT_EQ_FALSE(json_parse.next_element(&v));
+        /*上一个元素仍然有效, 驻留表释放后键由元素持有*/
+        EXPECT_EQ_STRING("tags", v.get_object_key(1), v.get_object_key_len(1));
+
+        /*按 JSON Pointer 定位, 键中的 '/' 和 '~' 需要转义*/
+        json = "{\"meta\":{\"n\":[1,2]},\"a/b\":{\"x~\":[0,[],[\"s\",null,3]]}}";
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.begin_array(json, "/a~1b/x~0/2"));
+        EXPECT_EQ_TRUE(json_parse.next_element(&v));
+        EXPECT_EQ_STRING("s", v.get_string(), v.get_string_len());
+        EXPECT_EQ_TRUE(json_parse.next_element(&v));
+        EXPECT_EQ(YDS_NULL, v.get_type());
+        EXPECT_EQ_TRUE(json_parse.next_element(&v));
+        EXPECT_EQ(3.0, v.get_number());
+        EXPECT_EQ_FALSE(json_parse.next_element(&v));
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.get_error().code);
+
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.begin_array(json, "/a~1b/x~0/1"));
+        EXPECT_EQ_FALSE(json_parse.next_element(&v));
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.get_error().code);
+
+        EXPECT_EQ(YDS_PARSE_POINTER_NOT_FOUND, json_parse.begin_array(json, "/meta/m"));
+        EXPECT_EQ(YDS_PARSE_POINTER_NOT_FOUND, json_parse.begin_array(json, "/a~1b/x~0/3"));
+        EXPECT_EQ(YDS_PARSE_POINTER_NOT_FOUND, json_parse.begin_array(json, "/a~1b/x~0/01"));
+        EXPECT_EQ(YDS_PARSE_POINTER_NOT_FOUND, json_parse.begin_array(json, "meta"));
+        EXPECT_EQ(YDS_PARSE_TYPE_MISMATCH, json_parse.begin_array(json, "/meta"));
+        EXPECT_EQ(YDS_PARSE_TYPE_MISMATCH, json_parse.begin_array(json, ""));
+        EXPECT_EQ_FALSE(json_parse.next_element(&v));
+
+        /*元素出错时停止, 已读出的元素不受影响*/
+        json = "{\"r\":[1,{\"k\":tru}]}";
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.begin_array(json, "/r"));
+        EXPECT_EQ_TRUE(json_parse.next_element(&v));
+        EXPECT_EQ_FALSE(json_parse.next_element(&v));
+        EXPECT_EQ(YDS_PARSE_INVALID_VALUE, json_parse.get_error().code);
+        EXPECT_EQ_TRUE(json_parse.get_error().path == "/r/1/k");
+        EXPECT_EQ_SIZE(13, json_parse.get_error().offset);
+
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.begin_array("[1 2]"));
+        EXPECT_EQ_TRUE(json_parse.next_element(&v));
+        EXPECT_EQ_FALSE(json_parse.next_element(&v));
+        EXPECT_EQ(YDS_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, json_parse.get_error().code);
+
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.begin_array("[1] 2"));
+        EXPECT_EQ_TRUE(json_parse.next_element(&v));
+        EXPECT_EQ_FALSE(json_parse.next_element(&v));
+        EXPECT_EQ(YDS_PARSE_ROOT_NOT_SINGULAR, json_parse.get_error().code);
+        EXPECT_EQ(YDS_PARSE_ROOT_NOT_SINGULAR, json_parse.begin_array("[] 2"));
+
+        /*嵌套深度包括定位经过的层数*/
+        json_parse.set_max_depth(3);
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.begin_array("{\"a\":[[]]}", "/a"));
+        EXPECT_EQ_TRUE(json_parse.next_element(&v));
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.begin_array("{\"a\":[[1]]}", "/a"));
+        EXPECT_EQ_FALSE(json_parse.next_element(&v));
+        EXPECT_EQ(YDS_PARSE_DEPTH_EXCEEDED, json_parse.get_error().code);
+
+        /*元素之间复用 value, 峰值只取决于最大的一个元素*/
+        std::string big("[");
+        for (int i = 0; i < 1000; ++i)
+            big += i ? ",[\"abcdefgh\",1,2,3]" : "[\"abcdefgh\",1,2,3]";
+        big += "]";
+        json_parse.set_max_depth(YDS_PARSE_MAX_DEPTH);
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.begin_array(big.c_str()));
+        v.destroy();
+        size_t live = alloc_live, peak = 0;
+        while (json_parse.next_element(&v)) {
+            if (alloc_live - live > peak)
+                peak = alloc_live - live;
+        }
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.get_error().code);
+        EXPECT_EQ_SIZE(1000, json_parse.get_element_index());
+        EXPECT_EQ_TRUE(peak < 256);
+    }
+    EXPECT_EQ_SIZE(0, alloc_live);
+}
+
+static void test_parse_many() {
+    YdsJson json_parse;
+    YdsValue v;
+    size_t offset = 0;
+    const char* json = "{\"a\":1}[1,2]\"x\" 3\ntrue{}  ";
+    json_parse.begin_many(json);
+    EXPECT_EQ_TRUE(json_parse.next_document(&v, &offset));
+    EXPECT_EQ(YDS_OBJECT, v.get_type());
+    EXPECT_EQ_SIZE(0, offset);
+    EXPECT_EQ_TRUE(json_parse.next_document(&v, &offset));
+    EXPECT_EQ_SIZE(2, v.get_array_size());
+    EXPECT_EQ_SIZE(7, offset);
+    EXPECT_EQ_TRUE(json_parse.next_document(&v, &offset));
+    EXPECT_EQ_STRING("x", v.get_string(), v.get_string_len());
+    EXPECT_EQ_SIZE(12, offset);
+    EXPECT_EQ_TRUE(json_parse.next_document(&v, &offset));
+    EXPECT_EQ(3.0, v.get_number());
+    EXPECT_EQ_SIZE(16, offset);
+    EXPECT_EQ_TRUE(json_parse.next_document(&v, &offset));
+    EXPECT_EQ(YDS_TRUE, v.get_type());
+    EXPECT_EQ_TRUE(json_parse.next_document(&v, &offset));
+    EXPECT_EQ_SIZE(0, v.get_object_size());
+    EXPECT_EQ_SIZE(22, offset);
+    EXPECT_EQ_FALSE(json_parse.next_document(&v, &offset));
+    EXPECT_EQ(YDS_PARSE_OK, json_parse.get_error().code);
+    EXPECT_EQ_SIZE(6, json_parse.get_element_index());
+
+    json_parse.begin_many(" \n ");
+    EXPECT_EQ_FALSE(json_parse.next_document(&v));
+    EXPECT_EQ(YDS_PARSE_OK, json_parse.get_error().code);
+
+    /*两个数字之间没有空白时是同一个数字*/
+    json_parse.begin_many("12");
+    EXPECT_EQ_TRUE(json_parse.next_document(&v));
+    EXPECT_EQ(12.0, v.get_number());
+    EXPECT_EQ_FALSE(json_parse.next_document(&v));
+
+    json_parse.begin_many("1 [2, {\"k\":x}]", YDS_PARSE_ITERATIVE);
+    EXPECT_EQ_TRUE(json_parse.next_document(&v));
+    EXPECT_EQ_FALSE(json_parse.next_document(&v));
+    EXPECT_EQ(YDS_PARSE_INVALID_VALUE, json_parse.get_error().code);
+    EXPECT_EQ_SIZE(11, json_parse.get_error().offset);
+    EXPECT_EQ_TRUE(json_parse.get_error().path == "/1/k");
+    EXPECT_EQ_FALSE(json_parse.next_document(&v));
+
+    /*按批解析到区域分配器, 线程的分配器只用于解析栈*/
+    static const YdsAllocator counting = { counting_malloc, counting_realloc, counting_free, nullptr };
+    YdsAllocatorScope scope(&counting);
+    {
+        std::string many;
+        for (int i = 0; i < 1000; ++i)
+            many += "{\"id\":" + std::to_string(i) + ",\"name\":\"a long enough name " + std::to_string(i) + "\",\"v\":[1,2]}\n";
+        YdsJson batch_parse;
+        YdsBatch batch(4096);
+        batch_parse.begin_many(many.c_str(), YDS_PARSE_INTERN_KEYS);
+        size_t total = 0, batches = 0, live = 0, n;
+        while ((n = batch_parse.next_batch(&batch, 64)) > 0) {
+            EXPECT_EQ_SIZE(n, batch.size());
+            for (size_t i = 0; i < n; ++i) {
+                const YdsValue& doc = batch[i];
+                EXPECT_EQ(static_cast<double>(total + i), doc.get_object_value(0)->get_number());
+                EXPECT_EQ_TRUE(many.compare(batch.get_offset(i), 6, "{\"id\":") == 0);
+                /*同一批内的键共享*/
+                EXPECT_EQ_TRUE(doc.get_object_key(1) == batch[0].get_object_key(1));
+            }
+            EXPECT_EQ_TRUE(batch.get_bytes_used() > 0);
+            /*第一批之后只剩解析栈等复用的内存, 文档都在区域里*/
+            if (batches == 0)
+                live = alloc_live;
+            EXPECT_EQ_SIZE(live, alloc_live);
+            total += n;
+            batches++;
+        }
+        EXPECT_EQ(YDS_PARSE_OK, batch_parse.get_error().code);
+        EXPECT_EQ_SIZE(1000, total);
+        EXPECT_EQ_SIZE(16, batches);
+        EXPECT_EQ_SIZE(0, batch.size());
+        EXPECT_EQ_SIZE(live, alloc_live);
+
+        /*批内的文档要保留时拷贝出来*/
+        YdsValue keep;
+        batch_parse.begin_many(many.c_str());
+        EXPECT_EQ_SIZE(8, batch_parse.next_batch(&batch, 8));
+        batch[7].clone(&keep);
+        batch.clear();
+        /*下一批复用区域的内存, 副本不受影响*/
+        EXPECT_EQ_SIZE(8, batch_parse.next_batch(&batch, 8));
+        EXPECT_EQ(7.0, keep.get_object_value(0)->get_number());
+        EXPECT_EQ_STRING("id", keep.get_object_key(0), keep.get_object_key_len(0));
+        EXPECT_EQ_STRING("a long enough name 7", keep.get_object_value(1)->get_string(), keep.get_object_value(1)->get_string_len());
+        EXPECT_EQ_TRUE(keep.get_object_key(1) != batch[0].get_object_key(1));
+        keep.destroy();
+    }
+    EXPECT_EQ_SIZE(0, alloc_live);
+
+    {
+        YdsArenaAllocator arena(256);
+        void* a = arena.allocate(10);
+        void* b = arena.reallocate(a, 10, 100);     /*最近一次的分配原地扩大*/
+        EXPECT_EQ_TRUE(a == b);
+        EXPECT_EQ_SIZE(112, arena.get_used());
+        void* c = arena.allocate(1000);             /*超过块大小单独占一块*/
+        memset(c, 0, 1000);
+        arena.deallocate(c, 1000);
+        EXPECT_EQ_SIZE(112, arena.get_used());
+        arena.reset();
+        EXPECT_EQ_SIZE(0, arena.get_used());
+        EXPECT_EQ_TRUE(arena.allocate(16) == a);    /*reset 后复用第一块*/
+    }
+}
+
+static void test_parse_async() {
+    const char* docs[] = {
+        "null", " true ", "-1.5e3", "\"a\\\"b\\\\\"", "[]", "{}", "[[], {}, [[1]]]",
+        "{\"k\" : [1, \"two\", {\"three\" : 3.0}], \"\\u00e9\":\"\\uD834\\uDD1E\", \"n\": null }",
+        "[\"a string longer than the short string limit\", 12345678901234567890, false]",
+    };
+    for (const char* json : docs) {
+        YdsJson json_parse;
+        YdsValue expect;
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&expect, json));
+        for (size_t chunk : { 1, 2, 3, 7, 64 }) {
+            for (size_t budget : { 1, 5, 1000 }) {
+                YdsValue v;
+                EXPECT_EQ(YDS_PARSE_OK, parse_async(&v, json, chunk, budget));
+                EXPECT_EQ_TRUE(v.equals(expect));
+            }
+        }
+    }
+
+    /*一次给完整个文档, 工作量用完时让出*/
+    std::string big("[");
+    for (int i = 0; i < 10000; ++i)
+        big += std::to_string(i) + (i < 9999 ? "," : "]");
+    {
+        YdsValue v;
+        YdsAsyncParser parser(&v, 0, 1024);
+        size_t yields = 0;
+        yds_async_status st = parser.feed(big.data(), big.size());
+        for (; st == YDS_ASYNC_YIELD; st = parser.resume())
+            yields++;
+        EXPECT_EQ_TRUE(yields >= big.size() / 1024 - 1);
+        EXPECT_EQ(YDS_ASYNC_WANT_READ, st);     /*根值之后可能还有空白*/
+        EXPECT_EQ(YDS_ASYNC_DONE, parser.finish());
+        EXPECT_EQ_SIZE(10000, v.get_array_size());
+        EXPECT_EQ(9999.0, v.get_array_element(9999)->get_number());
+        EXPECT_EQ_SIZE(big.size(), parser.get_offset());
+    }
+
+    /*输入带长度, 根值之后的 '\0' 不是结尾*/
+    for (size_t chunk : { 1, 11 }) {
+        YdsValue v;
+        YdsAsyncParser parser(&v);
+        yds_async_status st = YDS_ASYNC_WANT_READ;
+        for (size_t i = 0; i < 11 && st == YDS_ASYNC_WANT_READ; i += chunk)
+            st = parser.feed("[1]\0garbage" + i, chunk);
+        if (st == YDS_ASYNC_WANT_READ)
+            st = parser.finish();
+        EXPECT_EQ(YDS_ASYNC_ERROR, st);
+        EXPECT_EQ(YDS_PARSE_ROOT_NOT_SINGULAR, parser.get_error().code);
+        EXPECT_EQ_SIZE(3, parser.get_error().offset);
+        EXPECT_EQ(YDS_NULL, v.get_type());
+    }
+
+    /*中途放弃不泄漏*/
+    {
+        static const YdsAllocator counting = { counting_malloc, counting_realloc, counting_free, nullptr };
+        YdsAllocatorScope scope(&counting);
+        {
+            YdsValue v;
+            YdsAsyncParser parser(&v, YDS_PARSE_INTERN_KEYS);
+            const char* part = "{\"a\":[\"a long string value\", {\"b\":[1,";
+            EXPECT_EQ(YDS_ASYNC_WANT_READ, parser.feed(part, strlen(part)));
+        }
+        EXPECT_EQ_SIZE(0, alloc_live);
+    }
+
+    {
+        YdsValue v;
+        YdsAsyncParser parser(&v);
+        parser.set_max_depth(2);
+        EXPECT_EQ(YDS_ASYNC_ERROR, parser.feed("[[[", 3));
+        EXPECT_EQ(YDS_PARSE_DEPTH_EXCEEDED, parser.get_error().code);
+        EXPECT_EQ_SIZE(2, parser.get_error().offset);
+        EXPECT_EQ_SIZE(0, parser.get_error().line());
+    }
+
+    /*非阻塞 fd: 生成端和解析端在同一个线程里交替运行, 经过管道传递一个大于管道容量的文档*/
+    {
+        YdsJson json_parse;
+        YdsValue src;
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&src, big.c_str(), YDS_PARSE_PACK_NUMBERS));
+        int fds[2];
+        EXPECT_EQ(0, pipe(fds));
+        fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+        fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+
+        YdsValue dst;
+        YdsAsyncWriter writer(&src, 4096);
+        YdsAsyncParser parser(&dst, 0, 4096);
+        yds_async_status ws = YDS_ASYNC_YIELD, rs = YDS_ASYNC_WANT_READ;
+        size_t rounds = 0;
+        while (rs != YDS_ASYNC_DONE && rs != YDS_ASYNC_ERROR && rounds++ < 100000) {
+            if (ws != YDS_ASYNC_DONE) {
+                ws = writer.write_fd(fds[1]);
+                if (ws == YDS_ASYNC_DONE)
+                    close(fds[1]);
+            }
+            rs = parser.read_fd(fds[0]);
+        }
+        close(fds[0]);
+        EXPECT_EQ(YDS_ASYNC_DONE, ws);
+        EXPECT_EQ(YDS_ASYNC_DONE, rs);
+        EXPECT_EQ_SIZE(big.size(), writer.get_bytes_written());
+        EXPECT_EQ_TRUE(dst.equals(src));
+    }
+}
+
+#ifdef YDS_WITH_ZLIB
+/*level 为 zlib 的窗口参数, 15 + 16 生成 gzip, 15 生成 zlib 格式*/
+static std::string compress_text(const std::string& text, int bits) {
+    z_stream z;
+    memset(&z, 0, sizeof(z));
+    deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, bits, 8, Z_DEFAULT_STRATEGY);
+    std::string out(deflateBound(&z, text.size()) + 32, '\0');
+    z.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(text.data()));
+    z.avail_in = static_cast<uInt>(text.size());
+    z.next_out = reinterpret_cast<Bytef *>(&out[0]);
+    z.avail_out = static_cast<uInt>(out.size());
+    deflate(&z, Z_FINISH);
+    out.resize(z.total_out);
+    deflateEnd(&z);
+    return out;
+}
+#endif
+
+static void test_parse_source() {
+    std::string text("{\"rows\":[");
+    for (int i = 0; i < 5000; ++i)
+        text += (i ? "," : "") + std::string("{\"id\":") + std::to_string(i) + ",\"name\":\"row " + std::to_string(i) + "\"}";
+    text += "]}";
+    YdsJson json_parse;
+    YdsValue expect;
+    EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&expect, text.c_str()));
+
+    {
+        YdsMemorySource mem(text.data(), text.size());
+        YdsValue v;
+        YdsAsyncParser parser(&v, 0, SIZE_MAX);
+        EXPECT_EQ(YDS_ASYNC_DONE, parser.read_source(&mem, 100));
+        EXPECT_EQ_TRUE(v.equals(expect));
+    }
+
+    /*后台线程读取, 块大小不是记号的整数倍*/
+    {
+        YdsMemorySource mem(text.data(), text.size());
+        YdsThreadSource pipe(&mem, 7, 3);
+        YdsValue v;
+        YdsAsyncParser parser(&v, 0, SIZE_MAX);
+        EXPECT_EQ(YDS_ASYNC_DONE, parser.read_source(&pipe, 5));
+        EXPECT_EQ_TRUE(v.equals(expect));
+        EXPECT_EQ(YDS_SOURCE_OK, pipe.get_error());
+    }
+
+    /*解析出错时提前结束, 后台线程在析构时退出*/
+    {
+        std::string bad = text;
+        size_t at = bad.find(",{", bad.size() / 2) + 1;
+        bad[at] = '?';
+        YdsMemorySource mem(bad.data(), bad.size());
+        YdsThreadSource pipe(&mem, 64, 2);
+        YdsValue v;
+        YdsAsyncParser parser(&v, 0, SIZE_MAX);
+        EXPECT_EQ(YDS_ASYNC_ERROR, parser.read_source(&pipe));
+        EXPECT_EQ(YDS_PARSE_INVALID_VALUE, parser.get_error().code);
+        EXPECT_EQ_SIZE(at, parser.get_error().offset);
+    }
+
+    {
+        int fds[2];
+        EXPECT_EQ(0, pipe(fds));
+        EXPECT_EQ(4, write(fds[1], "[1,2", 4));
+        close(fds[1]);
+        YdsFdSource fd(fds[0]);
+        YdsValue v;
+        YdsAsyncParser parser(&v);
+        EXPECT_EQ(YDS_ASYNC_ERROR, parser.read_source(&fd));
+        EXPECT_EQ(YDS_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, parser.get_error().code);
+        close(fds[0]);
+
+        YdsFdSource closed(fds[0]);
+        char buf[4];
+        EXPECT_EQ_SIZE(0, closed.read(buf, sizeof(buf)));
+        EXPECT_EQ(YDS_SOURCE_IO_ERROR, closed.get_error());
+        EXPECT_EQ(EBADF, closed.get_errno());
+    }
+
+#ifdef YDS_WITH_ZLIB
+    for (int bits : { 15 + 16, 15 }) {
+        std::string packed = compress_text(text, bits);
+        EXPECT_EQ_TRUE(packed.size() < text.size() / 4);
+        for (bool threaded : { false, true }) {
+            YdsMemorySource mem(packed.data(), packed.size());
+            YdsGzipSource gz(&mem, 1000);
+            YdsValue v;
+            YdsAsyncParser parser(&v, 0, SIZE_MAX);
+            if (threaded) {
+                YdsThreadSource pipe(&gz, 4096);
+                EXPECT_EQ(YDS_ASYNC_DONE, parser.read_source(&pipe, 4096));
+            }
+            else
+                EXPECT_EQ(YDS_ASYNC_DONE, parser.read_source(&gz, 4096));
+            EXPECT_EQ_TRUE(v.equals(expect));
+        }
+    }
+
+    /*首尾相接的两个 gzip 成员*/
+    {
+        std::string packed = compress_text("[1, ", 15 + 16) + compress_text("2]", 15 + 16);
+        YdsMemorySource mem(packed.data(), packed.size());
+        YdsGzipSource gz(&mem, 3);
+        YdsValue v;
+        YdsAsyncParser parser(&v);
+        EXPECT_EQ(YDS_ASYNC_DONE, parser.read_source(&gz, 1));
+        EXPECT_EQ_SIZE(2, v.get_array_size());
+    }
+
+    {
+        std::string packed = compress_text(text, 15 + 16);
+        std::string truncated = packed.substr(0, packed.size() / 2);
+        YdsMemorySource mem(truncated.data(), truncated.size());
+        YdsGzipSource gz(&mem);
+        YdsValue v;
+        YdsAsyncParser parser(&v, 0, SIZE_MAX);
+        EXPECT_EQ(YDS_ASYNC_IO_ERROR, parser.read_source(&gz));
+        EXPECT_EQ(YDS_SOURCE_TRUNCATED, gz.get_error());
+        EXPECT_EQ(YDS_NULL, v.get_type());
+
+        /*头部损坏, 解压出任何数据之前就能发现*/
+        packed[3] = static_cast<char>(0xff);
+        YdsMemorySource mem2(packed.data(), packed.size());
+        YdsGzipSource gz2(&mem2);
+        YdsAsyncParser parser2(&v);
+        EXPECT_EQ(YDS_ASYNC_IO_ERROR, parser2.read_source(&gz2));
+        EXPECT_EQ(YDS_SOURCE_CORRUPT, gz2.get_error());
+    }
+#endif
+}
+
+static void test_write_async() {
+    const char* json = "{\"k\":[1,\"two\",{\"three\":3.5}],\"s\":\"a\\\"\\n\",\"e\":[],\"o\":{},\"t\":true,\"f\":false,\"n\":null}";
+    YdsJson json_parse;
+    YdsValue v;
+    EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&v, json));
+    for (size_t budget : { 1, 4, 1000 }) {
+        YdsAsyncWriter writer(&v, budget);
+        std::string out;
+        const char* data;
+        size_t len, chunks = 0;
+        while (writer.next_chunk(&data, &len)) {
+            out.append(data, len);
+            chunks++;
+        }
+        EXPECT_EQ_TRUE(out == json);
+        EXPECT_EQ_TRUE(budget > 100 ? chunks == 1 : chunks > 5);
+        EXPECT_EQ_FALSE(writer.next_chunk(&data, &len));
+    }
+
+    /*NaN/Inf 不能写成 json*/
+    {
+        YdsValue bad;
+        EXPECT_EQ(YDS_PARSE_OK, json_parse.parse(&bad, "[1, [\"x\", 2]]"));
+        bad.get_array_element(1)->get_array_element(1)->set_number(NAN);
+        YdsAsyncWriter writer(&bad, 1);
+        const char* data;
+        size_t len;
+        while (writer.next_chunk(&data, &len))
+            ;
+        EXPECT_EQ_TRUE(writer.failed());
+        YdsAsyncWriter writer2(&bad);
+        EXPECT_EQ(YDS_ASYNC_ERROR, writer2.write_fd(-1));
+    }
+
+    /*读端没有读取时生成端停在 WANT_WRITE*/
+    std::string big(200000, 'x');
+    v.set_string(big.data(), big.size());
+    int fds[2];
+    EXPECT_EQ(0, pipe(fds));
+    fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+    YdsAsyncWriter writer(&v);
+    EXPECT_EQ(YDS_ASYNC_WANT_WRITE, writer.write_fd(fds[1]));
+    EXPECT_EQ_TRUE(writer.get_bytes_written() < big.size() + 2);
+    close(fds[0]);
+    signal(SIGPIPE, SIG_IGN);
+    EXPECT_EQ(YDS_ASYNC_IO_ERROR, writer.write_fd(fds[1]));
+    EXPECT_EQ(EPIPE, writer.get_errno());
+    close(fds[1]);
+}
+
+static void test_parse_columns() {
+    YdsJson json_parse;
+    YdsColumns cols;
+    size_t ts = cols.add("ts", YDS_COLUMN_INT64);
+    size_t v = cols.add("/data/v", YDS_COLUMN_DOUBLE);
+    size_t tag = cols.add("tag", YDS_COLUMN_STRING);
+    size_t ok = cols.add("/data/ok", YDS_COLUMN_BOOL);
+    size_t slash = cols.add("a/b", YDS_COLUMN_INT64);
+    EXPECT_EQ_TRUE(cols.find("/ts") == &cols[ts]);
+    EXPECT_EQ_TRUE(cols.find("/a~1b") == &cols[slash]);
+    EXPECT_EQ_TRUE(cols.find("/data") == nullptr);
+    /*相同的 pointer, 或者一个是另一个的前缀, 会让其中一列永远为空, 声明时拒绝*/
+    EXPECT_EQ_SIZE(YDS_COLUMN_INVALID, cols.add("/ts", YDS_COLUMN_DOUBLE));
+    EXPECT_EQ_SIZE(YDS_COLUMN_INVALID, cols.add("data", YDS_COLUMN_STRING));
+    EXPECT_EQ_SIZE(YDS_COLUMN_INVALID, cols.add("/ts/x", YDS_COLUMN_INT64));
+    EXPECT_EQ_SIZE(YDS_COLUMN_INVALID, cols.add("/a~1b/c", YDS_COLUMN_INT64));
+    EXPECT_EQ_SIZE(5, cols.size());
+    YdsColumns prefix;
+    EXPECT_EQ_SIZE(0, prefix.add("/a/b", YDS_COLUMN_INT64));
+    EXPECT_EQ_SIZE(YDS_COLUMN_INVALID, prefix.add("a", YDS_COLUMN_INT64));
+    EXPECT_EQ_SIZE(1, prefix.add("/ab", YDS_COLUMN_INT64));
+    EXPECT_EQ_SIZE(2, prefix.add("/a/bc", YDS_COLUMN_INT64));
+
+    const char* json = "[ {\"ts\":1, \"data\":{\"v\":0.5, \"ok\":true, \"x\":[1,{}]}, \"tag\":\"a\\n\"},"
+                       "  {\"tag\":null, \"ts\":-9223372036854775808, \"skip\":{\"v\":1}, \"data\":{\"v\":null}},"
+                       "  {\"a/b\":7, \"data\":3, \"tag\":\"\\u4e2d\", \"ts\":3, \"ts\":4},"
+                       "  {} ]";
+    EXPECT_EQ(YDS_PARSE_OK, json_parse.parse_columns(&cols, json));
+    EXPECT_EQ_SIZE(4, cols.get_row_count());
+    for (size_t i = 0; i < cols.size(); ++i)
+        EXPECT_EQ_SIZE(4, cols[i].size());
+
+    const int64_t* t = cols[ts].get_int64s();
+    EXPECT_EQ_TRUE(t[0] == 1 && t[1] == INT64_MIN && t[2] == 3);     /*重复的键只取第一个*/
+    EXPECT_EQ_TRUE(cols[ts].is_null(3));
+    EXPECT_EQ_SIZE(1, cols[ts].get_null_count());
+
+    EXPECT_EQ(0.5, cols[v].get_doubles()[0]);
+    EXPECT_EQ_TRUE(cols[v].is_null(1) && cols[v].is_null(2) && cols[v].is_null(3));
+    EXPECT_EQ(0.0, cols[v].get_doubles()[1]);
+    EXPECT_EQ_TRUE(cols[v].get_validity()[0] == 0x01);
+
+    size_t len;
+    const char* s = cols[tag].get_string(0, &len);
+    EXPECT_EQ_STRING("a\n", s, len);
+    EXPECT_EQ_TRUE(cols[tag].is_null(1));
+    s = cols[tag].get_string(2, &len);
+    EXPECT_EQ_STRING("\xE4\xB8\xAD", s, len);
+    EXPECT_EQ_SIZE(5, cols[tag].get_offsets()[4]);
+    EXPECT_EQ_STRING("a\n\xE4\xB8\xAD", cols[tag].get_string_data(), cols[tag].get_offsets()[4]);
+
+    EXPECT_EQ_TRUE(cols[ok].get_bools()[0] == 1);
+    EXPECT_EQ_SIZE(3, cols[ok].get_null_count());
+    EXPECT_EQ_TRUE(cols[slash].get_int64s()[2] == 7);
+
+    /*按 JSON Pointer 定位记录数组, 空数组得到 0 行*/
+    EXPECT_EQ(YDS_PARSE_OK, json_parse.parse_columns(&cols, "{\"rows\":[{\"ts\":5}],\"empty\":[]}", "/rows"));
+    EXPECT_EQ_SIZE(1, cols.get_row_count());
+    EXPECT_EQ_TRUE(cols[ts].get_int64s()[0] == 5);
+    EXPECT_EQ(YDS_PARSE_OK, json_parse.parse_columns(&cols, "{\"rows\":[{\"ts\":5}],\"empty\":[]}", "/empty"));
+    EXPECT_EQ_SIZE(0, cols.get_row_count());
+    EXPECT_EQ_SIZE(0, cols[tag].size());
+
+#define TEST_COLUMNS_ERROR(error, json, expect_offset, expect_path) \
+    do { \
+        EXPECT_EQ(error, json_parse.parse_columns(&cols, json)); \
+        EXPECT_EQ_SIZE(expect_offset, json_parse.get_error().offset); \
+        EXPECT_EQ_TRUE(json_parse.get_error().path == expect_path); \
+        EXPECT_EQ_SIZE(0, cols.get_row_count()); \
+        EXPECT_EQ_SIZE(0, cols[ts].size()); \
+    } while (0)
+
+    TEST_COLUMNS_ERROR(YDS_PARSE_TYPE_MISMATCH, "[{\"ts\":1},{\"ts\":1.5}]", 16, "/1/ts");
+    TEST_COLUMNS_ERROR(YDS_PARSE_TYPE_MISMATCH, "[{\"ts\":\"1\"}]", 7, "/0/ts");
+    TEST_COLUMNS_ERROR(YDS_PARSE_TYPE_MISMATCH, "[{\"data\":{\"ok\":0}}]", 15, "/0/data/ok");
+    TEST_COLUMNS_ERROR(YDS_PARSE_TYPE_MISMATCH, "[1]", 1, "/0");
+    TEST_COLUMNS_ERROR(YDS_PARSE_NUMBER_TOO_BIG, "[{\"ts\":9223372036854775808}]", 7, "/0/ts");
+    TEST_COLUMNS_ERROR(YDS_PARSE_INVALID_VALUE, "[{\"tag\":[tru]}]", 9, "/0/tag");
+    /*跳过的值只报告到所在的成员*/
+    TEST_COLUMNS_ERROR(YDS_PARSE_INVALID_VALUE, "[{\"x\":{\"y\":nul}}]", 11, "/0/x");
+    TEST_COLUMNS_ERROR(YDS_PARSE_INVALID_VALUE, "[{\"data\":{\"y\":nul}}]", 14, "/0/data/y");
+    TEST_COLUMNS_ERROR(YDS_PARSE_MISS_COLON, "[{\"ts\" 1}]", 7, "/0");
+    TEST_COLUMNS_ERROR(YDS_PARSE_MISS_COMMA_OR_CURLY_BRACKET, "[{\"ts\":1 \"v\":2}]", 9, "/0");
+    TEST_COLUMNS_ERROR(YDS_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, "[{} {}]", 4, "");
+#undef TEST_COLUMNS_ERROR
+}
+
 static void test_access() {
     test_access_null();
     test_access_boolean();
@@ -324,6 +1727,20 @@ static void test_access() {
 int main() {
     test_parse();
     test_access();
+    test_allocator();
+    test_short_string();
+    test_stack_buffer();
+    test_intern_keys();
+    test_clone_equals_hash();
+    test_parse_in_place();
+    test_parse_packed();
+    test_array_stream();
+    test_parse_columns();
+    test_parse_many();
+    test_parse_async();
+    test_write_async();
+    test_parse_source();
+    test_bind();
     std::cout << test_pass << "/" << test_count << " "
               << "(" << test_pass * 100.0 / test_count << "%) passed" 
               << std::endl;